@@ -0,0 +1,17 @@
+#include <benchmark/benchmark.h>
+
+#ifndef CARL_REVISION
+#define CARL_REVISION "unknown"
+#endif
+
+// benchmark_main, plus the revision measured in the results' context, so
+// JSON results of different versions can be told apart
+int main(int argc, char **argv) {
+    benchmark::AddCustomContext("carl_revision", CARL_REVISION);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
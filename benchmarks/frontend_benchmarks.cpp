@@ -0,0 +1,113 @@
+#include "lexer/char_scan.h"
+#include "lexer/lexer.h"
+#include "parser/expression.h"
+#include "parser/parallel_parser.h"
+#include "parser/parser.h"
+#include "parser/statement.h"
+#include "workloads.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void BM_Lex(benchmark::State &state) {
+    const std::string source = tokenStream(state.range(0));
+    for (auto _ : state) {
+        Lexer lexer{std::string_view{source}};
+        auto tokens = lexer.tokenize();
+        benchmark::DoNotOptimize(tokens);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_Lex)->RangeMultiplier(8)->Range(1 << 10, 1 << 22);
+
+// Lexing source made mostly of whitespace, comments and long tokens, with
+// their runs scanned at level range(0): scalar, SSE2 or AVX2
+static void BM_LexScanLevel(benchmark::State &state) {
+    const ScanLevel level = static_cast<ScanLevel>(state.range(0));
+    if (level > supportedScanLevel()) {
+        state.SkipWithError("Unsupported by this CPU");
+        return;
+    }
+    const ScanLevel previous = scanLevel();
+    setScanLevel(level);
+    const std::string source = documentedSource(1 << 22);
+    for (auto _ : state) {
+        Lexer lexer{std::string_view{source}};
+        auto tokens = lexer.tokenize();
+        benchmark::DoNotOptimize(tokens);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+    setScanLevel(previous);
+}
+BENCHMARK(BM_LexScanLevel)->DenseRange(0, 2);
+
+// Parsing alone, from tokens lexed up front
+static void runParser(benchmark::State &state, const std::string &source) {
+    Lexer lexer{std::string_view{source}};
+    const std::vector<Token> tokens = lexer.tokenize();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Token> copy = tokens;
+        state.ResumeTiming();
+
+        Parser parser{std::move(copy), source};
+        auto statements = parser.parse();
+        benchmark::DoNotOptimize(statements);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+    state.SetItemsProcessed(state.iterations() * tokens.size());
+}
+
+static void BM_Parse(benchmark::State &state) {
+    runParser(state, ruleProgram(state.range(0)));
+}
+BENCHMARK(BM_Parse)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_ParseDeep(benchmark::State &state) {
+    runParser(state, deepSource(state.range(0)) + ";");
+}
+BENCHMARK(BM_ParseDeep)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+static void BM_ParseWide(benchmark::State &state) {
+    runParser(state, wideSource(state.range(0)) + ";");
+}
+BENCHMARK(BM_ParseWide)->DenseRange(6, 18, 4);
+
+static void BM_LexAndParse(benchmark::State &state) {
+    const std::string source = ruleProgram(state.range(0));
+    for (auto _ : state) {
+        Lexer lexer{std::string_view{source}};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        auto statements = parser.parse();
+        benchmark::DoNotOptimize(statements);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_LexAndParse)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// A large rule file, parsed by range(0) threads
+static void BM_LexAndParseParallel(benchmark::State &state) {
+    const std::string source = ruleProgram(1 << 15);
+    ParallelParser parser{static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        auto statements = parser.parse(source);
+        benchmark::DoNotOptimize(statements);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_LexAndParseParallel)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+static void BM_PrintExpression(benchmark::State &state) {
+    const auto expression = leftDeepTree(state.range(0));
+    size_t bytes{0};
+    for (auto _ : state) {
+        std::string text = expression->toString();
+        bytes += text.size();
+        benchmark::DoNotOptimize(text);
+    }
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_PrintExpression)->RangeMultiplier(8)->Range(8, 1 << 18);
@@ -0,0 +1,138 @@
+#include "lexer/lexer.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "parser/parser.h"
+#include "parser/statement.h"
+#include "runtime/interpreter.h"
+#include "runtime/parse_cache.h"
+#include "workloads.h"
+
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void runEngine(benchmark::State &state, ExecutionMode mode,
+                      std::unique_ptr<Expression> tree) {
+    Interpreter interpreter(
+        std::make_unique<ExpressionStatement>(std::move(tree)));
+    interpreter.setExecutionMode(mode);
+
+    for (auto _ : state) {
+        auto result = interpreter.interpret();
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+static void BM_TreeWalkLeftDeep(benchmark::State &state) {
+    runEngine(state, EXECUTE_TREE_WALK, leftDeepTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TreeWalkLeftDeep)->RangeMultiplier(4)->Range(64, 16384);
+
+static void BM_BytecodeLeftDeep(benchmark::State &state) {
+    runEngine(state, EXECUTE_BYTECODE, leftDeepTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BytecodeLeftDeep)->RangeMultiplier(4)->Range(64, 16384);
+
+static void BM_FlatLeftDeep(benchmark::State &state) {
+    runEngine(state, EXECUTE_FLAT, leftDeepTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FlatLeftDeep)->RangeMultiplier(4)->Range(64, 16384);
+
+static void BM_TreeWalkBalanced(benchmark::State &state) {
+    runEngine(state, EXECUTE_TREE_WALK, balancedTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * (1 << state.range(0)));
+}
+BENCHMARK(BM_TreeWalkBalanced)->DenseRange(6, 14, 4);
+
+static void BM_BytecodeBalanced(benchmark::State &state) {
+    runEngine(state, EXECUTE_BYTECODE, balancedTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * (1 << state.range(0)));
+}
+BENCHMARK(BM_BytecodeBalanced)->DenseRange(6, 14, 4);
+
+static void BM_FlatBalanced(benchmark::State &state) {
+    runEngine(state, EXECUTE_FLAT, balancedTree(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * (1 << state.range(0)));
+}
+BENCHMARK(BM_FlatBalanced)->DenseRange(6, 14, 4);
+
+// Cost of the compile step alone, paid once per expression
+static void BM_BytecodeCompile(benchmark::State &state) {
+    auto tree = leftDeepTree(state.range(0));
+    Compiler compiler;
+    for (auto _ : state) {
+        Chunk chunk = compiler.compile(*tree);
+        benchmark::DoNotOptimize(chunk.code().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BytecodeCompile)->RangeMultiplier(4)->Range(64, 16384);
+
+// Compiling from the flat arrays instead of visiting the tree
+static void BM_FlatCompile(benchmark::State &state) {
+    auto tree = leftDeepTree(state.range(0));
+    FlatExpression flat{*tree};
+    Compiler compiler;
+    for (auto _ : state) {
+        Chunk chunk = compiler.compile(flat);
+        benchmark::DoNotOptimize(chunk.code().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FlatCompile)->RangeMultiplier(4)->Range(64, 16384);
+
+// Definitions and applications run statement by statement, as the REPL does.
+// Applications print their result, stdout is muted meanwhile.
+static void BM_InterpretProgram(benchmark::State &state) {
+    const std::string source = ruleProgram(state.range(0));
+    Lexer lexer{std::string_view{source}};
+    const std::vector<Token> tokens = lexer.tokenize();
+
+    std::streambuf *output = std::cout.rdbuf(nullptr);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Parser parser{tokens, source};
+        Interpreter interpreter;
+        auto statements = parser.parse();
+        state.ResumeTiming();
+
+        auto result = interpreter.interpret(std::move(statements));
+        benchmark::DoNotOptimize(result);
+    }
+    std::cout.rdbuf(output);
+    std::cout.clear();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_InterpretProgram)->RangeMultiplier(8)->Range(8, 1 << 12);
+
+// A few inputs arriving over and over, as in service mode, parsed through a
+// ParseCache of the given capacity: 0 parses every input again
+static void BM_InterpretRepeatedInput(benchmark::State &state) {
+    static const char *const inputs[] = {
+        "(12.5 + 3) * 4 - 7 / 2;",
+        "define twice -> \"A\" + \"A\" = 2 * \"A\";",
+        "apply twice : (1 + 2) + (1 + 2);",
+        "-(8 * (3 - 1)) + 100 / 5 * 2;",
+    };
+    ParseCache cache{static_cast<size_t>(state.range(0))};
+    Interpreter interpreter;
+
+    std::streambuf *output = std::cout.rdbuf(nullptr);
+    size_t input = 0;
+    for (auto _ : state) {
+        auto result = interpreter.interpret(cache.parse(inputs[input++ % std::size(inputs)]));
+        benchmark::DoNotOptimize(result);
+    }
+    std::cout.rdbuf(output);
+    std::cout.clear();
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_rate"] = cache.stats().hitRate();
+}
+BENCHMARK(BM_InterpretRepeatedInput)->Arg(0)->Arg(DEFAULT_PARSE_CACHE_CAPACITY);
@@ -0,0 +1,138 @@
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "runtime/batch_rewriter.h"
+#include "runtime/environment.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/rewrite_cache.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "workloads.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const Token plus(TokenType::PLUS, 0, 1, "+");
+static const Token star(TokenType::STAR, 0, 1, "*");
+
+static std::unique_ptr<Expression> number(std::string literal) {
+    return std::make_unique<LiteralExpression>(TokenType::NUMBER, literal);
+}
+
+static std::unique_ptr<Expression> variable(std::string name) {
+    return std::make_unique<LiteralExpression>(TokenType::STRING, name);
+}
+
+// (... (1 + 2) + 3 ...) * 2 with distinct leaves, so nothing is shared and
+// a rule for "A" * 1 has to look at every node before giving up
+static std::unique_ptr<Expression> source(int64_t terms) {
+    std::unique_ptr<Expression> tree = number("0");
+    for (int64_t i = 1; i < terms; i++)
+        tree = std::make_unique<BinaryExpression>(std::move(tree), plus,
+                                                  number(std::to_string(i)));
+    return std::make_unique<BinaryExpression>(std::move(tree), star, number("2"));
+}
+
+static std::unique_ptr<Expression> pattern() {
+    return std::make_unique<BinaryExpression>(variable("A"), star, number("1"));
+}
+
+static void BM_RewriteExpression(benchmark::State &state) {
+    auto tree = source(state.range(0));
+    ExpressionRewriter rewriter;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto copy = tree->clone();
+        state.ResumeTiming();
+
+        auto result = rewriter.substitute(std::move(copy), pattern(), variable("A"));
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RewriteExpression)->RangeMultiplier(4)->Range(64, 16384);
+
+static void BM_RewriteCompiledRule(benchmark::State &state) {
+    auto tree = source(state.range(0));
+    Rule rule{pattern(), variable("A")};
+    TermTable table;
+    const Term *term = table.intern(*tree);
+    ExpressionRewriter rewriter;
+
+    for (auto _ : state) {
+        auto result = rewriter.substitute(table, term, rule);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RewriteCompiledRule)->RangeMultiplier(4)->Range(64, 16384);
+
+// Many small independent expressions, split over range(0) threads
+static void BM_BatchNormalize(benchmark::State &state) {
+    Environment environment;
+    environment.addDefinition(
+        "one", std::make_unique<Rule>(pattern(), variable("A")));
+
+    std::vector<std::unique_ptr<Expression>> expressions;
+    for (int64_t i = 0; i < 4096; i++)
+        expressions.push_back(source(64 + i % 64));
+
+    BatchRewriter batch{environment, static_cast<size_t>(state.range(0))};
+    for (auto _ : state) {
+        auto results = batch.normalize(expressions);
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetItemsProcessed(state.iterations() * expressions.size());
+}
+BENCHMARK(BM_BatchNormalize)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// Distinct sources sharing one large subterm the rule doesn't match, with
+// the rewrite cache off (0) or on (1). Cached, only the new root is searched.
+static void BM_RewriteSharedSubterm(benchmark::State &state) {
+    auto tree = source(state.range(0));
+    Rule rule{pattern(), variable("A")};
+    TermTable table;
+    const Term *shared = table.intern(*tree);
+
+    std::vector<const Term *> roots;
+    for (int i = 0; i < 1024; i++)
+        roots.push_back(table.make(TokenType::PLUS, internSymbol("+"), shared,
+                                   table.make(TokenType::NUMBER, std::to_string(i))));
+
+    RewriteCache cache;
+    ExpressionRewriter rewriter;
+    if (state.range(1))
+        rewriter.setCache(&cache);
+
+    size_t next = 0;
+    for (auto _ : state) {
+        auto result = rewriter.substitute(table, roots[next++ % roots.size()], rule);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RewriteSharedSubterm)
+    ->ArgsProduct({benchmark::CreateRange(64, 16384, 16), {0, 1}});
+
+// Normalizing against range(0) rules found through the environment's rule
+// index, so the cost per node should stay flat as rules are added
+static void BM_NormalizeRuleSet(benchmark::State &state) {
+    Environment environment;
+    for (auto &[name, rule] : ruleSet(state.range(0)))
+        environment.addDefinition(name, std::move(rule));
+    auto tree = ruleSetSource(1024, state.range(0));
+
+    std::shared_ptr<const RuleSet> rules = environment.snapshot();
+    ExpressionRewriter rewriter;
+    for (auto _ : state) {
+        TermTable table;
+        NormalizeResult result = rewriter.normalize(
+            table, table.intern(*tree), rules->ruleIndex(), DEFAULT_REWRITE_BUDGET);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_NormalizeRuleSet)->RangeMultiplier(8)->Range(1, 4096);
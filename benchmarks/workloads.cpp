@@ -0,0 +1,124 @@
+#include "workloads.h"
+#include "lexer/token.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const Token operators[] = {
+    Token(TokenType::PLUS, 0, 1, "+"),
+    Token(TokenType::STAR, 0, 1, "*"),
+    Token(TokenType::MINUS, 0, 1, "-"),
+    Token(TokenType::SLASH, 0, 1, "/"),
+};
+
+static std::unique_ptr<Expression> number(int64_t value) {
+    return std::make_unique<LiteralExpression>(TokenType::NUMBER,
+                                               std::to_string(value));
+}
+
+std::string ruleProgram(int64_t statements) {
+    std::string source;
+    for (int64_t i = 0; i < statements; i++) {
+        // Each application uses the rule defined just before it
+        const std::string name = std::string{"rule_"} + char('a' + i / 2 % 26);
+        if (i % 2 == 0)
+            source += "define " + name + " -> \"A\" + " + std::to_string(i) +
+                      " = \"A\" * (" + std::to_string(i) + " - 1);\n";
+        else
+            source += "apply " + name + " : (" + std::to_string(i) +
+                      " + 2) * -3 / 4.5;\n";
+    }
+    return source;
+}
+
+std::string tokenStream(size_t bytes) {
+    static const char *const statements[] = {
+        "define scale -> \"A\" * 1 = \"A\";\n",
+        "apply scale : (12.5 + 3) * 1 >= -7 / 2;\n",
+        "apply* : !(1 == 2) != (3 <= 4);\n",
+        "# comments are skipped by the lexer\n",
+        "show \"strings\" + \"concatenate\";\n",
+        "1024 - 512 * (256 / 128) < 64.125;\n",
+    };
+
+    std::string source;
+    source.reserve(bytes + 64);
+    for (size_t i = 0; source.size() < bytes; i++)
+        source += statements[i % std::size(statements)];
+    return source;
+}
+
+std::string documentedSource(size_t bytes) {
+    static const char *const lines[] = {
+        "    # Identity of the product, kept around so later rules can assume it\n",
+        "    define multiplicative_identity -> \"left operand\" * 1 = \"left operand\";\n",
+        "    apply multiplicative_identity : 1234567890.0987654321 * 1;\n",
+        "\n",
+    };
+
+    std::string source;
+    source.reserve(bytes + 128);
+    for (size_t i = 0; source.size() < bytes; i++)
+        source += lines[i % std::size(lines)];
+    return source;
+}
+
+std::string deepSource(int64_t terms) {
+    std::string source = "1";
+    for (int64_t i = 1; i < terms; i++)
+        source += (i % 2 ? " + " : " - ") + std::to_string(i % 9 + 1);
+    return source;
+}
+
+std::string wideSource(int64_t depth) {
+    if (depth == 0)
+        return "2";
+    const std::string half = wideSource(depth - 1);
+    return "(" + half + (depth % 2 ? " + " : " * ") + half + ")";
+}
+
+std::unique_ptr<Expression> leftDeepTree(int64_t terms) {
+    std::unique_ptr<Expression> tree = number(1);
+    for (int64_t i = 1; i < terms; i++)
+        tree = std::make_unique<BinaryExpression>(
+            std::move(tree), operators[i % 4], number(i % 9 + 1));
+    return tree;
+}
+
+std::unique_ptr<Expression> balancedTree(int64_t depth) {
+    if (depth == 0)
+        return number(2);
+    return std::make_unique<BinaryExpression>(balancedTree(depth - 1),
+                                              operators[depth % 4],
+                                              balancedTree(depth - 1));
+}
+
+std::vector<std::pair<std::string, std::unique_ptr<Rule>>> ruleSet(int64_t count) {
+    std::vector<std::pair<std::string, std::unique_ptr<Rule>>> rules;
+    for (int64_t k = 2; k < count + 2; k++) {
+        auto pattern = std::make_unique<BinaryExpression>(
+            std::make_unique<LiteralExpression>(TokenType::STRING, "A"),
+            operators[1], number(k));
+        auto replacement = std::make_unique<LiteralExpression>(TokenType::STRING, "A");
+        rules.emplace_back("times_" + std::to_string(k),
+                           std::make_unique<Rule>(std::move(pattern), std::move(replacement)));
+    }
+    return rules;
+}
+
+std::unique_ptr<Expression> ruleSetSource(int64_t terms, int64_t count) {
+    auto product = [count](int64_t i) {
+        // Every other product has no rule
+        return std::make_unique<BinaryExpression>(number(i), operators[1],
+                                                  number(2 + i % (2 * count)));
+    };
+
+    std::unique_ptr<Expression> tree = product(0);
+    for (int64_t i = 1; i < terms; i++)
+        tree = std::make_unique<BinaryExpression>(std::move(tree), operators[0],
+                                                  product(i));
+    return tree;
+}
@@ -0,0 +1,44 @@
+#ifndef WORKLOADS_H
+#define WORKLOADS_H
+
+#include "parser/expression.h"
+#include "runtime/rule.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Synthetic inputs shared by the benchmarks. All of them are deterministic,
+// so results of different versions measure the same work.
+
+// Rule definitions alternating with applications of them, about 60 bytes
+// per statement
+std::string ruleProgram(int64_t statements);
+
+// At least bytes of source mixing every token kind: keywords, numbers with
+// and without fractions, strings, all operators, brackets and comments
+std::string tokenStream(size_t bytes);
+// At least bytes of indented, commented source with long names, literals
+// and numbers, where most characters are in runs rather than short tokens
+std::string documentedSource(size_t bytes);
+
+// 1 + 2 - 3 + ..., nested to the left so depth == terms
+std::string deepSource(int64_t terms);
+// ((2 + 2) * (2 + 2)) ..., a complete bracketed tree with 2^depth leaves
+std::string wideSource(int64_t depth);
+
+// The same shapes built directly, without lexing and parsing
+std::unique_ptr<Expression> leftDeepTree(int64_t terms);
+std::unique_ptr<Expression> balancedTree(int64_t depth);
+
+// count rules "A" * k -> "A", for k = 2 .. count + 1, each with its own
+// name, so a rule index tells them apart by their number alone
+std::vector<std::pair<std::string, std::unique_ptr<Rule>>> ruleSet(int64_t count);
+// A left-deep sum of terms products x * k, with k cycling through the
+// numbers ruleSet(count) rewrites and ones no rule matches
+std::unique_ptr<Expression> ruleSetSource(int64_t terms, int64_t count);
+
+#endif
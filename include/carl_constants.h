@@ -17,6 +17,14 @@ enum ParserError {
 enum RuntimeError {
     TYPE_MISMATCH = 1000,
     NO_RULE_FOUND = 1001,
+    REWRITE_LIMIT_EXCEEDED = 1002,
+    TOO_MANY_CONSTANTS = 1003,
+    INTERNAL_ERROR = 1004,
+};
+
+enum LibraryError {
+    UNREADABLE_LIBRARY = 2000,
+    INVALID_LIBRARY = 2001,
 };
 
 #endif
@@ -0,0 +1,154 @@
+#ifndef CARL_STATS_H
+#define CARL_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Counters and timers for the hot paths, printed by `carl --stats`.
+//
+// They only exist when built with CARL_STATS defined (the CARL_STATS CMake
+// option). Otherwise the CARL_STAT_* macros expand to nothing and the hot
+// paths are exactly as without them.
+//
+// Every thread updates its own block of counters, so counting is a plain
+// increment with no contention; Stats::snapshot() sums the blocks of all
+// threads, including those that already exited. Nothing is recorded until
+// Stats::setEnabled(true), before that a counter costs a load and a branch.
+
+enum StatCounter {
+    STAT_TOKENS,              // Tokens produced by Lexer::tokenize
+    STAT_SYMBOL_INTERNS,      // SymbolTable::intern calls, each taking its lock
+    STAT_STATEMENTS,          // Statements produced by Parser::parse
+    STAT_VISIT_LITERAL,       // Interpreter::visitLiteralExpression
+    STAT_VISIT_UNARY,         // Interpreter::visitUnaryExpression
+    STAT_VISIT_BINARY,        // Interpreter::visitBinaryExpression
+    STAT_RULE_TRIES,          // Rules tried on a subterm while rewriting terms
+    STAT_RULE_REWRITES,       // ... of which rewrote it, cached or matched
+    STAT_MATCH_ATTEMPTS,      // PatternMatcher::match calls
+    STAT_MATCH_HITS,          // ... of which matched
+    STAT_CLONED_NODES,        // Nodes copied by Expression::clone
+    STAT_STRING_ALLOCATIONS,  // ObjString::create calls
+    STAT_PARSE_CACHE_HITS,    // Sources ParseCache didn't parse again
+    STAT_PARSE_CACHE_MISSES,  // ... and those it parsed
+    STAT_COUNTER_COUNT,
+};
+
+enum StatTimer {
+    STAT_LEX,                 // Lexer::tokenize
+    STAT_PARSE,               // Parser::parse
+    STAT_VISIT_EXPRESSION,    // Interpreter::visitExpressionStatement
+    STAT_VISIT_DEFINE,        // Interpreter::visitDefineStatement
+    STAT_VISIT_APPLY,         // Interpreter::visitApplyStatement
+    STAT_VISIT_NORMALIZE,     // Interpreter::visitNormalizeStatement
+    STAT_VISIT_SHOW,          // Interpreter::visitShowStatement
+    STAT_TIMER_COUNT,
+};
+
+// Names used in the table and the JSON output
+extern const std::string_view StatCounterNames[STAT_COUNTER_COUNT];
+extern const std::string_view StatTimerNames[STAT_TIMER_COUNT];
+
+class Stats {
+public:
+    struct Snapshot {
+        uint64_t counters[STAT_COUNTER_COUNT]{};
+        uint64_t calls[STAT_TIMER_COUNT]{};
+        uint64_t nanoseconds[STAT_TIMER_COUNT]{};
+    };
+
+private:
+    // One per thread. Only its own thread writes it, the atomics are for
+    // snapshot() reading it concurrently and compile to plain moves.
+    struct Block {
+        std::atomic<uint64_t> counters[STAT_COUNTER_COUNT]{};
+        std::atomic<uint64_t> calls[STAT_TIMER_COUNT]{};
+        std::atomic<uint64_t> nanoseconds[STAT_TIMER_COUNT]{};
+
+        Block();
+        ~Block();
+    };
+
+    static std::atomic<bool> enabled_;
+
+    static Block &local() {
+        static thread_local Block block;
+        return block;
+    }
+
+    static void add(std::atomic<uint64_t> &statistic, uint64_t n) {
+        statistic.store(statistic.load(std::memory_order_relaxed) + n,
+                        std::memory_order_relaxed);
+    }
+
+public:
+    static constexpr bool compiledIn() {
+#ifdef CARL_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static void count(StatCounter counter, uint64_t n = 1) {
+        if (enabled())
+            add(local().counters[counter], n);
+    }
+    static void time(StatTimer timer, uint64_t nanoseconds) {
+        Block &block = local();
+        add(block.calls[timer], 1);
+        add(block.nanoseconds[timer], nanoseconds);
+    }
+
+    // Totals of all threads so far
+    static Snapshot snapshot();
+    static void reset();
+
+    static void printTable(std::ostream &out, const Snapshot &snapshot);
+    static void printJson(std::ostream &out, const Snapshot &snapshot);
+};
+
+// Adds the time until the end of the scope to a timer
+class StatTimerScope {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    StatTimer timer;
+    bool running;
+    Clock::time_point start;
+
+public:
+    explicit StatTimerScope(StatTimer timer_)
+        : timer{timer_}, running{Stats::enabled()} {
+        if (running)
+            start = Clock::now();
+    }
+    ~StatTimerScope() {
+        if (running)
+            Stats::time(timer, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   Clock::now() - start).count());
+    }
+    StatTimerScope(const StatTimerScope &) = delete;
+    StatTimerScope &operator=(const StatTimerScope &) = delete;
+};
+
+#define CARL_STAT_CONCAT_(a, b) a##b
+#define CARL_STAT_CONCAT(a, b) CARL_STAT_CONCAT_(a, b)
+
+#ifdef CARL_STATS
+#define CARL_STAT_COUNT(counter) ::Stats::count(counter)
+#define CARL_STAT_ADD(counter, n) ::Stats::count(counter, n)
+#define CARL_STAT_TIME(timer)                                                  \
+    StatTimerScope CARL_STAT_CONCAT(statTimer_, __LINE__) { timer }
+#else
+#define CARL_STAT_COUNT(counter) ((void)0)
+#define CARL_STAT_ADD(counter, n) ((void)0)
+#define CARL_STAT_TIME(timer) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CHAR_SCAN_H
+#define CHAR_SCAN_H
+
+#include <cstddef>
+#include <string_view>
+
+// Scans over runs of characters for the lexer, 16 or 32 at a time.
+//
+// Each function returns the index of the first character at or after from
+// that doesn't belong to the run, or text.size() if the run reaches the end.
+// The character classes are the lexer's, ASCII only and independent of the
+// locale. Which implementation runs is picked once, from what the CPU
+// supports; all of them give the same results.
+
+enum class ScanLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+inline bool isWhitespaceCharacter(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+inline bool isDigitCharacter(char c) { return static_cast<unsigned char>(c - '0') <= 9; }
+// Letters, '_' and '-'
+inline bool isIdentifierCharacter(char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') <= 'z' - 'a' || c == '_' || c == '-';
+}
+
+// The vectorized part of the skip functions below
+size_t scanWhitespace(std::string_view text, size_t from);
+size_t scanDigits(std::string_view text, size_t from);
+size_t scanIdentifier(std::string_view text, size_t from);
+
+// Most runs end after a character or two, those are checked inline before
+// reaching for vectors
+inline size_t skipWhitespace(std::string_view text, size_t from) {
+    if (from >= text.size() || !isWhitespaceCharacter(text[from]))
+        return from;
+    return scanWhitespace(text, from + 1);
+}
+inline size_t skipDigits(std::string_view text, size_t from) {
+    if (from >= text.size() || !isDigitCharacter(text[from]))
+        return from;
+    return scanDigits(text, from + 1);
+}
+inline size_t skipIdentifier(std::string_view text, size_t from) {
+    if (from >= text.size() || !isIdentifierCharacter(text[from]))
+        return from;
+    return scanIdentifier(text, from + 1);
+}
+
+// Index of the next c, through memchr, which the C library vectorizes
+size_t findCharacter(std::string_view text, size_t from, char c);
+
+// The best level this CPU supports
+ScanLevel supportedScanLevel();
+ScanLevel scanLevel();
+// Uses level, if supported, from now on, for comparing implementations.
+// Not safe while other threads are lexing.
+void setScanLevel(ScanLevel level);
+
+#endif
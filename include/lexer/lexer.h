@@ -4,10 +4,11 @@
 #include "token.h"
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
-static inline const std::unordered_map<std::string, TokenType> keywords{
+static inline const std::unordered_map<std::string_view, TokenType> keywords{
     {"not", TokenType::NOT},     {"and", TokenType::AND},
     {"or", TokenType::OR},       {"if", TokenType::IF},
     {"else", TokenType::ELSE},   {"while", TokenType::WHILE},
@@ -18,15 +19,40 @@ static inline const std::unordered_map<std::string, TokenType> keywords{
 
 class Lexer {
 public:
-    Lexer(std::string source);
+    // Borrows source, which must outlive the lexer. Sources are limited to
+    // 4 GiB, larger ones throw std::length_error.
+    Lexer(std::string_view source);
+    Lexer(const char *source) : Lexer(std::string_view{source}) {}
+    // Lexes only the characters from begin up to end, with token offsets
+    // and errors still relative to the whole source
+    Lexer(std::string_view source, uint32_t begin, uint32_t end);
+    // Takes ownership of a temporary source
+    Lexer(std::string &&source);
+    Lexer(const Lexer &) = delete;
+    Lexer &operator=(const Lexer &) = delete;
+
     std::vector<Token> tokenize();
-    static std::string tokensToString(const std::vector<Token>& tokens);
+    // The whole source, tokens' offsets and text() are relative to it
+    std::string_view text() const { return source; }
+    static std::string tokensToString(const std::vector<Token>& tokens,
+                                      std::string_view source);
 
 private:
-    const std::string source;
+    const std::string ownedSource;
+    const std::string_view source;
+
+    uint32_t start{0};
+    uint32_t currentCharacterIndex{0};
+    // Identifiers this lexer has interned, so the global symbol table and
+    // its lock, which the lexers of a ParallelParser share, are only used
+    // once per distinct name rather than once per occurrence
+    std::unordered_map<std::string_view, SymbolId> identifiers;
 
-    uint16_t start{0};
-    uint16_t currentCharacterIndex{0};
+    // Token from start to the current character. Symbols for fixed
+    // spellings are looked up once and identifiers are interned straight
+    // from the source, literals are left in it.
+    Token makeToken(TokenType type);
+    SymbolId internIdentifier(std::string_view name);
 
     bool isAlpha(char c) const;
     bool isAtEndOfFile() const;
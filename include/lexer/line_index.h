@@ -0,0 +1,38 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Positions of every line break in a source, built in one pass so offsets
+// can be turned into line and column with a binary search instead of
+// rescanning the source for each error.
+//
+// Lines count from 0. The column is the distance from the preceding line
+// break, or from the start of the source on the first line.
+class LineIndex {
+private:
+    std::vector<uint32_t> lineBreaks;
+    uint32_t sourceSize;
+    uint32_t firstLine{0};
+    uint32_t firstColumn{0};
+
+public:
+    explicit LineIndex(std::string_view source);
+    // For a piece of a larger source that starts at firstLine:firstColumn,
+    // so locations are reported relative to the whole source
+    LineIndex(std::string_view source, uint32_t firstLine, uint32_t firstColumn);
+
+    // {line, column} of offset, which may be one past the end of the source
+    std::pair<uint32_t, uint32_t> locate(uint32_t offset) const;
+    // "line:column - line:column" for a range of the source
+    std::string describe(uint32_t offset, uint32_t length) const;
+
+    size_t lineCount() const { return lineBreaks.size() + 1; }
+};
+
+#endif
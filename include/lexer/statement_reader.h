@@ -0,0 +1,61 @@
+#ifndef STATEMENT_READER_H
+#define STATEMENT_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Splits a stream into ';' terminated statements without reading all of it.
+//
+// Input is read in fixed size chunks and only the statement being assembled
+// is kept in memory, so arbitrarily large inputs run in constant memory and
+// the first statement is available as soon as it has been read. A ';' inside
+// a string literal or a '#' comment does not end a statement, matching the
+// lexer.
+class StatementReader {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit StatementReader(std::istream &input,
+                             size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    // Next statement including its ';', or nothing at the end of the input.
+    // Trailing text without a ';' is returned as a last statement unless it
+    // is only whitespace and comments, so the parser can report it. The view
+    // is valid until the next call.
+    std::optional<std::string_view> next();
+
+    // Where the statement returned by the last next() starts in the input
+    uint64_t offset() const { return statementOffset; }
+    // Line and column it starts at, counted like LineIndex does
+    uint32_t line() const { return statementLine; }
+    uint32_t column() const { return statementColumn; }
+
+private:
+    std::istream &input;
+    const size_t chunkSize;
+
+    std::string buffer;
+    size_t begin{0};   // Start of the next statement in buffer
+    size_t scanned{0}; // Everything before this has been scanned
+    bool inString{false};
+    bool inComment{false};
+    bool blank{true}; // Nothing but whitespace and comments since begin
+
+    uint64_t bufferOffset{0}; // Offset of buffer[0] in the input
+    uint32_t linesScanned{0};
+    uint64_t lastLineBreak{0}; // Offset in the input
+    uint32_t linesAtBegin{0};
+    uint32_t columnAtBegin{0};
+    uint64_t statementOffset{0};
+    uint32_t statementLine{0};
+    uint32_t statementColumn{0};
+
+    bool fill();
+    std::string_view take(size_t end);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interned string, equal ids mean equal text
+enum class SymbolId : uint32_t {};
+
+// Process wide intern table for identifiers, rule names and operator
+// spellings.
+//
+// Every distinct text is stored once and identified by a small integer, so
+// comparing and hashing symbols never touches the characters. Symbols are
+// never removed, which keeps ids and names valid for the lifetime of the
+// program, so number and string literals, of which a program can have any
+// amount, are kept out of it. Safe to use from several threads.
+class SymbolTable {
+private:
+    // Names are stored in chunks that double in size and never move, chunk k
+    // holding FIRST_CHUNK_SIZE << k names. Looking up the name of an id
+    // therefore needs no lock, only interning does.
+    static constexpr unsigned FIRST_CHUNK_BITS = 10;
+    static constexpr uint64_t FIRST_CHUNK_SIZE = uint64_t{1} << FIRST_CHUNK_BITS;
+    // Enough for every 32 bit id
+    static constexpr size_t CHUNKS = 33 - FIRST_CHUNK_BITS;
+
+    mutable std::shared_mutex mutex;
+    std::atomic<std::string *> chunks[CHUNKS]{};
+    uint64_t size_{0}; // Guarded by mutex
+    std::unordered_map<std::string_view, SymbolId> ids;
+
+public:
+    SymbolTable();
+    ~SymbolTable();
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    static SymbolTable &global();
+
+    SymbolId intern(std::string_view text);
+    // id must come from intern() of this table
+    const std::string &name(SymbolId id) const {
+        const uint64_t slot = static_cast<uint32_t>(id) + FIRST_CHUNK_SIZE;
+        const size_t chunk = std::bit_width(slot) - 1 - FIRST_CHUNK_BITS;
+        return chunks[chunk].load(std::memory_order_acquire)[slot - (FIRST_CHUNK_SIZE << chunk)];
+    }
+    size_t size() const;
+};
+
+inline SymbolId internSymbol(std::string_view text) {
+    return SymbolTable::global().intern(text);
+}
+
+inline const std::string &symbolName(SymbolId id) {
+    return SymbolTable::global().name(id);
+}
+
+#endif
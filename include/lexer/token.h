@@ -1,9 +1,12 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include "lexer/symbol_table.h"
+
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 static std::string TokenTypesToString[] = {
     "String",
@@ -51,7 +54,7 @@ static std::string TokenTypesToString[] = {
     "End Of File"
 };
 
-enum TokenType {
+enum TokenType : uint8_t {
     STRING, // "stuff enclosed in quotes"
     NUMBER, // numbers
 
@@ -103,24 +106,50 @@ enum TokenType {
     END_OF_FILE
 };
 
+// Trivially copyable: a token is its type, where it is in the source and the
+// interned text it stands for, it never owns any memory. Number and string
+// literals lexed from a source aren't interned, their text is read back from
+// the source with text().
 class Token {
 private:
-    const TokenType _type;
-    const uint16_t _sourceOffset;
-    const uint8_t _length;
-    const std::string _literal;
+    TokenType _type;
+    uint32_t _sourceOffset;
+    uint32_t _length;
+    SymbolId _literal;
 
 public:
-    Token(TokenType type, uint16_t sourceOffset, uint8_t length,
-          std::string literal)
+    Token(TokenType type, uint32_t sourceOffset, uint32_t length,
+          SymbolId literal)
         : _type(type), _sourceOffset(sourceOffset), _length(length),
           _literal(literal) {}
-
-    const TokenType type() const { return _type; }
-    const uint16_t sourceOffset() const { return _sourceOffset; }
-    const uint8_t length() const { return _length; }
-    const uint16_t sourceEnd() const { return _sourceOffset + _length; }
-    const std::string literal() const { return _literal; }
+    Token(TokenType type, uint32_t sourceOffset, uint32_t length,
+          std::string_view literal)
+        : Token(type, sourceOffset, length, internSymbol(literal)) {}
+
+    TokenType type() const { return _type; }
+    uint32_t sourceOffset() const { return _sourceOffset; }
+    uint32_t length() const { return _length; }
+    uint32_t sourceEnd() const { return _sourceOffset + _length; }
+    SymbolId symbol() const { return _literal; }
+    // The interned text, empty for literals that were left in the source
+    const std::string &literal() const { return symbolName(_literal); }
+    // The token's text as written in the source it was lexed from
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(_sourceOffset, _length);
+    }
+    // The text the token stands for: the interned one, or for literals left
+    // in the source their lexeme without the quotes of strings
+    std::string_view text(std::string_view source) const {
+        if (_literal != SymbolId{} || (_type != STRING && _type != NUMBER))
+            return literal();
+        if (_type == STRING)
+            return source.substr(_sourceOffset + 1, _length - 2);
+        return lexeme(source);
+    }
 };
 
+static_assert(std::is_trivially_copyable_v<Token>);
+// Four tokens to a cache line
+static_assert(sizeof(Token) == 16);
+
 #endif
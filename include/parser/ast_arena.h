@@ -0,0 +1,70 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator backing Expression nodes.
+//
+// While an AstArena::Scope is alive, every Expression allocated on that
+// thread is carved out of the scope's arena instead of coming from the global
+// heap. Deleting an arena node does not free anything by itself, it only
+// decrements the arena's live node count. Once the scope has ended and the last
+// of its nodes is deleted, all blocks are released in one go, so nodes stay
+// valid no matter where their unique_ptrs are moved to.
+//
+// An arena and its nodes must only be used by one thread at a time.
+class AstArena {
+public:
+    class Scope {
+    private:
+        AstArena *arena;
+        AstArena *previous;
+
+    public:
+        // sizeHint is the expected number of bytes, used to size the first
+        // block
+        explicit Scope(size_t sizeHint = 0);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        const AstArena &get() const { return *arena; }
+    };
+
+    static void *allocate(size_t size);
+    static void deallocate(void *pointer) noexcept;
+
+    // Arena the calling thread currently allocates from, if any
+    static AstArena *current() { return current_; }
+    // Number of arenas not yet released, across all threads
+    static size_t liveArenas();
+
+    size_t liveNodes() const { return liveNodes_; }
+    size_t bytesReserved() const { return bytesReserved_; }
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    static constexpr size_t MIN_BLOCK_SIZE = 4 * 1024;
+    static constexpr size_t MAX_BLOCK_SIZE = 256 * 1024;
+
+    static thread_local AstArena *current_;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::byte *cursor{nullptr};
+    std::byte *limit{nullptr};
+    size_t nextBlockSize;
+    size_t bytesReserved_{0};
+    size_t liveNodes_{0};
+    bool scoped{true};
+
+    explicit AstArena(size_t sizeHint);
+    ~AstArena();
+
+    void *bumpAllocate(size_t size);
+    void addBlock(size_t minimumSize);
+    void releaseIfUnused();
+};
+
+#endif
@@ -1,20 +1,23 @@
 #ifndef AST_PRINTER_H
 #define AST_PRINTER_H
 
-#include "parser/iexpression_visitor.h"
+#include "parser/expression.h"
+#include "parser/tree_printer.h"
 
-#include <stack>
 #include <string>
 
-class AstPrinter : public IExpressionVisitor {
-private:
-    std::stack<std::string> workingStack;
-
+// Prints expressions fully bracketed and spaced, e.g. (1 + (2 * 3)), in one
+// pass over the tree
+class AstPrinter {
 public:
-    std::string print(Expression &expression);
-    void visitLiteralExpression(LiteralExpression &expression) override;
-    void visitBinaryExpression(BinaryExpression &expression) override;
-    void visitUnaryExpression(UnaryExpression &expression) override;
+    std::string print(const Expression &expression);
+
+    // Writes to out, any output iterator over char, without building a
+    // string
+    template <typename OutputIt>
+    OutputIt print(const Expression &expression, OutputIt out) {
+        return printTree(expression, out, PRINT_SPACED);
+    }
 };
 
 #endif
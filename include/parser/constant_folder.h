@@ -0,0 +1,50 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include "parser/expression.h"
+#include "parser/iexpression_visitor.h"
+#include "parser/istatement_visitor.h"
+#include "parser/statement.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Replaces numeric subtrees by their value, e.g. (2 * 3) + "x" becomes
+// 6 + "x", so they aren't evaluated or rewritten over and over.
+//
+// Only arithmetic that can't fail is folded: +, -, * and / on numbers with a
+// finite result. Every operator that might still raise a TypeMismatch keeps
+// its token, and with it the error location. Negative results are written as
+// a negated literal, the same shape the parser produces for -6, so rules
+// match folded and unfolded numbers alike.
+class ConstantFolder : public IStatementVisitor, IExpressionVisitor {
+private:
+    // One entry per visited node whose parent wasn't visited yet: what to
+    // put in its place, or nullptr if it didn't fold. Nodes are visited by
+    // walkPostOrder, so a node's operands are the top entries.
+    std::vector<std::unique_ptr<Expression>> folded;
+    size_t foldedNodes_{0};
+
+    std::unique_ptr<Expression> takeFolded();
+
+public:
+    std::unique_ptr<Expression> fold(std::unique_ptr<Expression> expression);
+    // Folds the expressions of statement in place. Show statements are left
+    // as written.
+    void fold(Statement &statement);
+
+    // Operators folded away so far
+    size_t foldedNodes() const { return foldedNodes_; }
+
+    virtual void visitExpressionStatement(ExpressionStatement &statement) override;
+    virtual void visitDefineStatement(DefineStatement &statement) override;
+    virtual void visitApplyStatement(ApplyStatement &statement) override;
+    virtual void visitNormalizeStatement(NormalizeStatement &statement) override;
+    virtual void visitShowStatement(ShowStatement &statement) override;
+    virtual void visitLiteralExpression(LiteralExpression &expression) override;
+    virtual void visitBinaryExpression(BinaryExpression &expression) override;
+    virtual void visitUnaryExpression(UnaryExpression &expression) override;
+};
+
+#endif
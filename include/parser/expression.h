@@ -2,13 +2,20 @@
 #define EXPRESSION_H
 
 #include "lexer/token.h"
+#include "parser/ast_arena.h"
 #include "parser/iexpression_visitor.h"
+#include "parser/structural_hash.h"
+#include "parser/tree_printer.h"
 
 #include <algorithm>
+#include <cassert>
 #include <exception>
 #include <fmt/core.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 enum ExpressionType {
     // Literals
@@ -40,23 +47,80 @@ static const char * expressionTypeToString[] = {
 };
 
 class Expression {
+    protected:
+        // Structural, from the node's symbol and its children's hashes. The
+        // same as the hash of the term the expression interns to.
+        mutable size_t hash_{0};
+        // Set on a node and all its ancestors when a descendant was replaced,
+        // hash_ is recomputed on the next hash()
+        mutable bool hashStale_{false};
+
+        virtual size_t computeHash() const = 0;
+        // After a child was replaced. Stops at the first ancestor already
+        // marked, so replacing every node of a tree costs linear time.
+        void invalidateHash() {
+            for (Expression* node = this; node != nullptr && !node->hashStale_; node = node->parent)
+                node->hashStale_ = true;
+        }
+        // Recomputes the stale hashes of this subtree, children first
+        void refreshHash() const;
+
+        // Moves the children of this node onto out, leaving it childless
+        virtual void releaseChildren(std::vector<std::unique_ptr<Expression>>& out) = 0;
+        // Destroys the children without recursing, for node destructors
+        void destroyChildren();
+
     public:
         Expression* parent{nullptr};
+        virtual ~Expression() = default;
+
+        // Operands, left to right. child() requires index < arity().
+        virtual size_t arity() const = 0;
+        virtual const Expression& child(size_t index) const = 0;
+        Expression& child(size_t index) {
+            return const_cast<Expression&>(std::as_const(*this).child(index));
+        }
+
+        size_t hash() const {
+            if (hashStale_)
+                refreshHash();
+            return hash_;
+        }
+        // Deep structural equality, answered by the hashes alone whenever
+        // they differ
+        bool operator==(const Expression& other) const;
+
+        // Nodes come from the thread's active AstArena::Scope, if any
+        static void* operator new(size_t size) { return AstArena::allocate(size); }
+        static void operator delete(void* pointer) noexcept { AstArena::deallocate(pointer); }
+
         virtual ExpressionType expressionType() const = 0;
         virtual void accept(IExpressionVisitor& visitor) = 0;
-        virtual std::string toString() const = 0;
-        virtual std::unique_ptr<Expression> clone() const = 0;
+
+        // The literal as written, or the operator
+        virtual std::string_view spelling() const = 0;
+
+        // Fully bracketed and unspaced, e.g. (1+(2*3)). See printTree() to
+        // print without building a string.
+        std::string toString() const;
+        // Iterative, trees can be deeper than the stack
+        std::unique_ptr<Expression> clone() const;
 };
 
 // Concrete expressions
 class LiteralExpression : public Expression {
     private:
         const TokenType literalType_; // Can be NUMBER, STRING, TRUE, FALSE, NULL
+        // Owned rather than interned, so the literals of statements that are
+        // done with are freed along with them
         const std::string literal_;
 
     public:
-        LiteralExpression(TokenType literalType, std::string literal)
-            : literalType_(literalType), literal_(std::move(literal)) {}
+        using Expression::child;
+        LiteralExpression(TokenType literalType, std::string_view literal)
+            : literalType_(literalType), literal_(literal) {
+                hash_ = computeHash();
+            }
         void accept(IExpressionVisitor &visitor) override {
             visitor.visitLiteralExpression(*this);
         }
@@ -70,12 +134,21 @@ class LiteralExpression : public Expression {
                       throw std::exception(); // TODO: handle
             }
         }
-        virtual std::unique_ptr<Expression> clone() const override {
-            return std::make_unique<LiteralExpression>(*this);
+        virtual size_t arity() const override { return 0; }
+        // Never valid to call, literals have arity() 0
+        virtual const Expression& child(size_t) const override {
+            assert(false && "literals have no children");
+            return *this;
         }
-        std::string literal() const { return literal_; }
+        const std::string &literal() const { return literal_; }
         TokenType type() const { return literalType_; }
-        virtual std::string toString() const override { return literal(); }
+        virtual std::string_view spelling() const override { return literal(); }
+
+    protected:
+        virtual void releaseChildren(std::vector<std::unique_ptr<Expression>>&) override {}
+        virtual size_t computeHash() const override {
+            return structuralHash(literalType_, literal_);
+        }
 };
 
 class BinaryExpression : public Expression {
@@ -85,13 +158,15 @@ class BinaryExpression : public Expression {
         std::unique_ptr<Expression> right_;
 
     public:
+        using Expression::child;
         BinaryExpression(std::unique_ptr<Expression> left, Token token,
                          std::unique_ptr<Expression> right)
             : left_(std::move(left)), op_(std::move(token)), right_(std::move(right)) {
                 left_->parent = this;
                 right_->parent = this;
+                hash_ = computeHash();
             }
-        virtual std::string toString() const override { return "(" + left_->toString() + op_.literal() + right_->toString() + ")"; }
+        ~BinaryExpression() override { destroyChildren(); }
 
         void accept(IExpressionVisitor& visitor) override {
             visitor.visitBinaryExpression(*this);
@@ -114,18 +189,29 @@ class BinaryExpression : public Expression {
             }
         }
 
-        virtual std::unique_ptr<Expression> clone() const override {
-            auto leftCopy = left_->clone();
-            auto rightCopy = right_->clone();
-            return std::make_unique<BinaryExpression>(std::move(leftCopy), op_, std::move(rightCopy));
-        }
+        virtual size_t arity() const override { return 2; }
+        virtual const Expression& child(size_t index) const override { return index == 0 ? *left_ : *right_; }
 
         Expression& left() { return *left_; }
-        Token& op() { return op_; }
+        const Expression& left() const { return *left_; }
+        const Token& op() const { return op_; }
+        virtual std::string_view spelling() const override { return op_.literal(); }
         Expression& right() { return *right_; }
+        const Expression& right() const { return *right_; }
+
+        void setLeft(std::unique_ptr<Expression> value) { left_ = std::move(value); left_->parent = this; invalidateHash(); }
+        void setRight(std::unique_ptr<Expression> value) { right_ = std::move(value); right_->parent = this; invalidateHash(); }
 
-        void setLeft(std::unique_ptr<Expression> value) { left_ = std::move(value); left_->parent = this; }
-        void setRight(std::unique_ptr<Expression> value) { right_ = std::move(value); right_->parent = this; }
+    protected:
+        virtual void releaseChildren(std::vector<std::unique_ptr<Expression>>& out) override {
+            if (left_)
+                out.push_back(std::move(left_));
+            if (right_)
+                out.push_back(std::move(right_));
+        }
+        virtual size_t computeHash() const override {
+            return structuralHash(op_.type(), op_.symbol(), left_->hash(), right_->hash());
+        }
 };
 
 class UnaryExpression : public Expression {
@@ -134,11 +220,14 @@ class UnaryExpression : public Expression {
         std::unique_ptr<Expression> operand_;
 
     public:
+        using Expression::child;
         UnaryExpression(Token op,
                          std::unique_ptr<Expression> right)
             : op_(std::move(op)), operand_(std::move(right)) {
                 operand_->parent = this;
+                hash_ = computeHash();
             }
+        ~UnaryExpression() override { destroyChildren(); }
 
         void accept(IExpressionVisitor& visitor) override {
             visitor.visitUnaryExpression(*this);
@@ -153,15 +242,44 @@ class UnaryExpression : public Expression {
             }
         }
 
-        virtual std::unique_ptr<Expression> clone() const override {
-            auto operandCopy = operand_->clone();
-            return std::make_unique<UnaryExpression>(op_, std::move(operandCopy));
-        }
+        virtual size_t arity() const override { return 1; }
+        virtual const Expression& child(size_t) const override { return *operand_; }
 
-        Token& op() { return op_; }
+        const Token& op() const { return op_; }
+        virtual std::string_view spelling() const override { return op_.literal(); }
         Expression& operand() { return *operand_; }
-        void setOperand(std::unique_ptr<Expression> value) { operand_ = std::move(value); operand_->parent = this; }
-        virtual std::string toString() const override { return op_.literal() + operand_->toString(); }
+        const Expression& operand() const { return *operand_; }
+        void setOperand(std::unique_ptr<Expression> value) { operand_ = std::move(value); operand_->parent = this; invalidateHash(); }
+
+    protected:
+        virtual void releaseChildren(std::vector<std::unique_ptr<Expression>>& out) override {
+            if (operand_)
+                out.push_back(std::move(operand_));
+        }
+        virtual size_t computeHash() const override {
+            return structuralHash(op_.type(), op_.symbol(), operand_->hash());
+        }
+};
+
+template <> struct TreeTraits<Expression> {
+    static size_t arity(const Expression& node) { return node.arity(); }
+    static const Expression& child(const Expression& node, size_t index) { return node.child(index); }
+    static std::string_view spelling(const Expression& node) { return node.spelling(); }
+};
+
+// Visits every node of root children first, left to right, so visitors that
+// keep results on a stack find the results of a node's operands on top of
+// it. Visitors must not recurse into children themselves; the walk uses an
+// explicit stack, trees can be deeper than the call stack.
+void walkPostOrder(Expression& root, IExpressionVisitor& visitor);
+
+// For hash containers of expressions compared by structure
+struct ExpressionHash {
+    size_t operator()(const Expression* expression) const { return expression->hash(); }
+};
+
+struct ExpressionEqual {
+    bool operator()(const Expression* a, const Expression* b) const { return *a == *b; }
 };
 
 #endif
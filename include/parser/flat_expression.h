@@ -0,0 +1,92 @@
+#ifndef FLAT_EXPRESSION_H
+#define FLAT_EXPRESSION_H
+
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// An expression tree stored as parallel arrays with one entry per node, in
+// post-order: operands come before their operator and the root is last. That
+// is the postfix order the VM and the rewriter consume, so compiling,
+// evaluating or interning a tree is one linear pass over the arrays, with no
+// stack of pending nodes and no pointer chasing. That only holds once the
+// arrays exist: FlatExpression(Expression &) walks a heap tree the parser
+// already built, so it pays for every Expression node before flattening.
+//
+// A node takes NODE_SIZE bytes, 18 since TokenType is one byte wide, plus
+// the text of literals, against 40 to 64 for an Expression node, which is a
+// separate heap object with a vtable, a parent pointer and a Token.
+class FlatExpression {
+public:
+    using Index = uint32_t;
+    // Bytes per node, one entry in each array
+    static constexpr size_t NODE_SIZE = sizeof(uint8_t) + sizeof(TokenType) +
+                                        sizeof(uint32_t) + sizeof(Index) +
+                                        2 * sizeof(uint32_t);
+
+private:
+    std::vector<uint8_t> arities_;
+    std::vector<TokenType> types_; // Literal type, or the operator
+    // Operator spelling as a SymbolId, or the literal's index in literals_
+    std::vector<uint32_t> symbols_;
+    std::vector<Index> lefts_;     // Left operand of binary nodes
+    // Where operators were in the source, for runtime errors
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    // Literal text isn't interned, the expression owns it
+    std::vector<std::string> literals_;
+
+    Index add(uint8_t arity, TokenType type, uint32_t symbol, Index left,
+              uint32_t offset, uint32_t length);
+
+public:
+    FlatExpression() = default;
+    // Iterative, trees can be deeper than the stack
+    explicit FlatExpression(Expression &root);
+
+    void reserve(size_t nodes);
+
+    // Nodes are appended in post-order: the operand of a unary node and the
+    // right operand of a binary one are the nodes appended just before it
+    Index addLiteral(TokenType type, std::string_view literal);
+    Index addUnary(const Token &op);
+    Index addBinary(const Token &op, Index left);
+
+    size_t size() const { return arities_.size(); }
+    bool empty() const { return arities_.empty(); }
+    Index root() const { return static_cast<Index>(size() - 1); }
+
+    uint8_t arity(Index node) const { return arities_[node]; }
+    TokenType type(Index node) const { return types_[node]; }
+    // Spelling of an operator node
+    SymbolId symbol(Index node) const {
+        assert(arity(node) > 0);
+        return SymbolId{symbols_[node]};
+    }
+    // Text of a literal, or spelling of an operator
+    const std::string &literal(Index node) const {
+        return arity(node) == 0 ? literals_[symbols_[node]] : symbolName(symbol(node));
+    }
+    Index left(Index node) const { return lefts_[node]; }
+    Index right(Index node) const { return node - 1; }
+    Index operand(Index node) const { return node - 1; }
+    // The node's operator with its source location, to report errors at
+    Token token(Index node) const {
+        return Token(types_[node], offsets_[node], lengths_[node], symbol(node));
+    }
+
+    // Iterative, like the constructor
+    std::unique_ptr<Expression> toExpression() const;
+};
+
+static_assert(FlatExpression::NODE_SIZE == 18);
+
+#endif
@@ -4,6 +4,7 @@
 class ExpressionStatement;
 class DefineStatement;
 class ApplyStatement;
+class NormalizeStatement;
 class ShowStatement;
 
 class IStatementVisitor {
@@ -11,6 +12,7 @@ class IStatementVisitor {
         virtual void visitExpressionStatement(ExpressionStatement& statement) = 0;
         virtual void visitDefineStatement(DefineStatement& statement) = 0;
         virtual void visitApplyStatement(ApplyStatement& statement) = 0;
+        virtual void visitNormalizeStatement(NormalizeStatement& statement) = 0;
         virtual void visitShowStatement(ShowStatement& statement) = 0;
 };
 
@@ -0,0 +1,48 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include "parser/statement.h"
+#include "runtime/thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Lexes and parses a large source on several threads.
+//
+// Statements don't depend on each other syntactically, so the source is cut
+// into chunks of about chunkSize bytes at the end of a statement, a ';' that
+// is neither in a string literal nor in a '#' comment. Chunks are lexed and
+// parsed on their own and their statements concatenated in order, giving
+// the same statements as a Parser over all of Lexer{source}.tokenize().
+// Lexers intern each distinct identifier of their chunk once, literals
+// aren't interned, so workers rarely meet on the global symbol table.
+//
+// Errors are the ones the sequential parse throws too, with offsets into
+// the whole source: the first lexer error if there is one, since the whole
+// source is lexed before parsing, otherwise the first parser error.
+class ParallelParser {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+    // 0 threads means one per hardware thread
+    explicit ParallelParser(size_t threads = 0,
+                            size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    std::vector<std::unique_ptr<Statement>> parse(std::string_view source);
+
+    // Offsets the chunks of source start at, the first always being 0.
+    // Every chunk but the last ends right after a ';' and is at least
+    // chunkSize bytes, unless the source has no more statement ends.
+    static std::vector<uint32_t> split(std::string_view source, size_t chunkSize);
+
+    size_t threads() const { return pool.size(); }
+
+private:
+    ThreadPool pool;
+    const size_t chunkSize;
+};
+
+#endif
@@ -6,21 +6,26 @@
 #include "parser/statement.h"
 
 #include <memory>
+#include <string_view>
 #include <vector>
 
 class Parser {
     private:
         const std::vector<Token> lexemes;
+        const std::string_view source;
         size_t currentIndex{0};
         void consume();
         bool matchAny(std::initializer_list<TokenType> tokenTypes);
         bool isOfType(TokenType typeToCheck, std::initializer_list<TokenType> types) const;
         bool isAtEnd() const;
-        Token previous() const;
-        Token peek() const;
+        const Token &previous() const;
+        const Token &peek() const;
+        std::string_view text(const Token &token) const;
 
         std::unique_ptr<Statement> command();
         std::unique_ptr<Statement> applyStatement();
+        // apply is the token before the '*'
+        std::unique_ptr<Statement> normalizeStatement(const Token &apply);
         std::unique_ptr<Statement> defineStatement();
         std::unique_ptr<Statement> showStatement();
 
@@ -28,15 +33,14 @@ class Parser {
         std::unique_ptr<Statement> expressionStatement();
 
         std::unique_ptr<Expression> expression();
-        std::unique_ptr<Expression> equality();
-        std::unique_ptr<Expression> comparison();
-        std::unique_ptr<Expression> term();
-        std::unique_ptr<Expression> factor();
-        std::unique_ptr<Expression> unary();
         std::unique_ptr<Expression> primary();
 
     public:
-        Parser(const std::vector<Token> _lexemes) : lexemes{std::move(_lexemes)} {}
+        // source is what the tokens were lexed from, literals are read from
+        // it and it must outlive parse(). Tokens built by hand carry their
+        // text and need none.
+        Parser(std::vector<Token> _lexemes, std::string_view _source = {})
+            : lexemes{std::move(_lexemes)}, source{_source} {}
         std::vector<std::unique_ptr<Statement>> parse();
 };
 
@@ -2,6 +2,7 @@
 #define PARSER_ERRORS
 
 #include "carl_constants.h"
+#include "lexer/line_index.h"
 #include "lexer/token.h"
 #include <cassert>
 #include <cstdint>
@@ -10,100 +11,90 @@
 #include <format>
 #include <iostream>
 #include <string>
-#include <tuple>
+#include <string_view>
 
 // Base Lexer exception
 class ParserException : public std::exception {
     protected:
-        const uint16_t sourceOffset_;
-        const uint16_t length_;
-        std::tuple<uint16_t, uint16_t> calculateLineNumber(const std::string_view source, const uint16_t sourceOffset) const {
-            assert((source.size() >= sourceOffset) && "Could not calculate line number since the offset exceeds the bounds of the source string given");
-
-            uint16_t lineNumber{0};
-            uint16_t offsetToLineNumber{0};
-            for (uint16_t offset = 0; offset != sourceOffset; offset++) {
-                if (source[offset] == '\n') {
-                    lineNumber++;
-                    offsetToLineNumber = offset;
-                }
-            }
-            return std::make_tuple(lineNumber, sourceOffset - offsetToLineNumber);
-        }
-        std::string locationPrefix(std::string_view source) const {
-            uint16_t startLineNumber;
-            uint16_t startCharacterIndex;
-            std::tie(startLineNumber, startCharacterIndex) = calculateLineNumber(source, sourceOffset_);
-
-            uint16_t endLineNumber;
-            uint16_t endCharacterIndex;
-            std::tie(endLineNumber, endCharacterIndex) = ParserException::calculateLineNumber(source, sourceOffset_ + length_);
-            return std::format("{}:{} - {}:{}", startLineNumber, startCharacterIndex, endLineNumber, endCharacterIndex);
+        const uint32_t sourceOffset_;
+        const uint32_t length_;
+        std::string locationPrefix(const LineIndex &lines) const {
+            return lines.describe(sourceOffset_, length_);
         }
+        // The error message, given where in the source the error is
+        virtual std::string describe(const std::string &location) const = 0;
     public:
-        ParserException(const uint16_t sourceOffset, const uint16_t length) : sourceOffset_{sourceOffset}, length_{length} {}
+        ParserException(const uint32_t sourceOffset, const uint32_t length) : sourceOffset_{sourceOffset}, length_{length} {}
 
-        virtual const std::string what(std::string_view source) const noexcept = 0;
+        // Builds a line index for source, prefer passing one that is kept
+        // around when reporting several errors in the same source
+        const std::string what(std::string_view source) const noexcept {
+            return what(LineIndex{source});
+        }
+        const std::string what(const LineIndex &lines) const noexcept {
+            return describe(locationPrefix(lines));
+        }
         virtual const ParserError error_code() const noexcept = 0;
 };
 
 class SyntaxError : public ParserException {
     private:
-        const Token token_;
+        const std::string text_;
         const std::string msg_;
     public:
-        SyntaxError(const Token token) : token_{token}, ParserException(token.sourceOffset(), token.length()) {}
-        SyntaxError(const Token token, std::string msg) : token_{token}, msg_{msg}, ParserException(token.sourceOffset(), token.length()) {}
+        // text is the token's text, kept since the source may not outlive the error
+        SyntaxError(const Token token, std::string_view text) : ParserException(token.sourceOffset(), token.length()), text_{text} {}
+        SyntaxError(const Token token, std::string_view text, std::string msg) : ParserException(token.sourceOffset(), token.length()), text_{text}, msg_{msg} {}
 
         const ParserError error_code() const noexcept override {
             return ParserError::SYNTAX_ERROR;
         }
 
-        const std::string what(std::string_view source) const noexcept override {
-            return std::string{locationPrefix(source) + " Syntax Error at '" + token_.literal() + "' " + msg_};
+        std::string describe(const std::string &location) const override {
+            return std::string{location + " Syntax Error at '" + text_ + "' " + msg_};
         }
 };
 
 class UnexpectedToken : public ParserException {
     private:
-        const Token token_;
+        const std::string text_;
     public:
-        UnexpectedToken(const Token token) : token_{token}, ParserException(token.sourceOffset(), token.length()) {}
+        UnexpectedToken(const Token token, std::string_view text) : ParserException(token.sourceOffset(), token.length()), text_{text} {}
 
         const ParserError error_code() const noexcept override {
             return ParserError::UNEXPECTED_TOKEN;
         }
 
-        const std::string what(std::string_view source) const noexcept override {
-            return std::string{locationPrefix(source) + " Unexpected Token '" + token_.literal() + "'"};
+        std::string describe(const std::string &location) const override {
+            return std::string{location + " Unexpected Token '" + text_ + "'"};
         }
 };
 
 class MissingClosingBracket : public ParserException {
     public:
-        MissingClosingBracket(const uint16_t sourceOffset, const uint16_t length) : ParserException(sourceOffset, length) {}
+        MissingClosingBracket(const uint32_t sourceOffset, const uint32_t length) : ParserException(sourceOffset, length) {}
 
         const ParserError error_code() const noexcept override {
             return ParserError::MISSING_CLOSING_BRACKET;
         }
 
-        const std::string what(std::string_view source) const noexcept override {
-            return std::string{"Missing Closing Bracket at: " + locationPrefix(source)};
+        std::string describe(const std::string &location) const override {
+            return std::string{"Missing Closing Bracket at: " + location};
         }
 };
 
 class MissingTerminator : public ParserException {
     private:
-        const Token token_;
+        const std::string text_;
     public:
-        MissingTerminator(const Token token) : token_{token}, ParserException(token.sourceOffset(), token.length()) {}
+        MissingTerminator(const Token token, std::string_view text) : ParserException(token.sourceOffset(), token.length()), text_{text} {}
 
         const ParserError error_code() const noexcept override {
             return ParserError::MISSING_TERMINATOR;
         }
 
-        const std::string what(std::string_view source) const noexcept override {
-            return std::string{locationPrefix(source) + " Missing terminator after '" + token_.literal() + "'"};
+        std::string describe(const std::string &location) const override {
+            return std::string{location + " Missing terminator after '" + text_ + "'"};
         }
 };
 #endif
@@ -1,12 +1,16 @@
 #ifndef STATEMENT_H
 #define STATEMENT_H
 
+#include "lexer/token.h"
 #include "parser/expression.h"
 #include "parser/istatement_visitor.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 class Statement {
 public:
+    virtual ~Statement() = default;
     virtual void accept(IStatementVisitor &visitor) = 0;
 };
 
@@ -21,16 +25,18 @@ public:
         visitor.visitExpressionStatement(*this);
     }
     Expression &expression() { return *expression_; }
+    std::unique_ptr<Expression> borrowExpression() { return std::move(expression_); }
+    void setExpression(std::unique_ptr<Expression> expression) { expression_ = std::move(expression); }
 };
 
 class DefineStatement : public Statement {
 private:
-    const std::string ruleName_;
+    const SymbolId ruleName_;
     std::unique_ptr<Expression> pattern_;
     std::unique_ptr<Expression> replacement_;
 
 public:
-    DefineStatement(std::string ruleName, std::unique_ptr<Expression> pattern,
+    DefineStatement(SymbolId ruleName, std::unique_ptr<Expression> pattern,
                     std::unique_ptr<Expression> replacement)
         : ruleName_{ruleName}, pattern_{std::move(pattern)},
           replacement_{std::move(replacement)} {}
@@ -39,26 +45,58 @@ public:
         visitor.visitDefineStatement(*this);
     }
 
-    std::string ruleName() const { return ruleName_; }
+    SymbolId ruleSymbol() const { return ruleName_; }
+    const std::string &ruleName() const { return symbolName(ruleName_); }
+    Expression &pattern() { return *pattern_; }
+    Expression &replacement() { return *replacement_; }
     std::unique_ptr<Expression> borrowPattern() { return std::move(pattern_); }
     std::unique_ptr<Expression> borrowReplacement() {return std::move(replacement_); }
+    void setPattern(std::unique_ptr<Expression> pattern) { pattern_ = std::move(pattern); }
+    void setReplacement(std::unique_ptr<Expression> replacement) { replacement_ = std::move(replacement); }
 };
 
 class ApplyStatement : public Statement {
 private:
-    std::string ruleName_;
+    SymbolId ruleName_;
     std::unique_ptr<Expression> expression_;
 
 public:
-    ApplyStatement(std::string ruleName, std::unique_ptr<Expression> expression)
+    ApplyStatement(SymbolId ruleName, std::unique_ptr<Expression> expression)
         : ruleName_{ruleName}, expression_{std::move(expression)} {}
 
     virtual void accept(IStatementVisitor& visitor) override {
         visitor.visitApplyStatement(*this);
     }
 
-    std::string ruleName() const { return ruleName_; }
+    SymbolId ruleSymbol() const { return ruleName_; }
+    const std::string &ruleName() const { return symbolName(ruleName_); }
+    Expression &expression() { return *expression_; }
+    std::unique_ptr<Expression> borrowExpression() { return std::move(expression_); }
+    void setExpression(std::unique_ptr<Expression> expression) { expression_ = std::move(expression); }
+};
+
+// Rewrites with a set of rules (every defined rule when none are named)
+// until none of them applies anymore
+class NormalizeStatement : public Statement {
+private:
+    // The apply* keyword, where errors of the whole statement are reported
+    Token keyword_;
+    std::vector<SymbolId> ruleNames_;
+    std::unique_ptr<Expression> expression_;
+
+public:
+    NormalizeStatement(Token keyword, std::vector<SymbolId> ruleNames, std::unique_ptr<Expression> expression)
+        : keyword_{keyword}, ruleNames_{std::move(ruleNames)}, expression_{std::move(expression)} {}
+
+    virtual void accept(IStatementVisitor& visitor) override {
+        visitor.visitNormalizeStatement(*this);
+    }
+
+    const Token &keyword() const { return keyword_; }
+    const std::vector<SymbolId> &ruleNames() const { return ruleNames_; }
+    Expression &expression() { return *expression_; }
     std::unique_ptr<Expression> borrowExpression() { return std::move(expression_); }
+    void setExpression(std::unique_ptr<Expression> expression) { expression_ = std::move(expression); }
 };
 
 class ShowStatement : public Statement {
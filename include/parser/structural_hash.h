@@ -0,0 +1,39 @@
+#ifndef STRUCTURAL_HASH_H
+#define STRUCTURAL_HASH_H
+
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+// Hash of a tree node from its own symbol and the hashes of its children.
+// Shared by Expression and Term, so a parsed expression and the term it
+// interns to hash the same, in every table.
+
+inline size_t structuralHash(TokenType type, SymbolId literal) {
+    // Symbol ids are global, so this is the same everywhere
+    return std::hash<SymbolId>{}(literal) ^
+           (static_cast<size_t>(type) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Literals aren't interned, they hash their text
+inline size_t structuralHash(TokenType type, std::string_view literal) {
+    return std::hash<std::string_view>{}(literal) ^
+           (static_cast<size_t>(type) * 0x9e3779b97f4a7c15ULL);
+}
+
+inline size_t structuralHash(TokenType type, SymbolId literal,
+                             size_t operand) {
+    size_t hash = structuralHash(type, literal);
+    return hash ^ (operand + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+inline size_t structuralHash(TokenType type, SymbolId literal, size_t left,
+                             size_t right) {
+    size_t hash = structuralHash(type, literal, left);
+    return hash ^ (right + 0x7f4a7c159e3779b9ULL + (hash << 6) + (hash >> 2));
+}
+
+#endif
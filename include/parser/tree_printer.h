@@ -0,0 +1,100 @@
+#ifndef TREE_PRINTER_H
+#define TREE_PRINTER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum PrintStyle : uint8_t {
+    PRINT_COMPACT, // (1+2), how toString() spells expressions and terms
+    PRINT_SPACED,  // (1 + 2), how show and the AstPrinter spell them
+};
+
+// How the printer reads a tree type, specialized next to each type:
+//   static size_t arity(const Node &node);
+//   static const Node &child(const Node &node, size_t index);
+//   static std::string_view spelling(const Node &node);
+template <typename Node> struct TreeTraits;
+
+// Passes the text of root, fully bracketed, to write(std::string_view) piece
+// by piece: literals as spelled, unary nodes as op operand and binary ones
+// as (left op right). One pass with an explicit stack, nothing is copied but
+// the pieces themselves, so the cost is linear in the output at any depth.
+template <typename Node, typename Write>
+void writeTree(const Node &root, PrintStyle style, Write &&write) {
+    using Traits = TreeTraits<Node>;
+
+    // Either a node still to print, or text to write
+    struct Item {
+        const Node *node;
+        std::string_view text;
+        bool spaced; // Text is an operator, written between separators
+    };
+
+    const bool spaced = style == PRINT_SPACED;
+    std::vector<Item> pending{{&root, {}, false}};
+    while (!pending.empty()) {
+        Item item = pending.back();
+        pending.pop_back();
+
+        if (item.node == nullptr) {
+            if (item.spaced)
+                write(" ");
+            write(item.text);
+            if (item.spaced)
+                write(" ");
+            continue;
+        }
+
+        const Node &node = *item.node;
+        switch (Traits::arity(node)) {
+        case 0:
+            write(Traits::spelling(node));
+            break;
+        case 1:
+            write(Traits::spelling(node));
+            pending.push_back({&Traits::child(node, 0), {}, false});
+            break;
+        default:
+            write("(");
+            pending.push_back({nullptr, ")", false});
+            pending.push_back({&Traits::child(node, 1), {}, false});
+            pending.push_back({nullptr, Traits::spelling(node), spaced});
+            pending.push_back({&Traits::child(node, 0), {}, false});
+        }
+    }
+}
+
+// Writes root to out, any output iterator over char, e.g. an
+// std::ostreambuf_iterator to stream it without building a string
+template <typename Node, typename OutputIt>
+OutputIt printTree(const Node &root, OutputIt out,
+                   PrintStyle style = PRINT_COMPACT) {
+    writeTree(root, style, [&out](std::string_view text) {
+        out = std::copy(text.begin(), text.end(), out);
+    });
+    return out;
+}
+
+// Characters root prints as, to size a buffer before printing
+template <typename Node>
+size_t printedLength(const Node &root, PrintStyle style = PRINT_COMPACT) {
+    size_t length{0};
+    writeTree(root, style,
+              [&length](std::string_view text) { length += text.size(); });
+    return length;
+}
+
+// Appends root to output. Sizing the output first with printedLength()
+// costs a second walk, which is slower than the amortized growth of output.
+template <typename Node>
+void appendTree(const Node &root, std::string &output,
+                PrintStyle style = PRINT_COMPACT) {
+    writeTree(root, style,
+              [&output](std::string_view text) { output.append(text); });
+}
+
+#endif
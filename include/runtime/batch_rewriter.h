@@ -0,0 +1,62 @@
+#ifndef BATCH_REWRITER_H
+#define BATCH_REWRITER_H
+
+#include "parser/expression.h"
+#include "runtime/environment.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "runtime/thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct BatchResult {
+    std::unique_ptr<Expression> expression;
+    size_t rewrites;
+};
+
+// Normalizes many independent expressions against the same rules on a thread
+// pool. Each batch works on a snapshot of the environment, so rules may be
+// defined while it runs. Each worker has its own term table, rewriter and
+// scratch buffers, so workers share nothing but the rules.
+class BatchRewriter {
+private:
+    struct Worker {
+        TermTable terms;
+        ExpressionRewriter rewriter;
+    };
+
+    const Environment &environment;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+    size_t rewriteBudget;
+
+    template <typename Normalize>
+    std::vector<BatchResult>
+    run(const std::vector<std::unique_ptr<Expression>> &expressions,
+        Normalize normalize);
+
+public:
+    // 0 threads means one per hardware thread
+    explicit BatchRewriter(const Environment &environment, size_t threads = 0,
+                           size_t budget = DEFAULT_REWRITE_BUDGET);
+
+    size_t threads() const { return pool.size(); }
+
+    // Normalizes every expression with all rules in the environment, like
+    // apply*. Results are in input order. If any expression throws (e.g.
+    // RewriteLimitExceeded) the batch is abandoned and the error rethrown.
+    // Rules of a loaded library only take part once indexLibrary() was
+    // called on the environment.
+    std::vector<BatchResult>
+    normalize(const std::vector<std::unique_ptr<Expression>> &expressions);
+    // Same, with only the given rules, in the given order. The caller keeps
+    // them alive, e.g. by holding the snapshot they came from.
+    std::vector<BatchResult>
+    normalize(const std::vector<std::unique_ptr<Expression>> &expressions,
+              const std::vector<const Rule *> &rules);
+};
+
+#endif
@@ -1,53 +1,85 @@
 #ifndef CARL_OBJECT_H
 #define CARL_OBJECT_H
 
+#include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <fmt/core.h>
 #include <string>
+#include <string_view>
 
-enum ValueType {
+enum ValueType : uint8_t {
     VALUE_BOOL,
     VALUE_NULL,
     VALUE_NUMBER,
     VALUE_OBJ,
+    VALUE_SHORT_STRING, // Characters stored in the value itself
 };
 
 enum ObjectType {
     OBJ_STRING,
 };
 
+#define IS_STRING(value)                                                       \
+    ((value).type == ValueType::VALUE_SHORT_STRING ||                          \
+     ((value).type == ValueType::VALUE_OBJ &&                                  \
+      (value).obj->objType == ObjectType::OBJ_STRING))
+
 struct Obj {
     ObjectType objType;
 };
 
+// Header of a string object. The length + 1 characters, including the
+// terminating null, follow directly after it in the same pooled allocation.
 struct ObjString {
     Obj obj;
     uint32_t length;
-    char* chars;
 
-    ~ObjString() {
-        delete chars;
-        chars = nullptr;
-    }
+    char *chars() { return reinterpret_cast<char *>(this + 1); }
+    const char *chars() const { return reinterpret_cast<const char *>(this + 1); }
+    std::string_view view() const { return {chars(), length}; }
+
+    static ObjString *create(std::string_view first, std::string_view second = {});
+    static void destroy(ObjString *string) noexcept;
 };
 
 struct Value {
+    // Strings up to this length need no allocation
+    static constexpr size_t SHORT_STRING_MAX = 8;
+
     ValueType type;
+    uint8_t shortLength; // Only for VALUE_SHORT_STRING
     union {
         double number;
         Obj* obj;
+        char shortChars[SHORT_STRING_MAX];
     };
 
+    // Concatenation of first and second, inline when short enough
+    static Value string(std::string_view first, std::string_view second = {});
+
+    std::string_view asString() const {
+        if (type == ValueType::VALUE_SHORT_STRING)
+            return {shortChars, shortLength};
+        return reinterpret_cast<const ObjString *>(obj)->view();
+    }
+
+    // Deep copy, the copy must be disposed separately
+    Value copy() const {
+        if (type != ValueType::VALUE_OBJ)
+            return *this;
+        return string(asString());
+    }
+
     void dispose() {
         if (type != ValueType::VALUE_OBJ)
             return;
 
-        // Since we type pun we need to manually call "derived" objects
-        // destructor instead of just 'delete obj'
+        // Since we type pun we need to manually free the "derived" object
+        // instead of just 'delete obj'
         switch (obj->objType) {
             case OBJ_STRING:
-                reinterpret_cast<ObjString* >(obj)->~ObjString();
+                ObjString::destroy(reinterpret_cast<ObjString *>(obj));
                 break;
 
             default:
@@ -57,12 +89,15 @@ struct Value {
     }
 
     std::string toString() {
-        if (type == ValueType::VALUE_OBJ && obj->objType == ObjectType::OBJ_STRING)
-            return reinterpret_cast<ObjString *>(obj)->chars;
+        if (IS_STRING(*this))
+            return std::string{asString()};
 
         return std::to_string(number);
     }
 };
 
+// Inline strings must not make every stack slot bigger
+static_assert(sizeof(Value) == 16);
+
 
 #endif
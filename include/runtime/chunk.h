@@ -0,0 +1,88 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include "runtime/carl_object.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum OpCode : uint8_t {
+    OP_CONSTANT,      // [index: u8] push constants[index]
+    OP_CONSTANT_LONG, // [index: u24] push constants[index]
+    OP_TRUE,
+    OP_FALSE,
+
+    OP_NEGATE,
+    OP_NOT,
+
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+
+    OP_RETURN,
+};
+
+// Location in the source of the operator an instruction was compiled from,
+// needed to report runtime errors.
+struct SourceSpan {
+    size_t codeOffset;
+    uint32_t sourceOffset;
+    uint32_t length;
+};
+
+// A compiled expression: a flat instruction stream and the constants it
+// references.
+class Chunk {
+private:
+    std::vector<uint8_t> code_;
+    std::vector<Value> constants_;
+
+    // Only instructions that can fail at runtime get a span, sorted by
+    // codeOffset since they are emitted in order
+    std::vector<SourceSpan> spans_;
+    size_t maxStackDepth_{0};
+
+public:
+    Chunk() = default;
+    Chunk(const Chunk &) = delete;
+    Chunk &operator=(const Chunk &) = delete;
+    Chunk(Chunk &&) = default;
+    Chunk &operator=(Chunk &&) = default;
+
+    ~Chunk() {
+        // The chunk owns its string constants, the VM copies them on push
+        for (Value &constant : constants_)
+            constant.dispose();
+    }
+
+    void write(uint8_t byte) { code_.push_back(byte); }
+    void write(uint8_t byte, uint32_t sourceOffset, uint32_t length) {
+        spans_.push_back(SourceSpan{code_.size(), sourceOffset, length});
+        code_.push_back(byte);
+    }
+
+    size_t addConstant(Value value) {
+        constants_.push_back(value);
+        return constants_.size() - 1;
+    }
+
+    const SourceSpan *spanAt(size_t codeOffset) const {
+        auto it = std::lower_bound(spans_.begin(), spans_.end(), codeOffset,
+                                   [](const SourceSpan &span, size_t offset) {
+                                       return span.codeOffset < offset;
+                                   });
+        if (it == spans_.end() || it->codeOffset != codeOffset)
+            return nullptr;
+        return &*it;
+    }
+
+    const std::vector<uint8_t> &code() const { return code_; }
+    const std::vector<Value> &constants() const { return constants_; }
+    size_t maxStackDepth() const { return maxStackDepth_; }
+    void setMaxStackDepth(size_t depth) { maxStackDepth_ = depth; }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "parser/flat_expression.h"
+#include "parser/iexpression_visitor.h"
+#include "runtime/chunk.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+// Operands of OP_CONSTANT_LONG are 24 bit
+static constexpr size_t MAX_CHUNK_CONSTANTS = 1 << 24;
+
+// Lowers an expression tree into a bytecode chunk executed by the VM
+class Compiler : public IExpressionVisitor {
+private:
+    const size_t maxConstants;
+    Chunk chunk;
+    std::unordered_map<double, size_t> numberConstants;
+    size_t stackDepth{0};
+    size_t maxStackDepth{0};
+
+    void begin();
+    Chunk finish();
+    // One node, its operands were emitted before it
+    void emitLiteral(TokenType type, const std::string &literal);
+    void emitUnary(const Token &op);
+    void emitBinary(const Token &op);
+    void emitConstant(Value value);
+    void emitConstantIndex(size_t index);
+    void pushed(size_t count = 1);
+    void popped(size_t count = 1);
+
+public:
+    explicit Compiler(size_t maxConstants = MAX_CHUNK_CONSTANTS) : maxConstants{maxConstants} {}
+
+    // Throws TooManyConstants for expressions with more distinct constants
+    // than maxConstants, and InternalError for operators without an
+    // instruction
+    Chunk compile(Expression &expression);
+    Chunk compile(const FlatExpression &expression);
+    virtual void visitLiteralExpression(LiteralExpression &expression) override;
+    virtual void visitBinaryExpression(BinaryExpression &expression) override;
+    virtual void visitUnaryExpression(UnaryExpression &expression) override;
+};
+
+#endif
@@ -1,26 +1,112 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include "lexer/symbol_table.h"
 #include "runtime/rule.h"
+#include "runtime/rule_index.h"
+#include "runtime/rule_library.h"
+#include "runtime/term.h"
 
-#include <string>
-#include <unordered_map>
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-class Environment {
+// One version of the defined rules. Versions handed out by Environment are
+// immutable, so any number of threads can read them without locking. Rules
+// are shared between versions, only the name table and index are copied.
+//
+// Rules of an attached library are found by name without being copied into
+// the set, until indexLibrary() defines all of them at once.
+class RuleSet {
 private:
-    std::unordered_map<std::string, std::unique_ptr<Rule>> definitions;
+    std::unordered_map<SymbolId, std::shared_ptr<const Rule>> definitions;
+    RuleIndex index;
+
+    std::shared_ptr<const RuleLibrary> library;
+    size_t libraryOrder{0}; // Index order of the library's first rule
+    size_t shadowed{0};     // Library rules replaced by definitions
+    bool libraryIndexed{false};
+
+    bool inLibrary(SymbolId name) const {
+        return library && library->find(symbolName(name)) != RuleLibrary::NONE;
+    }
+
 public:
-    void addDefinition(std::string name, std::unique_ptr<Rule> definition) {
-        // TODO: handle rule already exists
-        definitions[name] = std::move(definition);
+    // Replaces any rule already defined under name
+    void define(SymbolId name, std::shared_ptr<const Rule> rule);
+    // Rules of library rank after those defined so far, at most one library
+    // can be attached
+    void attach(std::shared_ptr<const RuleLibrary> library_);
+    // Defines the attached library's rules that weren't replaced, so the
+    // index covers them. Decodes every one of them.
+    void indexLibrary();
+    bool needsIndexing() const { return library && !libraryIndexed; }
+
+    // nullptr if name isn't defined
+    const Rule *find(SymbolId name) const;
+    std::shared_ptr<const Rule> share(SymbolId name) const;
+
+    // Rules that might apply to term, in definition order
+    std::vector<const Rule *> candidates(const Term *term) const {
+        return index.candidates(term);
     }
 
-    auto getDefinition(std::string name) const {
-        return definitions.find(name);
+    // Only covers the rules of a library after indexLibrary()
+    const RuleIndex &ruleIndex() const { return index; }
+    size_t size() const {
+        return definitions.size() +
+               (needsIndexing() ? library->size() - shadowed : 0);
     }
+};
 
-    auto end() const { return definitions.end(); }
+// The rule table, safe to read from any thread while rules are defined.
+//
+// Readers take a snapshot(), a reference counted immutable RuleSet that stays
+// valid, and unchanged, for as long as they hold it; taking one only copies a
+// pointer under a short lock. Writers copy the current set only while some
+// reader still holds it, and change it in place otherwise, so definitions
+// with no snapshot outstanding cost no more than a plain map insert.
+class Environment {
+private:
+    mutable std::mutex mutex; // Guards current, and handing out references
+    std::shared_ptr<RuleSet> current;
+
+    // The set to change, copied first if a reader may still see it
+    RuleSet &writable();
+
+public:
+    Environment();
+    Environment(const Environment &) = delete;
+    Environment &operator=(const Environment &) = delete;
+
+    std::shared_ptr<const RuleSet> snapshot() const;
+
+    void addDefinition(SymbolId name, std::unique_ptr<Rule> definition);
+    void addDefinition(std::string_view name, std::unique_ptr<Rule> definition) {
+        addDefinition(internSymbol(name), std::move(definition));
+    }
+    // Defines all rules at once, readers see either none or all of them
+    void addDefinitions(
+        std::vector<std::pair<SymbolId, std::unique_ptr<Rule>>> definitions);
+    // Makes the library's rules visible by name, ranking after the rules
+    // defined so far; later definitions of the same names replace them.
+    // Rules are decoded as they are looked up.
+    void loadLibrary(std::shared_ptr<const RuleLibrary> library);
+    // Adds the loaded library's rules to the rule index, which candidates()
+    // and ruleIndex() of snapshots taken afterwards need. Decodes all of
+    // them the first time, and does nothing afterwards.
+    void indexLibrary();
+
+    // nullptr if name isn't defined
+    std::shared_ptr<const Rule> getDefinition(SymbolId name) const {
+        return snapshot()->share(name);
+    }
+    std::shared_ptr<const Rule> getDefinition(std::string_view name) const {
+        return getDefinition(internSymbol(name));
+    }
 };
 
 #endif
@@ -3,10 +3,26 @@
 
 #include "parser/iexpression_visitor.h"
 #include "parser/expression.h"
+#include "runtime/pattern_matcher.h"
+#include "runtime/rewrite_cache.h"
+#include "runtime/rule.h"
+#include "runtime/rule_index.h"
+#include "runtime/term.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+
+// Maximum number of rewrites a single apply* may perform
+static constexpr size_t DEFAULT_REWRITE_BUDGET = 1000000;
+
+struct NormalizeResult {
+    const Term* term;
+    size_t rewrites;
+};
 
 enum ExpressionRewriterState {
     PROCCESING_PATTERN,
@@ -32,8 +48,56 @@ class ExpressionRewriter : public IExpressionVisitor {
         void resolveReplacement();
         void push(Expression& expression);
 
+        // Scratch buffers for rewriting terms, reused across calls
+        struct TermFrame {
+            const Term* term;
+            uint8_t nextChild;
+        };
+        std::vector<TermFrame> termPath;
+        std::unordered_set<const Term*> termsWithoutMatch;
+        MatchState matchState;
+
+        struct NormalizeFrame {
+            const Term* term;
+            // Result of rewriting term, which has to be normalized before term
+            // can be resolved
+            const Term* redex;
+        };
+        std::vector<NormalizeFrame> worklist;
+        std::unordered_map<const Term*, const Term*> normalForms;
+        std::vector<const Rule*> candidateRules;
+        RuleIndex::Scratch candidateScratch;
+        RewriteCache* cache{nullptr};
+
+        // Rebuilds the ancestors on termPath around the rewritten subterm
+        const Term* splice(TermTable& table, const Rule& rule, const Term* result);
+
+        template <typename RulesFor>
+        NormalizeResult normalizeWith(TermTable& table, const Term* source, size_t budget, const Token* statement, RulesFor rulesFor);
+
+
     public:
         std::unique_ptr<Expression> substitute(std::unique_ptr<Expression> rootSource, std::unique_ptr<Expression> pattern, std::unique_ptr<Expression> _replacement);
+
+        // Replaces the first match of the rule's pattern (in postfix order)
+        // in source, which must be interned in table. Only the spine above
+        // the match is rebuilt, everything else is shared with source.
+        // Returns source itself when nothing matches.
+        const Term* substitute(TermTable& table, const Term* source, const Rule& rule);
+        // Remember substitutions of subterms in cache, which has to belong
+        // to the table passed to substitute() and normalize(). nullptr to
+        // stop caching.
+        void setCache(RewriteCache* cache_) { cache = cache_; }
+
+        // Rewrites source (interned in table) with rules, innermost first,
+        // until none of them applies. Normal forms are memoized, so after a
+        // rewrite only the freshly built part of the term is revisited.
+        // Throws RewriteLimitExceeded if more than budget rewrites are needed,
+        // located at statement if given.
+        NormalizeResult normalize(TermTable& table, const Term* source, const std::vector<const Rule*>& rules, size_t budget, const Token* statement = nullptr);
+        // Same, but with every rule in index, looking up the candidates for
+        // each subterm
+        NormalizeResult normalize(TermTable& table, const Term* source, const RuleIndex& index, size_t budget, const Token* statement = nullptr);
         virtual void visitLiteralExpression(LiteralExpression& expression) override;
         virtual void visitBinaryExpression(BinaryExpression& expression) override;
         virtual void visitUnaryExpression(UnaryExpression& expression) override;
@@ -1,36 +1,101 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "lexer/token.h"
+#include "parser/flat_expression.h"
 #include "parser/iexpression_visitor.h"
 #include "parser/istatement_visitor.h"
 #include "parser/statement.h"
 #include "runtime/carl_object.h"
+#include "runtime/chunk.h"
+#include "runtime/compiler.h"
 #include "runtime/environment.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/parse_cache.h"
+#include "runtime/rewrite_cache.h"
+#include "runtime/rule_library.h"
+#include "runtime/term.h"
+#include "runtime/vm.h"
 #include <memory>
 #include <optional>
 #include <stack>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#define IS_STRING(value)                                                       \
-    (value.type == ValueType::VALUE_OBJ &&                                     \
-     value.obj->objType == ObjectType::OBJ_STRING)
+// Terms kept across statements before starting over
+static constexpr size_t TERM_TABLE_LIMIT = 1 << 16;
+
+enum ExecutionMode {
+    EXECUTE_TREE_WALK, // Evaluate expressions by visiting the AST directly
+    EXECUTE_BYTECODE,  // Compile expressions to bytecode and run them on the VM
+    EXECUTE_FLAT,      // Flatten expressions into arrays and evaluate them in
+                       // one linear pass
+};
 
 class Interpreter : public IStatementVisitor, IExpressionVisitor {
 private:
     Environment environment;
     std::vector<std::unique_ptr<Statement>> statements;
+    // Run instead of statements when set, with its own bytecode
+    std::shared_ptr<const ParsedProgram> program;
     std::stack<Value> workingStack;
+    TermTable terms;
+    RewriteCache rewriteCache;
+
+    ExecutionMode mode{EXECUTE_BYTECODE};
+    size_t rewriteBudget{DEFAULT_REWRITE_BUDGET};
+    bool constantFolding{false};
+    bool statementsFolded{false};
+    Compiler compiler;
+    VM vm;
+    // Compiled once per expression, so re-running the same statements only
+    // pays for execution
+    std::unordered_map<const Expression *, Chunk> chunks;
+    std::unordered_map<const Expression *, FlatExpression> flats;
+
+    void discardValues();
+    // Runs statements in order, returning the value of the last
+    std::optional<Value> run(const std::vector<std::unique_ptr<Statement>> &list);
+    // Evaluation of one node, whose operands are on the working stack
+    void pushLiteral(TokenType type, const std::string &literal);
+    void applyUnary(const Token &op);
+    void applyBinary(const Token &op);
+    // Pushes the value of expression onto the working stack
+    void evaluate(const FlatExpression &expression);
 
 public:
     std::string result; // TODO: move this to value returned by interpret();
+    size_t rewrites{0}; // Rewrites performed by the last apply*
     Interpreter();
     Interpreter(std::unique_ptr<Statement> _statement);
     Interpreter(std::vector<std::unique_ptr<Statement>> _statements);
     std::optional<Value> interpret();
     std::optional<Value> interpret(std::vector<std::unique_ptr<Statement>> statements_);
+    // Runs a program shared with others, e.g. from a ParseCache. It is
+    // neither changed nor folded, ParseCache folds when parsing.
+    std::optional<Value> interpret(std::shared_ptr<const ParsedProgram> program_);
+    void setExecutionMode(ExecutionMode mode_) { mode = mode_; }
+    void setRewriteBudget(size_t budget) { rewriteBudget = budget; }
+    // Fold numeric subtrees of statements before running them. Off by
+    // default, since rewriting then sees 6 where the source said 2 * 3.
+    void setConstantFolding(bool enabled) { constantFolding = enabled; }
+    // Caches apply results, sized in entries, 0 disables it
+    void setRewriteCacheCapacity(size_t capacity) { rewriteCache.setCapacity(capacity); }
+    const RewriteCache &getRewriteCache() const { return rewriteCache; }
+    // Terms of the statements run lately, cleared past TERM_TABLE_LIMIT
+    const TermTable &getTerms() const { return terms; }
+    // Rules compiled by `carl compile`, ranking after those defined so far
+    void loadLibrary(std::shared_ptr<const RuleLibrary> library) {
+        environment.loadLibrary(std::move(library));
+    }
+    // Rules defined so far, e.g. to hand to a BatchRewriter
+    const Environment &getEnvironment() const { return environment; }
     virtual void visitExpressionStatement(ExpressionStatement& statement) override;
     virtual void visitDefineStatement(DefineStatement& statement) override;
     virtual void visitApplyStatement(ApplyStatement& statement) override;
+    virtual void visitNormalizeStatement(NormalizeStatement& statement) override;
     virtual void visitShowStatement(ShowStatement& statement) override;
     virtual void visitLiteralExpression(LiteralExpression &expression) override;
     virtual void visitBinaryExpression(BinaryExpression &expression) override;
@@ -0,0 +1,124 @@
+#ifndef LRU_MAP_H
+#define LRU_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Map holding at most capacity entries, replacing the least recently used
+// one when full. Entries live in one vector, linked into a recency list by
+// index, so a full map reuses slots instead of allocating.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruMap {
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        Key key;
+        Value value;
+        // Recency list, most recently used first
+        uint32_t newer;
+        uint32_t older;
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<Key, uint32_t, Hash> slots;
+    uint32_t newest{NONE};
+    uint32_t oldest{NONE};
+    size_t capacity_;
+
+    void unlink(uint32_t slot) {
+        Entry &entry = entries[slot];
+        if (entry.newer != NONE)
+            entries[entry.newer].older = entry.older;
+        else
+            newest = entry.older;
+        if (entry.older != NONE)
+            entries[entry.older].newer = entry.newer;
+        else
+            oldest = entry.newer;
+    }
+
+    void pushNewest(uint32_t slot) {
+        Entry &entry = entries[slot];
+        entry.newer = NONE;
+        entry.older = newest;
+        if (newest != NONE)
+            entries[newest].newer = slot;
+        newest = slot;
+        if (oldest == NONE)
+            oldest = slot;
+    }
+
+    void touch(uint32_t slot) {
+        if (slot != newest) {
+            unlink(slot);
+            pushNewest(slot);
+        }
+    }
+
+public:
+    // A capacity of 0 holds nothing
+    explicit LruMap(size_t capacity) : capacity_{capacity} {}
+
+    // The value of key, which becomes the most recently used, or nullptr
+    Value *find(const Key &key) {
+        auto it = slots.find(key);
+        if (it == slots.end())
+            return nullptr;
+        touch(it->second);
+        return &entries[it->second].value;
+    }
+
+    // Sets the value of key, which becomes the most recently used. Returns
+    // whether another entry was evicted to make room.
+    bool insert(const Key &key, Value value) {
+        if (capacity_ == 0)
+            return false;
+
+        auto [it, inserted] = slots.try_emplace(key, 0);
+        if (!inserted) {
+            entries[it->second].value = std::move(value);
+            touch(it->second);
+            return false;
+        }
+
+        uint32_t slot;
+        bool evicted = false;
+        if (entries.size() < capacity_) {
+            slot = static_cast<uint32_t>(entries.size());
+            entries.push_back(Entry{key, std::move(value), NONE, NONE});
+        } else {
+            // Reuse the least recently used slot
+            slot = oldest;
+            unlink(slot);
+            slots.erase(entries[slot].key);
+            entries[slot].key = key;
+            entries[slot].value = std::move(value);
+            evicted = true;
+        }
+        it->second = slot;
+        pushNewest(slot);
+        return evicted;
+    }
+
+    void clear() {
+        entries.clear();
+        slots.clear();
+        newest = oldest = NONE;
+    }
+
+    // Drops every entry
+    void setCapacity(size_t capacity) {
+        capacity_ = capacity;
+        clear();
+    }
+
+    size_t size() const { return slots.size(); }
+    size_t capacity() const { return capacity_; }
+};
+
+#endif
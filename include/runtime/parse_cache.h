@@ -0,0 +1,85 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include "parser/expression.h"
+#include "parser/statement.h"
+#include "runtime/chunk.h"
+#include "runtime/lru_map.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+static constexpr size_t DEFAULT_PARSE_CACHE_CAPACITY = 1024;
+
+// Statements parsed once to be run any number of times, with the bytecode of
+// its expression statements compiled up front. Nothing changes it after
+// construction, so interpreters share it instead of parsing the source again.
+class ParsedProgram {
+private:
+    std::vector<std::unique_ptr<Statement>> statements_;
+    std::unordered_map<const Expression *, Chunk> chunks;
+
+public:
+    // Folded first if constantFolding, like Interpreter::setConstantFolding
+    ParsedProgram(std::vector<std::unique_ptr<Statement>> statements,
+                  bool constantFolding = false);
+
+    const std::vector<std::unique_ptr<Statement>> &statements() const { return statements_; }
+    // nullptr unless expression is the expression of one of the statements,
+    // and compiles
+    const Chunk *chunk(const Expression &expression) const;
+};
+
+// Bounded map from source text to the program it parses to, evicting the
+// least recently used program when full. Entries are keyed by the hash of
+// the source and check the source itself, so a collision is a miss.
+class ParseCache {
+public:
+    struct Stats {
+        size_t hits{0};
+        size_t misses{0};
+        size_t evictions{0};
+
+        // Fraction of lookups that were hits, 0 before the first one
+        double hitRate() const {
+            return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0;
+        }
+    };
+
+private:
+    struct Entry {
+        std::string source;
+        std::shared_ptr<const ParsedProgram> program;
+    };
+
+    // By the hash of the source
+    LruMap<size_t, Entry> entries;
+    bool constantFolding{false};
+    Stats stats_;
+
+public:
+    // A capacity of 0 disables the cache
+    explicit ParseCache(size_t capacity = DEFAULT_PARSE_CACHE_CAPACITY);
+
+    // The program source parses to, lexed and parsed only if it isn't cached.
+    // Lexer and parser errors are thrown, and never cached.
+    std::shared_ptr<const ParsedProgram> parse(std::string_view source);
+
+    // Drops every entry, the statistics are kept
+    void clear();
+    void setCapacity(size_t capacity);
+    // Fold the programs parsed from now on, drops the others
+    void setConstantFolding(bool enabled);
+
+    size_t size() const { return entries.size(); }
+    size_t capacity() const { return entries.capacity(); }
+    const Stats &stats() const { return stats_; }
+    void resetStats() { stats_ = Stats{}; }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+#include "runtime/term.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum MatchOpCode : uint8_t {
+    MATCH_NODE,   // Node of the given type and arity, then its children
+    MATCH_NUMBER, // Number literal with the given value
+    MATCH_TYPE,   // Literal known by its type alone (true, false)
+    MATCH_BIND,   // Bind the subterm to a variable slot
+    MATCH_BOUND,  // Subterm must equal what the slot was bound to before
+};
+
+enum BuildOpCode : uint8_t {
+    BUILD_SLOT,    // Push the subterm bound to a slot
+    BUILD_LITERAL, // Push a literal
+    BUILD_NODE,    // Pop arity children and push a node over them
+};
+
+struct MatchInstruction {
+    MatchOpCode op;
+    TokenType type;
+    uint8_t arity;
+    uint16_t slot;
+    double number;
+};
+
+struct BuildInstruction {
+    BuildOpCode op;
+    TokenType type;
+    uint8_t arity;
+    uint16_t slot;
+    SymbolId symbol;  // Operator of BUILD_NODE
+    uint32_t literal; // Index in literals() of BUILD_LITERAL
+};
+
+// Per caller scratch space, so one compiled matcher can be shared
+struct MatchState {
+    std::vector<const Term *> pending;
+    std::vector<const Term *> slots;
+};
+
+// A rule compiled into flat instruction sequences: the pattern in prefix
+// order, with variables resolved to slots, and the replacement in postfix
+// order. Matching is a single pass over the instructions comparing node types
+// and parsed numbers, with no virtual calls or string compares.
+class PatternMatcher {
+private:
+    std::vector<MatchInstruction> matchCode;
+    std::vector<BuildInstruction> buildCode;
+    // Text of the replacement's literals, which aren't interned
+    std::vector<std::string> literalTexts;
+    size_t slotCount{0};
+
+public:
+    PatternMatcher(const Term *pattern, const Term *replacement);
+    // Instructions compiled before, e.g. read back from a rule library
+    PatternMatcher(std::vector<MatchInstruction> matchCode_,
+                   std::vector<BuildInstruction> buildCode_,
+                   std::vector<std::string> literalTexts_, size_t slotCount_)
+        : matchCode{std::move(matchCode_)}, buildCode{std::move(buildCode_)},
+          literalTexts{std::move(literalTexts_)}, slotCount{slotCount_} {}
+
+    // On success the slots of state hold the bindings for build()
+    bool match(const Term *term, MatchState &state) const;
+    // Instantiates the replacement into table with the bindings of the last
+    // successful match
+    const Term *build(TermTable &table, MatchState &state) const;
+
+    const std::vector<MatchInstruction> &matchInstructions() const { return matchCode; }
+    const std::vector<BuildInstruction> &buildInstructions() const { return buildCode; }
+    const std::vector<std::string> &literals() const { return literalTexts; }
+    size_t slots() const { return slotCount; }
+};
+
+#endif
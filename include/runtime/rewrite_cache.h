@@ -0,0 +1,61 @@
+#ifndef REWRITE_CACHE_H
+#define REWRITE_CACHE_H
+
+#include "runtime/lru_map.h"
+#include "runtime/term.h"
+
+#include <cstddef>
+#include <cstdint>
+
+static constexpr size_t DEFAULT_REWRITE_CACHE_CAPACITY = 1 << 16;
+
+// Bounded map from (rule, term) to the result of substituting the rule into
+// the term, evicting the least recently used entry when full. Terms are
+// hash-consed, so the key is the term's identity and its structural hash;
+// entries are only meaningful for the term table they came from, which
+// has to clear the cache whenever it is cleared itself.
+class RewriteCache {
+public:
+    struct Stats {
+        size_t hits{0};
+        size_t misses{0};
+        size_t evictions{0};
+    };
+
+private:
+    struct Key {
+        uint64_t rule;
+        const Term *term;
+
+        bool operator==(const Key &other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return key.term->hash() ^ (key.rule * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    LruMap<Key, const Term *, KeyHash> results;
+    Stats stats_;
+
+public:
+    // A capacity of 0 disables the cache
+    explicit RewriteCache(size_t capacity = DEFAULT_REWRITE_CACHE_CAPACITY);
+
+    // Result of rewriting term with rule, or nullptr if it isn't cached. A
+    // result equal to term means the rule doesn't match anywhere in it.
+    const Term *find(uint64_t rule, const Term *term);
+    void insert(uint64_t rule, const Term *term, const Term *result);
+
+    // Drops every entry, the statistics are kept
+    void clear();
+    void setCapacity(size_t capacity);
+
+    size_t size() const { return results.size(); }
+    size_t capacity() const { return results.capacity(); }
+    const Stats &stats() const { return stats_; }
+    void resetStats() { stats_ = Stats{}; }
+};
+
+#endif
@@ -2,28 +2,52 @@
 #define RULE_H
 
 #include "parser/expression.h"
+#include "parser/flat_expression.h"
+#include "runtime/pattern_matcher.h"
+#include "runtime/term.h"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <utility>
 
+// A rewrite rule. Pattern and replacement are interned into the rule's own
+// term table and compiled into a matcher once, at definition time, and never
+// change afterwards.
 class Rule {
 private:
-    std::unique_ptr<Expression> pattern_;
-    std::unique_ptr<Expression> replacement_;
+    // Unique for the life of the process, unlike addresses which a
+    // redefinition may reuse
+    static uint64_t nextId() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const uint64_t id_{nextId()};
+    TermTable terms_;
+    const Term *pattern_;
+    const Term *replacement_;
+    PatternMatcher matcher_;
 
 public:
+    Rule(Expression &pattern, Expression &replacement)
+        : pattern_{terms_.intern(pattern)},
+          replacement_{terms_.intern(replacement)},
+          matcher_{pattern_, replacement_} {}
     Rule(std::unique_ptr<Expression> pattern,
          std::unique_ptr<Expression> replacement)
-        : pattern_{std::move(pattern)}, replacement_{std::move(replacement)} {}
-    Rule(Expression &pattern, Expression &replacement)
-        : pattern_{std::unique_ptr<Expression>(&pattern)},
-          replacement_{std::unique_ptr<Expression>(&replacement)} {}
+        : Rule(*pattern, *replacement) {}
+    // With a matcher compiled before from the same pattern and replacement
+    Rule(const FlatExpression &pattern, const FlatExpression &replacement,
+         PatternMatcher matcher)
+        : pattern_{terms_.intern(pattern)},
+          replacement_{terms_.intern(replacement)},
+          matcher_{std::move(matcher)} {}
 
-    std::unique_ptr<Expression> copyPattern() const {
-        return pattern_->clone();
-    }
-    std::unique_ptr<Expression> copyReplacement() const {
-        return replacement_->clone();
-    }
+    uint64_t id() const { return id_; }
+    const Term *pattern() const { return pattern_; }
+    const Term *replacement() const { return replacement_; }
+    const PatternMatcher &matcher() const { return matcher_; }
 };
 
 #endif
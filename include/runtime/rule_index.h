@@ -0,0 +1,122 @@
+#ifndef RULE_INDEX_H
+#define RULE_INDEX_H
+
+#include "lexer/token.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Discrimination tree over the patterns of a rule set.
+//
+// Every pattern is flattened in prefix order into a path of node symbols,
+// with pattern variables becoming wildcards that skip a whole subterm.
+// Looking up a term walks the tree along the term's own prefix order,
+// following both the exact symbol and the wildcard edge, so the cost depends
+// on the size of the patterns rather than the number of rules.
+class RuleIndex {
+private:
+    // Other literals are known by their type too: true and false, and
+    // strings, which are variables in patterns and so never get an edge
+    struct Symbol {
+        TokenType type;
+        uint8_t arity;
+        double number; // Only set for numbers, which compare by value
+
+        bool operator==(const Symbol &other) const = default;
+    };
+
+    struct SymbolHash {
+        size_t operator()(const Symbol &symbol) const;
+    };
+
+    struct Entry {
+        const Rule *rule;
+        size_t order; // Definition order, earlier rules are tried first
+    };
+
+    struct Node {
+        std::unordered_map<Symbol, std::unique_ptr<Node>, SymbolHash> children;
+        std::unique_ptr<Node> wildcard;
+        std::vector<Entry> rules; // Patterns ending here
+
+        Node() = default;
+        Node(Node &&) = default;
+        Node &operator=(Node &&) = default;
+        // Iterative, a pattern's path is as deep as the pattern
+        ~Node();
+    };
+
+    // Subterms still to be matched, a list sharing its tail with the
+    // states it was branched from
+    struct Pending {
+        const Term *term;
+        uint32_t next; // Index of the next cell, NONE at the end
+    };
+    // A position in the tree and the subterms still to be matched from there
+    struct State {
+        const Node *node;
+        uint32_t pending;
+    };
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // An edge taken from a node, the subterm tells which one
+    struct Edge {
+        Node *from;
+        const Term *term;
+    };
+
+    Node root;
+    size_t nextOrder{0};
+    size_t size_{0};
+    size_t nodes_{1};
+
+    static Symbol symbolOf(const Term *term);
+    // Node reached by inserting (or walking) the pattern's path, with the
+    // edges taken appended to trail
+    Node *path(const Term *pattern, bool create, std::vector<Edge> *trail = nullptr);
+
+public:
+    RuleIndex() = default;
+    // Deep copy, the rules themselves are shared
+    RuleIndex(const RuleIndex &other);
+    RuleIndex &operator=(const RuleIndex &other);
+    RuleIndex(RuleIndex &&) = default;
+    RuleIndex &operator=(RuleIndex &&) = default;
+
+    void insert(const Rule *rule);
+    // With an order taken from reserveOrders() before
+    void insert(const Rule *rule, size_t order);
+    // Orders for count rules inserted later, which rank after every rule
+    // inserted so far and before every rule inserted afterwards. Returns
+    // the first.
+    size_t reserveOrders(size_t count);
+    void remove(const Rule *rule);
+
+    // Buffers for looking up candidates, kept by the caller so repeated
+    // lookups don't allocate. One per thread, the index itself is shared.
+    class Scratch {
+    private:
+        friend class RuleIndex;
+        std::vector<Entry> found;
+        std::vector<State> states;
+        std::vector<Pending> pending;
+    };
+
+    // Rules whose pattern might match term, in definition order. Candidates
+    // still have to be matched since repeated variables aren't indexed.
+    std::vector<const Rule *> candidates(const Term *term) const;
+    // Same, but reuses the caller's buffers
+    void candidates(const Term *term, std::vector<const Rule *> &rules, Scratch &scratch) const;
+
+    size_t size() const { return size_; }
+    // Tree nodes including the root, nodes left empty by remove() are freed
+    size_t nodes() const { return nodes_; }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RULE_LIBRARY_H
+#define RULE_LIBRARY_H
+
+#include "carl_constants.h"
+#include "lexer/symbol_table.h"
+#include "runtime/rule.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RuleLibraryError : public std::runtime_error {
+private:
+    const LibraryError code_;
+
+public:
+    RuleLibraryError(LibraryError code, const std::string &message)
+        : std::runtime_error{message}, code_{code} {}
+
+    LibraryError error_code() const noexcept { return code_; }
+};
+
+// Rules compiled ahead of time into a binary image, written by
+// `carl compile` and mapped into memory by open().
+//
+// The image is position independent, its sections refer to each other by
+// offsets from the start of the file, so it is used in place as mapped.
+// Opening a library only checks the header: names are looked up through a
+// hash table stored in the image, and a rule is decoded, together with its
+// precompiled matcher, on its first lookup. Starting with a large library
+// costs nothing for the rules a program doesn't use.
+class RuleLibrary {
+public:
+    // Images of any other version are rejected
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+private:
+    const std::byte *image;
+    size_t imageSize;
+
+    // Decoded rules, shared with every RuleSet that found them
+    mutable std::mutex mutex;
+    mutable std::unordered_map<uint32_t, std::shared_ptr<const Rule>> decoded;
+
+    RuleLibrary(const std::byte *image_, size_t imageSize_)
+        : image{image_}, imageSize{imageSize_} {}
+
+    std::shared_ptr<const Rule> decode(uint32_t index) const;
+
+public:
+    // Rules in definition order, a name may only appear once
+    static void write(std::ostream &out,
+                      const std::vector<std::pair<SymbolId, const Rule *>> &rules);
+    // Throws RuleLibraryError if path can't be read or isn't a library
+    static std::shared_ptr<const RuleLibrary> open(const std::string &path);
+
+    RuleLibrary(const RuleLibrary &) = delete;
+    RuleLibrary &operator=(const RuleLibrary &) = delete;
+    ~RuleLibrary();
+
+    size_t size() const;
+    std::string_view name(uint32_t index) const;
+    // Index of the rule called name, or NONE
+    uint32_t find(std::string_view name) const;
+    // Decoded on the first call for index, the same rule afterwards. Throws
+    // RuleLibraryError if the rule's part of the image is corrupt.
+    std::shared_ptr<const Rule> rule(uint32_t index) const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define RUNTIME_ERRORS_H
 
 #include "carl_constants.h"
+#include "lexer/line_index.h"
 #include "lexer/token.h"
 #include <cassert>
 #include <cstdint>
@@ -9,40 +10,28 @@
 #include <fmt/core.h>
 #include <format>
 #include <string_view>
-#include <tuple>
 
 class RuntimeException : public std::exception {
     protected:
-        const uint16_t sourceOffset_;
-        const uint16_t length_;
-        static inline std::tuple<uint16_t, uint16_t> calculateLineNumber(const std::string_view source, const uint16_t sourceOffset) {
-            assert((source.size() >= sourceOffset) && "Could not calculate line number since the offset exceeds the bounds of the source string given");
-
-            uint16_t lineNumber{0};
-            uint16_t offsetToLineNumber{0};
-            for (uint16_t offset = 0; offset != sourceOffset; offset++) {
-                if (source[offset] == '\n') {
-                    lineNumber++;
-                    offsetToLineNumber = offset;
-                }
-            }
-            return std::make_tuple(lineNumber, sourceOffset - offsetToLineNumber);
-        }
-        std::string locationPrefix(std::string_view source) const {
-            uint16_t startLineNumber;
-            uint16_t startCharacterIndex;
-            std::tie(startLineNumber, startCharacterIndex) = RuntimeException::calculateLineNumber(source, sourceOffset_);
-
-            uint16_t endLineNumber;
-            uint16_t endCharacterIndex;
-            std::tie(endLineNumber, endCharacterIndex) = RuntimeException::calculateLineNumber(source, sourceOffset_ + length_);
-            return std::format("{}:{} - {}:{}", startLineNumber, startCharacterIndex, endLineNumber, endCharacterIndex);
+        const uint32_t sourceOffset_;
+        const uint32_t length_;
+        std::string locationPrefix(const LineIndex &lines) const {
+            return lines.describe(sourceOffset_, length_);
         }
+        // The error message, given where in the source the error is
+        virtual std::string describe(const std::string &location) const = 0;
     public:
-        RuntimeException(const uint16_t sourceOffset, const uint16_t length) : sourceOffset_{sourceOffset}, length_{length} {}
+        RuntimeException(const uint32_t sourceOffset, const uint32_t length) : sourceOffset_{sourceOffset}, length_{length} {}
         RuntimeException(const Token& token) : sourceOffset_{token.sourceOffset()}, length_{token.length()} {}
 
-        virtual const std::string what(std::string_view source) const noexcept = 0;
+        // Builds a line index for source, prefer passing one that is kept
+        // around when reporting several errors in the same source
+        const std::string what(std::string_view source) const noexcept {
+            return what(LineIndex{source});
+        }
+        const std::string what(const LineIndex &lines) const noexcept {
+            return describe(locationPrefix(lines));
+        }
         virtual const RuntimeError error_code() const noexcept = 0;
 };
 
@@ -50,11 +39,12 @@ class TypeMismatch : public RuntimeException {
     private:
         const std::string reason_;
     public:
-        TypeMismatch(const uint16_t sourceOffset, const uint16_t length) : RuntimeException(sourceOffset, length) {}
+        TypeMismatch(const uint32_t sourceOffset, const uint32_t length) : RuntimeException(sourceOffset, length) {}
+        TypeMismatch(const uint32_t sourceOffset, const uint32_t length, std::string reason) : RuntimeException(sourceOffset, length), reason_{reason} {}
         TypeMismatch(const Token& token, std::string reason) : RuntimeException(token), reason_{reason} {}
 
-        virtual const std::string what(std::string_view source) const noexcept override {
-            return fmt::format("{} {}", locationPrefix(source), reason_);
+        std::string describe(const std::string &location) const override {
+            return fmt::format("{} {}", location, reason_);
         }
         virtual const RuntimeError error_code() const noexcept override {
             return RuntimeError::TYPE_MISMATCH;
@@ -65,16 +55,61 @@ class NoRuleFound : public RuntimeException {
     private:
         const std::string reason_;
     public:
-        NoRuleFound(const uint16_t sourceOffset, const uint16_t length) : RuntimeException(sourceOffset, length) {}
+        NoRuleFound(const uint32_t sourceOffset, const uint32_t length) : RuntimeException(sourceOffset, length) {}
         NoRuleFound(const Token& token, std::string reason) : RuntimeException(token), reason_{reason} {}
 
-        virtual const std::string what(std::string_view source) const noexcept override {
-            return fmt::format("{} {}", locationPrefix(source), reason_);
+        std::string describe(const std::string &location) const override {
+            return fmt::format("{} {}", location, reason_);
         }
         virtual const RuntimeError error_code() const noexcept override {
             return RuntimeError::NO_RULE_FOUND;
         }
 };
 
+class RewriteLimitExceeded : public RuntimeException {
+    private:
+        const std::string reason_;
+    public:
+        RewriteLimitExceeded(const uint32_t sourceOffset, const uint32_t length, std::string reason) : RuntimeException(sourceOffset, length), reason_{reason} {}
+        RewriteLimitExceeded(const Token& token, std::string reason) : RuntimeException(token), reason_{reason} {}
+
+        std::string describe(const std::string &location) const override {
+            return fmt::format("{} {}", location, reason_);
+        }
+        virtual const RuntimeError error_code() const noexcept override {
+            return RuntimeError::REWRITE_LIMIT_EXCEEDED;
+        }
+};
+
+// More distinct constants than a chunk can address
+class TooManyConstants : public RuntimeException {
+    private:
+        const size_t limit_;
+    public:
+        TooManyConstants(const uint32_t sourceOffset, const uint32_t length, size_t limit) : RuntimeException(sourceOffset, length), limit_{limit} {}
+
+        std::string describe(const std::string &location) const override {
+            return fmt::format("{} Expression has more than {} constants", location, limit_);
+        }
+        virtual const RuntimeError error_code() const noexcept override {
+            return RuntimeError::TOO_MANY_CONSTANTS;
+        }
+};
+
+// An expression the compiler or the VM has no instruction for
+class InternalError : public RuntimeException {
+    private:
+        const std::string reason_;
+    public:
+        InternalError(const uint32_t sourceOffset, const uint32_t length, std::string reason) : RuntimeException(sourceOffset, length), reason_{reason} {}
+        InternalError(const Token& token, std::string reason) : RuntimeException(token), reason_{reason} {}
+
+        std::string describe(const std::string &location) const override {
+            return fmt::format("{} Internal Error, {}", location, reason_);
+        }
+        virtual const RuntimeError error_code() const noexcept override {
+            return RuntimeError::INTERNAL_ERROR;
+        }
+};
 
 #endif
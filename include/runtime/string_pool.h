@@ -0,0 +1,51 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Size-class allocator for string objects.
+//
+// Requests are rounded up to the next power of two between MIN_CLASS_SIZE and
+// MAX_CLASS_SIZE and served from a free list for that class, which is refilled
+// by carving up slabs. Freed blocks go back on their free list and slabs are
+// only released when the thread exits, so repeatedly creating and dropping
+// strings does not grow memory. Larger requests go straight to the heap.
+//
+// Each thread has its own pool, a block must be freed on the thread that
+// allocated it.
+class StringPool {
+public:
+    static constexpr size_t MIN_CLASS_SIZE = 16;
+    static constexpr size_t MAX_CLASS_SIZE = 512;
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+    static StringPool &local();
+
+    // size must be passed again to deallocate, blocks carry no header
+    void *allocate(size_t size);
+    void deallocate(void *pointer, size_t size) noexcept;
+
+    size_t liveBlocks() const { return liveBlocks_; }
+    size_t bytesReserved() const { return bytesReserved_; }
+
+private:
+    static constexpr size_t CLASS_COUNT = 6; // 16, 32, ..., 512
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static size_t classOf(size_t size);
+
+    std::array<FreeBlock *, CLASS_COUNT> freeLists{};
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+    size_t liveBlocks_{0};
+    size_t bytesReserved_{0};
+
+    void refill(size_t sizeClass);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef TERM_H
+#define TERM_H
+
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "parser/flat_expression.h"
+#include "parser/tree_printer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// Immutable expression node. Terms are only created through a TermTable which
+// hash-conses them: structurally identical terms interned in the same table
+// are the same object, so equality is a pointer compare and identical
+// subexpressions are stored once.
+class Term {
+private:
+    TokenType type_;    // Literal type or operator
+    uint8_t arity_;     // 0 for literals, 1 for unary and 2 for binary operators
+    SymbolId symbol_;   // The operator's lexeme, empty for literals
+    // Literal text, kept by the table, or the name of symbol_
+    const std::string *literal_;
+    const Term *children_[2];
+    size_t hash_;       // Structural, so equal across tables
+    double number_{0};  // Parsed value of number literals
+
+    friend class TermTable;
+
+public:
+    Term(TokenType type, SymbolId symbol, const std::string *literal,
+         const Term *left, const Term *right, size_t hash)
+        : type_{type}, arity_{static_cast<uint8_t>((left != nullptr) + (right != nullptr))},
+          symbol_{symbol}, literal_{literal}, children_{left, right}, hash_{hash} {
+        if (type == TokenType::NUMBER)
+            number_ = std::strtod(literal->c_str(), nullptr);
+    }
+
+    TokenType type() const { return type_; }
+    uint8_t arity() const { return arity_; }
+    SymbolId symbol() const { return symbol_; }
+    const std::string &literal() const { return *literal_; }
+    size_t hash() const { return hash_; }
+    double number() const { return number_; }
+
+    const Term *child(size_t index) const { return children_[index]; }
+    const Term *left() const { return children_[0]; }
+    const Term *right() const { return children_[1]; }
+    const Term *operand() const { return children_[0]; }
+
+    // Pattern variables are written as strings, ex: "A" + 0
+    bool isVariable() const { return arity_ == 0 && type_ == TokenType::STRING; }
+};
+
+template <> struct TreeTraits<Term> {
+    static size_t arity(const Term &node) { return node.arity(); }
+    static const Term &child(const Term &node, size_t index) {
+        return *node.child(index);
+    }
+    static std::string_view spelling(const Term &node) { return node.literal(); }
+};
+
+class TermTable {
+private:
+    struct Key {
+        TokenType type;
+        SymbolId symbol;
+        std::string_view literal; // Only set for literals
+        const Term *left;
+        const Term *right;
+        size_t hash;
+    };
+
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(const Term *term) const { return term->hash(); }
+        size_t operator()(const Key &key) const { return key.hash; }
+    };
+
+    struct Equal {
+        using is_transparent = void;
+        bool operator()(const Term *a, const Term *b) const { return a == b; }
+        bool operator()(const Key &key, const Term *term) const {
+            return key.type == term->type() && key.left == term->left() &&
+                   key.right == term->right() && key.symbol == term->symbol() &&
+                   (key.left != nullptr || key.literal == term->literal());
+        }
+        bool operator()(const Term *term, const Key &key) const {
+            return (*this)(key, term);
+        }
+    };
+
+    std::deque<Term> storage; // Stable addresses
+    std::unordered_set<const Term *, Hash, Equal> terms;
+    // Text of the literal terms, kept here rather than in the global symbol
+    // table so clear() frees it with them
+    std::deque<std::string> literals;
+
+    const Term *make(const Key &key);
+
+public:
+    TermTable() = default;
+    TermTable(const TermTable &) = delete;
+    TermTable &operator=(const TermTable &) = delete;
+
+    // Operator spelled symbol, over one or two operands
+    const Term *make(TokenType type, SymbolId symbol, const Term *left,
+                     const Term *right = nullptr);
+    // Literal, its text is copied into the table the first time
+    const Term *make(TokenType type, std::string_view literal);
+    // Same shape as term, but with its children replaced
+    const Term *withChildren(const Term *term, const Term *left,
+                             const Term *right);
+
+    const Term *intern(Expression &expression);
+    // One linear pass, operands are interned before their operator
+    const Term *intern(const FlatExpression &expression);
+    // Copies a term interned in another table into this one
+    const Term *import(const Term *term);
+
+    static std::unique_ptr<Expression> toExpression(const Term *term);
+    // Shared subterms are written out once per occurrence
+    static FlatExpression toFlat(const Term *term);
+    // Same format as Expression::toString(), see printTree() to print
+    // without building a string
+    static std::string toString(const Term *term);
+
+    size_t size() const { return storage.size(); }
+    void clear();
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with a task deque each.
+//
+// Workers run tasks from the back of their own deque and, once it is empty,
+// steal from the front of the others, so a batch with uneven costs still
+// keeps every thread busy. Batches are submitted with parallelFor(), from one
+// thread at a time.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    // Calls body(index, worker) for every index in [0, count), in tasks of
+    // grain consecutive indices, and returns once all of them are done. If
+    // body throws, the remaining tasks are skipped and the first exception
+    // is rethrown here.
+    template <typename Body>
+    void parallelFor(size_t count, size_t grain, Body &&body) {
+        grain = std::max<size_t>(grain, 1);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        std::atomic<bool> failed{false};
+
+        std::vector<Task> tasks;
+        tasks.reserve((count + grain - 1) / grain);
+        for (size_t begin = 0; begin < count; begin += grain) {
+            const size_t end = std::min(begin + grain, count);
+            tasks.push_back([&, begin, end](size_t worker) {
+                if (failed.load(std::memory_order_relaxed))
+                    return;
+                try {
+                    for (size_t index = begin; index < end; index++)
+                        body(index, worker);
+                } catch (...) {
+                    std::lock_guard lock{errorMutex};
+                    if (!failed.exchange(true))
+                        error = std::current_exception();
+                }
+            });
+        }
+
+        run(std::move(tasks));
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;     // Tasks were queued, or stopping
+    std::condition_variable finished; // The last pending task is done
+    size_t queued{0};  // Tasks not yet taken by a worker
+    size_t pending{0}; // Tasks not yet finished
+    bool stopping{false};
+
+    void run(std::vector<Task> tasks);
+    bool take(size_t worker, Task &task);
+    void work(size_t worker);
+};
+
+#endif
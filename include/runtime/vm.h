@@ -0,0 +1,27 @@
+#ifndef VM_H
+#define VM_H
+
+#include "runtime/carl_object.h"
+#include "runtime/chunk.h"
+
+#include <string>
+#include <vector>
+
+// Stack machine executing chunks produced by the Compiler
+class VM {
+private:
+    // Sized once per chunk from Chunk::maxStackDepth(), never grows while
+    // running
+    std::vector<Value> stack;
+
+    [[noreturn]] void typeMismatch(const Chunk &chunk, const uint8_t *ip,
+                                   const Value *top, const char *reason);
+    // For chunks the compiler can't have produced
+    [[noreturn]] void internalError(const Chunk &chunk, const uint8_t *ip,
+                                    const Value *top, std::string reason);
+
+public:
+    Value run(const Chunk &chunk);
+};
+
+#endif
@@ -1,99 +1,312 @@
+#include "carl_stats.h"
 #include "lexer/lexer.h"
 #include "lexer/lexer_errors.h"
+#include "lexer/line_index.h"
+#include "lexer/statement_reader.h"
+#include "parser/constant_folder.h"
+#include "parser/parallel_parser.h"
 #include "parser/parser.h"
 #include "parser/parser_errors.h"
+#include "parser/statement.h"
 #include "runtime/interpreter.h"
+#include "runtime/parse_cache.h"
+#include "runtime/rule.h"
+#include "runtime/rule_library.h"
 #include "runtime/runtime_errors.h"
 
 #include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define PROMPT "> "
 #define OUTPUT_PADDING "\t# "
 
-int main(int argc, char *argv[]) {
-    // Repl mode
-    if (argc < 2) {
-        Interpreter interpreter;
-        while (true) {
-            std::cout << PROMPT;
-            std::string input;
-            std::getline(std::cin, input);
+static void usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--tokens] [--fold] [--stats] [--stats-json FILE]"
+                 " [--rules LIBRARY] [FILE | - | -e PROGRAM]\n"
+              << "       " << program << " [--fold] compile FILE -o LIBRARY\n"
+              << "  FILE        run the statements in FILE, '-' for stdin\n"
+              << "  -e PROGRAM  run PROGRAM given on the command line\n"
+              << "  compile     compile the rules defined in FILE into a "
+                 "library\n"
+              << "  --rules LIBRARY\n"
+              << "              start with the rules of a compiled library "
+                 "defined\n"
+              << "  --tokens    print the tokens of each statement before it "
+                 "runs\n"
+              << "  --fold      fold numeric subtrees like 2 * 3 before "
+                 "evaluating or rewriting\n"
+              << "  --stats     print time spent per stage and hot path "
+                 "counters to stderr on exit\n"
+              << "  --stats-json FILE\n"
+              << "              write the same statistics to FILE as JSON\n"
+              << "Without arguments a REPL is started, or stdin is run when "
+                 "it is not a terminal."
+              << std::endl;
+}
 
-            if (input == "quit" || input == "q" || input == ":q" || input == "exit")
-                return 0;
+struct Options {
+    bool dumpTokens{false};
+    bool constantFolding{false};
+    bool stats{false};
+    const char *statsJson{nullptr};
+    std::shared_ptr<const RuleLibrary> library;
+};
 
-            try {
-                // Lexing
-                Lexer lexer{input};
-                auto tokens = lexer.tokenize();
-
-                // Parsing
-                Parser parser{tokens};
-                auto statements = parser.parse();
-
-                // Interpret
-                std::optional<Value> result = interpreter.interpret(std::move(statements));
-                if (result.has_value()) {
-                    std::cout << OUTPUT_PADDING << result->toString() << std::endl;
-                }
-            } catch (const LexerException &le) {
-                std::string_view sv{input.begin(), input.end()};
-                std::cerr << "Lexer Error: " << le.what(sv) << std::endl;
-            } catch (const ParserException &pe) {
-                std::string_view sv{input.begin(), input.end()};
-                std::cerr << "Parser Error: " << pe.what(sv) << std::endl;
-            } catch (const RuntimeException &re) {
-                std::string_view sv{input.begin(), input.end()};
-                std::cerr << "Runtime Error: " << re.what(sv) << std::endl;
-            }
-        }
+static void printTokens(const std::vector<Token> &tokens,
+                        std::string_view source) {
+    for (const Token &token : tokens) {
+        const std::string_view text = token.text(source);
+        printf("%s(%.*s, off: %u, l: %u)\n",
+               TokenTypesToString[token.type()].data(),
+               static_cast<int>(text.size()), text.data(),
+               token.sourceOffset(), token.length());
+    }
+}
+
+// An interpreter, and the programs it ran before
+struct Session {
+    Interpreter interpreter;
+    ParseCache programs;
 
-        return 0;
+    Session(const Options &options) {
+        interpreter.setConstantFolding(options.constantFolding);
+        programs.setConstantFolding(options.constantFolding);
+        if (options.library)
+            interpreter.loadLibrary(options.library);
     }
-    // One line mode
-    std::string src{argv[1]};
-    Lexer lexer(src);
+};
 
-    std::vector<Token> tokens;
+// Runs one piece of source, printing errors against lines. Returns the error
+// code, or 0 on success.
+static int run(Session &session, std::string_view source,
+               const LineIndex &lines, const Options &options) {
     try {
-        tokens = lexer.tokenize();
-
-        printf("\nTokens:\n");
-        for (Token token : tokens) {
-            printf("%s(%s, off: %d, l: %d)\n",
-                   TokenTypesToString[token.type()].data(),
-                   token.literal().data(), token.sourceOffset(),
-                   token.length());
+        std::optional<Value> result;
+        if (options.dumpTokens) {
+            // Lexing
+            Lexer lexer{source};
+            auto tokens = lexer.tokenize();
+            printTokens(tokens, source);
+
+            // Parsing
+            Parser parser{std::move(tokens), source};
+            result = session.interpreter.interpret(parser.parse());
+        } else {
+            // Inputs seen before aren't lexed and parsed again
+            result = session.interpreter.interpret(session.programs.parse(source));
         }
-        Parser parser{tokens};
-        auto statements = parser.parse();
-        Interpreter interpreter(std::move(statements));
-
-        auto lastOutput = interpreter.interpret();
-        if (lastOutput.has_value()) {
-            lastOutput.value().dispose();
-            std::cout << lastOutput.value().toString() << std::endl;
+
+        if (result.has_value()) {
+            std::cout << OUTPUT_PADDING << result->toString() << std::endl;
+            result->dispose();
         }
     } catch (const LexerException &le) {
-        std::string_view sv{src.begin(), src.end()};
-        std::cerr << "Lexer Error: " << le.what(sv) << std::endl;
-
-        exit(le.error_code());
+        std::cerr << "Lexer Error: " << le.what(lines) << std::endl;
+        return le.error_code();
     } catch (const ParserException &pe) {
-        std::string_view sv{src.begin(), src.end()};
-        std::cerr << "Parser Error: " << pe.what(sv) << std::endl;
-
-        exit(pe.error_code());
+        std::cerr << "Parser Error: " << pe.what(lines) << std::endl;
+        return pe.error_code();
     } catch (const RuntimeException &re) {
-        std::string_view sv{src.begin(), src.end()};
-        std::cerr << "Runtime Error: " << re.what(sv) << std::endl;
+        std::cerr << "Runtime Error: " << re.what(lines) << std::endl;
+        return re.error_code();
+    } catch (const RuleLibraryError &le) {
+        // Library rules are decoded when a statement first uses them
+        std::cerr << "Library Error: " << le.what() << std::endl;
+        return le.error_code();
+    }
+    return 0;
+}
 
-        exit(re.error_code());
+// Executes input one statement at a time as it is read, stopping at the first
+// error
+static int stream(std::istream &input, const Options &options) {
+    Session session{options};
+    // A file's statements rarely repeat, caching them would only keep their
+    // programs and literals alive until the whole file has run
+    session.programs.setCapacity(0);
+    StatementReader reader{input};
+    while (auto statement = reader.next()) {
+        // Errors are reported relative to the whole input
+        LineIndex lines{*statement, reader.line(), reader.column()};
+        if (int error = run(session, *statement, lines, options))
+            return error;
+    }
+    return 0;
+}
+
+static int repl(const Options &options) {
+    Session session{options};
+    while (true) {
+        std::cout << PROMPT;
+        std::string input;
+        if (!std::getline(std::cin, input))
+            return 0;
+
+        if (input == "quit" || input == "q" || input == ":q" || input == "exit")
+            return 0;
+
+        run(session, input, LineIndex{input}, options);
+    }
+}
+
+static int printStats(const Options &options) {
+    if (!Stats::compiledIn()) {
+        std::cerr << "Statistics are unavailable, carl was built without "
+                     "CARL_STATS"
+                  << std::endl;
+        return 1;
     }
 
+    Stats::Snapshot snapshot = Stats::snapshot();
+    if (options.stats)
+        Stats::printTable(std::cerr, snapshot);
+    if (options.statsJson) {
+        std::ofstream json{options.statsJson};
+        if (!json) {
+            std::cerr << "Could not open '" << options.statsJson << "'"
+                      << std::endl;
+            return 1;
+        }
+        Stats::printJson(json, snapshot);
+    }
     return 0;
 }
+
+// Compiles the rules defined in input into a library written to output.
+// Like defining them one after another, a redefinition replaces the earlier
+// rule and ranks after all others.
+static int compile(const char *input, const char *output,
+                   const Options &options) {
+    std::ifstream file{input, std::ios::binary};
+    if (!file) {
+        std::cerr << "Could not open '" << input << "'" << std::endl;
+        return 1;
+    }
+    const std::string source{std::istreambuf_iterator<char>(file), {}};
+    const LineIndex lines{source};
+
+    std::vector<std::unique_ptr<Statement>> statements;
+    try {
+        // Rule files get large, their statements are parsed on all cores
+        ParallelParser parser;
+        statements = parser.parse(source);
+    } catch (const LexerException &le) {
+        std::cerr << "Lexer Error: " << le.what(lines) << std::endl;
+        return le.error_code();
+    } catch (const ParserException &pe) {
+        std::cerr << "Parser Error: " << pe.what(lines) << std::endl;
+        return pe.error_code();
+    }
+
+    std::vector<std::pair<SymbolId, std::unique_ptr<Rule>>> rules;
+    std::unordered_map<SymbolId, size_t> latest;
+    ConstantFolder folder;
+    for (auto &statement : statements) {
+        auto *definition = dynamic_cast<DefineStatement *>(statement.get());
+        if (definition == nullptr) {
+            std::cerr << "Only define statements can be compiled" << std::endl;
+            return 1;
+        }
+        if (options.constantFolding)
+            folder.fold(*definition);
+        latest[definition->ruleSymbol()] = rules.size();
+        rules.emplace_back(definition->ruleSymbol(),
+                           std::make_unique<Rule>(definition->pattern(),
+                                                  definition->replacement()));
+    }
+
+    std::vector<std::pair<SymbolId, const Rule *>> library;
+    for (size_t i = 0; i < rules.size(); i++)
+        if (latest[rules[i].first] == i)
+            library.emplace_back(rules[i].first, rules[i].second.get());
+
+    std::ofstream out{output, std::ios::binary | std::ios::trunc};
+    try {
+        RuleLibrary::write(out, library);
+    } catch (const RuleLibraryError &le) {
+        std::cerr << "Library Error: " << le.what() << std::endl;
+        return le.error_code();
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "Could not write '" << output << "'" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Runs what the arguments after the options ask for
+static int start(int arg, int argc, char *argv[], const Options &options) {
+    if (arg + 4 == argc && std::strcmp(argv[arg], "compile") == 0 &&
+        std::strcmp(argv[arg + 2], "-o") == 0)
+        return compile(argv[arg + 1], argv[arg + 3], options);
+
+    if (arg == argc) {
+        if (isatty(STDIN_FILENO))
+            return repl(options);
+        return stream(std::cin, options);
+    }
+
+    if (arg + 1 == argc && std::strcmp(argv[arg], "-") == 0)
+        return stream(std::cin, options);
+
+    if (arg + 2 == argc && std::strcmp(argv[arg], "-e") == 0) {
+        Session session{options};
+        std::string_view program{argv[arg + 1]};
+        return run(session, program, LineIndex{program}, options);
+    }
+
+    if (arg + 1 != argc || argv[arg][0] == '-') {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file{argv[arg], std::ios::binary};
+    if (!file) {
+        std::cerr << "Could not open '" << argv[arg] << "'" << std::endl;
+        return 1;
+    }
+    return stream(file, options);
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        if (std::strcmp(argv[arg], "--tokens") == 0)
+            options.dumpTokens = true;
+        else if (std::strcmp(argv[arg], "--fold") == 0)
+            options.constantFolding = true;
+        else if (std::strcmp(argv[arg], "--stats") == 0)
+            options.stats = true;
+        else if (std::strcmp(argv[arg], "--stats-json") == 0 && arg + 1 < argc)
+            options.statsJson = argv[++arg];
+        else if (std::strcmp(argv[arg], "--rules") == 0 && arg + 1 < argc) {
+            try {
+                options.library = RuleLibrary::open(argv[++arg]);
+            } catch (const RuleLibraryError &le) {
+                std::cerr << "Library Error: " << le.what() << std::endl;
+                return le.error_code();
+            }
+        } else
+            break;
+    }
+
+    const bool stats = options.stats || options.statsJson;
+    Stats::setEnabled(stats);
+    int status = start(arg, argc, argv, options);
+    if (stats && printStats(options) != 0 && status == 0)
+        status = 1;
+    return status;
+}
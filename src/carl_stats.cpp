@@ -0,0 +1,129 @@
+#include "carl_stats.h"
+
+#include <fmt/core.h>
+#include <mutex>
+#include <vector>
+
+const std::string_view StatCounterNames[STAT_COUNTER_COUNT] = {
+    "tokens",
+    "symbol_interns",
+    "statements",
+    "visit_literal",
+    "visit_unary",
+    "visit_binary",
+    "rule_tries",
+    "rule_rewrites",
+    "match_attempts",
+    "match_hits",
+    "cloned_nodes",
+    "string_allocations",
+    "parse_cache_hits",
+    "parse_cache_misses",
+};
+
+const std::string_view StatTimerNames[STAT_TIMER_COUNT] = {
+    "lex",
+    "parse",
+    "visit_expression",
+    "visit_define",
+    "visit_apply",
+    "visit_normalize",
+    "visit_show",
+};
+
+std::atomic<bool> Stats::enabled_{false};
+
+namespace {
+// Blocks of the running threads, and the totals of the exited ones
+struct Registry {
+    std::mutex mutex;
+    std::vector<void *> blocks; // Stats::Block, which is private
+    Stats::Snapshot retired;
+};
+
+// Never destroyed, threads may exit after static destructors ran
+Registry &registry() {
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+template <size_t N>
+void accumulate(uint64_t (&totals)[N], const std::atomic<uint64_t> (&values)[N]) {
+    for (size_t i = 0; i < N; i++)
+        totals[i] += values[i].load(std::memory_order_relaxed);
+}
+} // namespace
+
+Stats::Block::Block() {
+    Registry &shared = registry();
+    std::lock_guard lock{shared.mutex};
+    shared.blocks.push_back(this);
+}
+
+Stats::Block::~Block() {
+    Registry &shared = registry();
+    std::lock_guard lock{shared.mutex};
+    accumulate(shared.retired.counters, counters);
+    accumulate(shared.retired.calls, calls);
+    accumulate(shared.retired.nanoseconds, nanoseconds);
+    std::erase(shared.blocks, this);
+}
+
+Stats::Snapshot Stats::snapshot() {
+    Registry &shared = registry();
+    std::lock_guard lock{shared.mutex};
+    Snapshot totals = shared.retired;
+    for (void *pointer : shared.blocks) {
+        const Block &block = *static_cast<const Block *>(pointer);
+        accumulate(totals.counters, block.counters);
+        accumulate(totals.calls, block.calls);
+        accumulate(totals.nanoseconds, block.nanoseconds);
+    }
+    return totals;
+}
+
+void Stats::reset() {
+    Registry &shared = registry();
+    std::lock_guard lock{shared.mutex};
+    shared.retired = Snapshot{};
+    // Blocks are only written by their own thread, so this races with
+    // threads that are counting; reset while the other threads are idle
+    for (void *pointer : shared.blocks) {
+        Block &block = *static_cast<Block *>(pointer);
+        for (auto &counter : block.counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < STAT_TIMER_COUNT; i++) {
+            block.calls[i].store(0, std::memory_order_relaxed);
+            block.nanoseconds[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Stats::printTable(std::ostream &out, const Snapshot &snapshot) {
+    out << fmt::format("{:<20} {:>12} {:>14} {:>12}\n", "stage", "calls",
+                       "total ms", "mean us");
+    for (size_t i = 0; i < STAT_TIMER_COUNT; i++) {
+        const uint64_t calls = snapshot.calls[i];
+        const double nanoseconds = static_cast<double>(snapshot.nanoseconds[i]);
+        out << fmt::format("{:<20} {:>12} {:>14.3f} {:>12.3f}\n",
+                           StatTimerNames[i], calls, nanoseconds / 1e6,
+                           calls ? nanoseconds / 1e3 / calls : 0.0);
+    }
+    out << fmt::format("\n{:<20} {:>12}\n", "counter", "count");
+    for (size_t i = 0; i < STAT_COUNTER_COUNT; i++)
+        out << fmt::format("{:<20} {:>12}\n", StatCounterNames[i],
+                           snapshot.counters[i]);
+}
+
+void Stats::printJson(std::ostream &out, const Snapshot &snapshot) {
+    out << "{\n  \"timers\": {";
+    for (size_t i = 0; i < STAT_TIMER_COUNT; i++)
+        out << fmt::format("{}\n    \"{}\": {{\"calls\": {}, \"nanoseconds\": {}}}",
+                           i ? "," : "", StatTimerNames[i], snapshot.calls[i],
+                           snapshot.nanoseconds[i]);
+    out << "\n  },\n  \"counters\": {";
+    for (size_t i = 0; i < STAT_COUNTER_COUNT; i++)
+        out << fmt::format("{}\n    \"{}\": {}", i ? "," : "",
+                           StatCounterNames[i], snapshot.counters[i]);
+    out << "\n  }\n}\n";
+}
@@ -0,0 +1,179 @@
+#include "lexer/char_scan.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CARL_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+using Scan = size_t (*)(const char *text, size_t from, size_t end);
+
+struct Scanners {
+    Scan whitespace;
+    Scan digits;
+    Scan identifier;
+};
+
+#ifdef CARL_SCAN_X86
+// The AVX2 code is compiled for AVX2 on its own, the rest of carl keeps
+// running on any x86-64
+#define CARL_AVX2 __attribute__((target("avx2")))
+
+// Bytes of v from low to high, compared unsigned after subtracting low
+inline __m128i inRange(__m128i v, char low, char high) {
+    const __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(high - low)), offset);
+}
+
+CARL_AVX2 inline __m256i inRange(__m256i v, char low, char high) {
+    const __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(low));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(high - low)), offset);
+}
+#endif
+
+// A character class, tested one character at a time, and for 16 and 32 at
+// once by setting the bytes of a vector that are in it
+struct Whitespace {
+    static bool contains(char c) { return isWhitespaceCharacter(c); }
+#ifdef CARL_SCAN_X86
+    static __m128i contains(__m128i v) {
+        return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    }
+    CARL_AVX2 static __m256i contains(__m256i v) {
+        return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                               _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+    }
+#endif
+};
+
+struct Digits {
+    static bool contains(char c) { return isDigitCharacter(c); }
+#ifdef CARL_SCAN_X86
+    static __m128i contains(__m128i v) { return inRange(v, '0', '9'); }
+    CARL_AVX2 static __m256i contains(__m256i v) { return inRange(v, '0', '9'); }
+#endif
+};
+
+struct Identifier {
+    static bool contains(char c) { return isIdentifierCharacter(c); }
+#ifdef CARL_SCAN_X86
+    // Setting 0x20 lowercases letters
+    static __m128i contains(__m128i v) {
+        return _mm_or_si128(inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+                            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+                                         _mm_cmpeq_epi8(v, _mm_set1_epi8('-'))));
+    }
+    CARL_AVX2 static __m256i contains(__m256i v) {
+        return _mm256_or_si256(
+            inRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'))));
+    }
+#endif
+};
+
+template <typename Class> size_t scalarScan(const char *text, size_t from, size_t end) {
+    while (from < end && Class::contains(text[from]))
+        from++;
+    return from;
+}
+
+const Scanners scalarScanners{scalarScan<Whitespace>, scalarScan<Digits>,
+                              scalarScan<Identifier>};
+
+#ifdef CARL_SCAN_X86
+template <typename Class> size_t sse2Scan(const char *text, size_t from, size_t end) {
+    for (; from + 16 <= end; from += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + from));
+        const unsigned outside =
+            ~static_cast<unsigned>(_mm_movemask_epi8(Class::contains(v))) & 0xffff;
+        if (outside != 0)
+            return from + __builtin_ctz(outside);
+    }
+    return scalarScan<Class>(text, from, end);
+}
+
+const Scanners sse2Scanners{sse2Scan<Whitespace>, sse2Scan<Digits>, sse2Scan<Identifier>};
+
+// Tails shorter than 32 characters go through SSE2
+template <typename Class>
+CARL_AVX2 size_t avx2Scan(const char *text, size_t from, size_t end) {
+    for (; from + 32 <= end; from += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + from));
+        const unsigned outside = ~static_cast<unsigned>(_mm256_movemask_epi8(Class::contains(v)));
+        if (outside != 0)
+            return from + __builtin_ctz(outside);
+    }
+    return sse2Scan<Class>(text, from, end);
+}
+
+const Scanners avx2Scanners{avx2Scan<Whitespace>, avx2Scan<Digits>, avx2Scan<Identifier>};
+#endif
+
+const Scanners &scannersFor(ScanLevel level) {
+    switch (level) {
+#ifdef CARL_SCAN_X86
+    case ScanLevel::AVX2:
+        return avx2Scanners;
+    case ScanLevel::SSE2:
+        return sse2Scanners;
+#endif
+    default:
+        return scalarScanners;
+    }
+}
+
+struct Selection {
+    ScanLevel level;
+    const Scanners *scanners;
+};
+
+Selection &selection() {
+    static Selection selection{supportedScanLevel(), &scannersFor(supportedScanLevel())};
+    return selection;
+}
+} // namespace
+
+ScanLevel supportedScanLevel() {
+#ifdef CARL_SCAN_X86
+    return __builtin_cpu_supports("avx2") ? ScanLevel::AVX2 : ScanLevel::SSE2;
+#else
+    return ScanLevel::SCALAR;
+#endif
+}
+
+ScanLevel scanLevel() { return selection().level; }
+
+void setScanLevel(ScanLevel level) {
+    if (level > supportedScanLevel())
+        level = supportedScanLevel();
+    selection() = Selection{level, &scannersFor(level)};
+}
+
+size_t scanWhitespace(std::string_view text, size_t from) {
+    return selection().scanners->whitespace(text.data(), from, text.size());
+}
+
+size_t scanDigits(std::string_view text, size_t from) {
+    return selection().scanners->digits(text.data(), from, text.size());
+}
+
+size_t scanIdentifier(std::string_view text, size_t from) {
+    return selection().scanners->identifier(text.data(), from, text.size());
+}
+
+size_t findCharacter(std::string_view text, size_t from, char c) {
+    if (from >= text.size())
+        return text.size();
+    const void *found = std::memchr(text.data() + from, c, text.size() - from);
+    return found != nullptr ? static_cast<const char *>(found) - text.data() : text.size();
+}
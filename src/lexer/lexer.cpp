@@ -1,15 +1,92 @@
 #include "lexer/lexer.h"
+#include "carl_stats.h"
+#include "lexer/char_scan.h"
 #include "lexer/lexer_errors.h"
+#include "lexer/symbol_table.h"
 #include "lexer/token.h"
 
-#include <cctype>
+#include <algorithm>
+#include <array>
 #include <cstdio>
-#include <iostream>
-#include <ostream>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-Lexer::Lexer(std::string source) : source{source} {}
+// Initial capacity of the token vector. Arithmetic and rule definitions
+// average 3 to 3.5 characters per token, commented programs about 13, so one
+// token per 4 characters lexes most sources without growing the vector; the
+// densest grow it once. Reserved capacity is address space, which counts
+// against ulimit -v and strict overcommit even while untouched, so larger
+// sources start at 16 MiB of tokens and grow as usual.
+static constexpr size_t CHARACTERS_PER_TOKEN = 4;
+static constexpr size_t MAX_RESERVED_TOKENS = size_t{1} << 20;
+
+static std::string_view checkSize(std::string_view source) {
+    if (source.size() > UINT32_MAX)
+        throw std::length_error("Source exceeds 4 GiB");
+    return source;
+}
+
+Lexer::Lexer(std::string_view source) : source{checkSize(source)} {}
+
+Lexer::Lexer(std::string_view source, uint32_t begin, uint32_t end)
+    : source{checkSize(source).substr(0, end)}, start{begin},
+      currentCharacterIndex{begin} {}
+
+Lexer::Lexer(std::string &&source)
+    : ownedSource{std::move(source)}, source{checkSize(ownedSource)} {}
+
+// Symbols of the tokens that are always spelled the same, interned once
+static const std::array<SymbolId, END_OF_FILE + 1> &fixedSymbols() {
+    static const std::array<SymbolId, END_OF_FILE + 1> symbols = [] {
+        std::array<SymbolId, END_OF_FILE + 1> symbols{};
+        const std::pair<TokenType, std::string_view> spellings[] = {
+            {PLUS, "+"},         {MINUS, "-"},
+            {STAR, "*"},         {SLASH, "/"},
+            {MODULUS, "%"},      {EXPONENT, "^"},
+            {LPAREN, "("},       {RPAREN, ")"},
+            {EQUALS, "="},       {LESS, "<"},
+            {GREATER, ">"},      {EQUALS_EQUALS, "=="},
+            {LESS_EQUALS, "<="}, {GREATER_EQUALS, ">="},
+            {BANG_EQUALS, "!="}, {ARROW, "->"},
+            {COLON, ":"},        {SEMICOLON, ";"},
+            {COMMA, ","},        {DOT, "."},
+            {BANG, "!"},
+        };
+        for (const auto &[type, spelling] : spellings)
+            symbols[type] = internSymbol(spelling);
+        for (const auto &[spelling, type] : keywords)
+            symbols[type] = internSymbol(spelling);
+        return symbols;
+    }();
+    return symbols;
+}
+
+Token Lexer::makeToken(TokenType type) {
+    const uint32_t length = currentCharacterIndex - start;
+    switch (type) {
+    case STRING:
+    case NUMBER:
+        // Read back from the source by Token::text()
+        return Token(type, start, length, SymbolId{});
+    case IDENTIFIER:
+        return Token(type, start, length,
+                     internIdentifier(source.substr(start, length)));
+    default:
+        return Token(type, start, length, fixedSymbols()[type]);
+    }
+}
+
+SymbolId Lexer::internIdentifier(std::string_view name) {
+    auto it = identifiers.find(name);
+    if (it == identifiers.end())
+        it = identifiers.emplace(name, internSymbol(name)).first;
+    return it->second;
+}
 
 inline bool Lexer::isAtEndOfFile() const {
     return currentCharacterIndex >= source.size();
@@ -34,7 +111,10 @@ bool Lexer::match(char expected) {
 }
 
 std::vector<Token> Lexer::tokenize() {
+    CARL_STAT_TIME(STAT_LEX);
     std::vector<Token> tokens;
+    tokens.reserve(std::min((source.size() - currentCharacterIndex) / CHARACTERS_PER_TOKEN + 1,
+                            MAX_RESERVED_TOKENS));
 
     while (!isAtEndOfFile()) {
         start = currentCharacterIndex;
@@ -44,130 +124,75 @@ std::vector<Token> Lexer::tokenize() {
 
         switch (c) {
         case '(':
-            tokens.push_back(Token(TokenType::LPAREN, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"("}));
+            tokens.push_back(makeToken(TokenType::LPAREN));
             break;
         case ')':
-            tokens.push_back(Token(TokenType::RPAREN, start,
-                                   currentCharacterIndex - start,
-                                   std::string{")"}));
+            tokens.push_back(makeToken(TokenType::RPAREN));
             break;
         case ',':
-            tokens.push_back(Token(TokenType::COMMA, start,
-                                   currentCharacterIndex - start,
-                                   std::string{","}));
+            tokens.push_back(makeToken(TokenType::COMMA));
             break;
         case '.':
-            tokens.push_back(Token(TokenType::DOT, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"."}));
+            tokens.push_back(makeToken(TokenType::DOT));
             break;
         case '+':
-            tokens.push_back(Token(TokenType::PLUS, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"+"}));
+            tokens.push_back(makeToken(TokenType::PLUS));
             break;
         case ';':
-            tokens.push_back(Token(TokenType::SEMICOLON, start,
-                                   currentCharacterIndex - start,
-                                   std::string{";"}));
+            tokens.push_back(makeToken(TokenType::SEMICOLON));
             break;
         case '*':
-            tokens.push_back(Token(TokenType::STAR, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"*"}));
+            tokens.push_back(makeToken(TokenType::STAR));
             break;
         case ':':
-            tokens.push_back(Token(TokenType::COLON, start,
-                                   currentCharacterIndex - start,
-                                   std::string{":"}));
+            tokens.push_back(makeToken(TokenType::COLON));
             break;
         case '/':
-            tokens.push_back(Token(TokenType::SLASH, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"/"}));
+            tokens.push_back(makeToken(TokenType::SLASH));
             break;
         case '^':
-            tokens.push_back(Token(TokenType::EXPONENT, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"^"}));
+            tokens.push_back(makeToken(TokenType::EXPONENT));
             break;
         case '%':
-            tokens.push_back(Token(TokenType::MODULUS, start,
-                                   currentCharacterIndex - start,
-                                   std::string{"%"}));
+            tokens.push_back(makeToken(TokenType::MODULUS));
             break;
 
         // Ignore comments
         case '#':
-            while (peek() != '\n' && !isAtEndOfFile())
-                consume();
+            currentCharacterIndex = findCharacter(source, currentCharacterIndex, '\n');
             break;
 
         // One or two character tokens
         case '!':
-            if (match('='))
-                tokens.push_back(Token(TokenType::BANG_EQUALS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"!="}));
-            else
-                tokens.push_back(Token(TokenType::BANG, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"!"}));
+            tokens.push_back(makeToken(match('=') ? TokenType::BANG_EQUALS
+                                                  : TokenType::BANG));
             break;
         case '=':
-            if (match('='))
-                tokens.push_back(Token(TokenType::EQUALS_EQUALS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"=="}));
-            else
-                tokens.push_back(Token(TokenType::EQUALS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"="}));
+            tokens.push_back(makeToken(match('=') ? TokenType::EQUALS_EQUALS
+                                                  : TokenType::EQUALS));
             break;
         case '-':
-            if (match('>'))
-                tokens.push_back(
-                    (Token(TokenType::ARROW, start,
-                           currentCharacterIndex - start, std::string{"->"})));
-            else
-                tokens.push_back(Token(TokenType::MINUS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"-"}));
+            tokens.push_back(makeToken(match('>') ? TokenType::ARROW
+                                                  : TokenType::MINUS));
             break;
-
         case '<':
-            if (match('='))
-                tokens.push_back(Token(TokenType::LESS_EQUALS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"<="}));
-            else
-                tokens.push_back(Token(TokenType::LESS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{"<"}));
+            tokens.push_back(makeToken(match('=') ? TokenType::LESS_EQUALS
+                                                  : TokenType::LESS));
             break;
-
         case '>':
-            if (match('='))
-                tokens.push_back(Token(TokenType::GREATER_EQUALS, start,
-                                       currentCharacterIndex - start,
-                                       std::string{">="}));
-            else
-                tokens.push_back(Token(TokenType::GREATER, start,
-                                       currentCharacterIndex - start,
-                                       std::string{">"}));
+            tokens.push_back(makeToken(match('=') ? TokenType::GREATER_EQUALS
+                                                  : TokenType::GREATER));
             break;
 
         case ' ':
         case '\r':
         case '\t':
         case '\n':
+            currentCharacterIndex = skipWhitespace(source, currentCharacterIndex);
             break;
 
         case '"': {
-            while (peek() != '"' && !isAtEndOfFile())
-                consume();
+            currentCharacterIndex = findCharacter(source, currentCharacterIndex, '"');
 
             // Check for unterminated string
             if (isAtEndOfFile())
@@ -176,21 +201,13 @@ std::vector<Token> Lexer::tokenize() {
             // Consume last quote
             consume();
 
-            // Create string literal
-            auto stringStart = source.begin() + start + 1;
-            size_t stringLen = currentCharacterIndex - start - 1;
-            auto stringEnd = source.begin() + start + stringLen;
-            std::string literal{stringStart, stringEnd};
-
-            tokens.push_back(
-                Token(TokenType::STRING, start, stringLen + 1, literal));
+            tokens.push_back(makeToken(TokenType::STRING));
             break;
         }
         default:
             // Lex numbers
-            if (std::isdigit(c)) {
-                while (std::isdigit(peek()))
-                    consume(); // Consume all numbers
+            if (isDigitCharacter(c)) {
+                currentCharacterIndex = skipDigits(source, currentCharacterIndex);
 
                 // Look for fractional part
                 if (peek() == '.') {
@@ -198,38 +215,27 @@ std::vector<Token> Lexer::tokenize() {
 
                     // A delimiter was added but no fractional part was
                     // provided, ex: '5.'
-                    if (!std::isdigit(peek()))
+                    if (!isDigitCharacter(peek()))
                         throw IncompleteDelimiter(start, currentCharacterIndex -
                                                              start);
 
-                    while (std::isdigit(peek()))
-                        consume(); // Consume fractional part
+                    // Fractional part
+                    currentCharacterIndex = skipDigits(source, currentCharacterIndex);
                 }
 
-                size_t numberLen = currentCharacterIndex - start;
-                std::string numberLiteral{source.begin() + start,
-                                          source.begin() + start + numberLen};
-                tokens.push_back(
-                    Token(TokenType::NUMBER, start, numberLen, numberLiteral));
+                tokens.push_back(makeToken(TokenType::NUMBER));
             }
             // Lex keywords & identifiers (variables, functions etc.)
             else if (isAlpha(c)) {
-                while (isAlpha(peek()))
-                    consume();
-
-                size_t identifierLen = currentCharacterIndex - start;
-                std::string identifier{source.begin() + start,
-                                       source.begin() + start + identifierLen};
+                currentCharacterIndex = skipIdentifier(source, currentCharacterIndex);
 
                 // Check if it's a reserved keyword
+                std::string_view identifier =
+                    source.substr(start, currentCharacterIndex - start);
                 auto it = keywords.find(identifier);
-                if (it != keywords.end()) {
-                    tokens.push_back(
-                        Token(it->second, start, identifierLen, identifier));
-                } else {
-                    tokens.push_back(Token(TokenType::IDENTIFIER, start,
-                                           identifierLen, identifier));
-                }
+                tokens.push_back(makeToken(it != keywords.end()
+                                               ? it->second
+                                               : TokenType::IDENTIFIER));
             } else {
                 // Uhm what is this character??
                 throw UnrecognizedCharacter(start,
@@ -240,17 +246,19 @@ std::vector<Token> Lexer::tokenize() {
     }
 
     tokens.push_back(Token(TokenType::END_OF_FILE, start,
-                           currentCharacterIndex - start, std::string{"\0"}));
+                           currentCharacterIndex - start, SymbolId{}));
+    CARL_STAT_ADD(STAT_TOKENS, tokens.size());
     return tokens;
 }
 
-inline bool Lexer::isAlpha(char c) const { return std::isalpha(c) || c == '_' || c == '-'; }
+inline bool Lexer::isAlpha(char c) const { return isIdentifierCharacter(c); }
 
-std::string Lexer::tokensToString(const std::vector<Token> &tokens) {
+std::string Lexer::tokensToString(const std::vector<Token> &tokens,
+                                  std::string_view source) {
     std::string output;
-    for (Token token : tokens) {
+    for (const Token &token : tokens) {
         output += std::format("{}('{}')\n", TokenTypesToString[token.type()],
-                              token.literal());
+                              token.text(source));
     }
     return output;
 }
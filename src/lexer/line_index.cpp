@@ -0,0 +1,38 @@
+#include "lexer/line_index.h"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+
+LineIndex::LineIndex(std::string_view source)
+    : sourceSize{static_cast<uint32_t>(source.size())} {
+    for (size_t lineBreak = source.find('\n'); lineBreak != std::string_view::npos;
+         lineBreak = source.find('\n', lineBreak + 1))
+        lineBreaks.push_back(static_cast<uint32_t>(lineBreak));
+}
+
+LineIndex::LineIndex(std::string_view source, uint32_t firstLine,
+                     uint32_t firstColumn)
+    : LineIndex(source) {
+    this->firstLine = firstLine;
+    this->firstColumn = firstColumn;
+}
+
+std::pair<uint32_t, uint32_t> LineIndex::locate(uint32_t offset) const {
+    assert(offset <= sourceSize && "Could not calculate line number since the "
+                                   "offset exceeds the bounds of the source");
+
+    // Line breaks strictly before offset
+    auto it = std::lower_bound(lineBreaks.begin(), lineBreaks.end(), offset);
+    const uint32_t line = static_cast<uint32_t>(it - lineBreaks.begin());
+    if (line == 0)
+        return {firstLine, firstColumn + offset};
+    return {firstLine + line, offset - lineBreaks[line - 1]};
+}
+
+std::string LineIndex::describe(uint32_t offset, uint32_t length) const {
+    auto [startLine, startColumn] = locate(offset);
+    auto [endLine, endColumn] = locate(offset + length);
+    return std::format("{}:{} - {}:{}", startLine, startColumn, endLine,
+                       endColumn);
+}
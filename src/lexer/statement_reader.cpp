@@ -0,0 +1,83 @@
+#include "lexer/statement_reader.h"
+
+#include <cctype>
+
+StatementReader::StatementReader(std::istream &input, size_t chunkSize)
+    : input{input}, chunkSize{chunkSize} {}
+
+// Appends the next chunk of input, false once it is exhausted
+bool StatementReader::fill() {
+    // Statements already handed out are no longer needed
+    if (begin > 0) {
+        buffer.erase(0, begin);
+        bufferOffset += begin;
+        scanned -= begin;
+        begin = 0;
+    }
+
+    const size_t size = buffer.size();
+    buffer.resize(size + chunkSize);
+    input.read(buffer.data() + size, chunkSize);
+    buffer.resize(size + input.gcount());
+    return input.gcount() > 0;
+}
+
+std::string_view StatementReader::take(size_t end) {
+    std::string_view statement{buffer.data() + begin, end - begin};
+    statementOffset = bufferOffset + begin;
+    statementLine = linesAtBegin;
+    statementColumn = columnAtBegin;
+
+    begin = end;
+    linesAtBegin = linesScanned;
+    const uint64_t absoluteEnd = bufferOffset + end;
+    columnAtBegin = static_cast<uint32_t>(
+        linesScanned == 0 ? absoluteEnd : absoluteEnd - lastLineBreak);
+    blank = true;
+    return statement;
+}
+
+std::optional<std::string_view> StatementReader::next() {
+    while (true) {
+        for (; scanned < buffer.size(); scanned++) {
+            const char c = buffer[scanned];
+            if (c == '\n') {
+                linesScanned++;
+                lastLineBreak = bufferOffset + scanned;
+                inComment = false;
+                continue;
+            }
+            if (inComment)
+                continue;
+            if (inString) {
+                inString = c != '"';
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                inString = true;
+                blank = false;
+                break;
+            case '#':
+                inComment = true;
+                break;
+            case ';':
+                scanned++;
+                return take(scanned);
+            default:
+                if (!std::isspace(static_cast<unsigned char>(c)))
+                    blank = false;
+            }
+        }
+
+        if (!fill())
+            break;
+    }
+
+    if (blank) {
+        begin = buffer.size();
+        return {};
+    }
+    return take(buffer.size());
+}
@@ -0,0 +1,70 @@
+#include "lexer/symbol_table.h"
+#include "carl_stats.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+SymbolTable::SymbolTable() {
+    // Id 0 is the empty string, so a zero initialized SymbolId is valid
+    intern("");
+}
+
+SymbolTable::~SymbolTable() {
+    std::allocator<std::string> allocator;
+    uint64_t left = size_;
+    for (size_t chunk = 0; chunk < CHUNKS && left > 0; chunk++) {
+        const uint64_t capacity = FIRST_CHUNK_SIZE << chunk;
+        std::string *names = chunks[chunk].load(std::memory_order_relaxed);
+        const uint64_t used = std::min(left, capacity);
+        std::destroy_n(names, used);
+        allocator.deallocate(names, capacity);
+        left -= used;
+    }
+}
+
+SymbolTable &SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(std::string_view text) {
+    CARL_STAT_COUNT(STAT_SYMBOL_INTERNS);
+    {
+        std::shared_lock lock{mutex};
+        auto it = ids.find(text);
+        if (it != ids.end())
+            return it->second;
+    }
+
+    std::unique_lock lock{mutex};
+    // Another thread may have interned it in the meantime
+    auto it = ids.find(text);
+    if (it != ids.end())
+        return it->second;
+
+    if (size_ > UINT32_MAX)
+        throw std::length_error("Symbol table is full");
+    const SymbolId id{static_cast<uint32_t>(size_)};
+    const uint64_t slot = size_ + FIRST_CHUNK_SIZE;
+    const size_t chunk = std::bit_width(slot) - 1 - FIRST_CHUNK_BITS;
+    std::string *names = chunks[chunk].load(std::memory_order_relaxed);
+    if (names == nullptr) {
+        names = std::allocator<std::string>().allocate(FIRST_CHUNK_SIZE << chunk);
+        chunks[chunk].store(names, std::memory_order_release);
+    }
+
+    // Readers only get to the name through the id, which is handed out
+    // after the name is constructed
+    const std::string *name = new (names + (slot - (FIRST_CHUNK_SIZE << chunk))) std::string(text);
+    ids.emplace(*name, id);
+    size_++;
+    return id;
+}
+
+size_t SymbolTable::size() const {
+    std::shared_lock lock{mutex};
+    return size_;
+}
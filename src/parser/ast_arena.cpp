@@ -0,0 +1,100 @@
+#include "parser/ast_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace {
+// Every node is prefixed with the arena it came from (nullptr for heap nodes),
+// padded so the node itself stays maximally aligned
+struct alignas(std::max_align_t) AllocationHeader {
+    AstArena *arena;
+};
+constexpr size_t HEADER_SIZE = sizeof(AllocationHeader);
+
+constexpr size_t alignUp(size_t size) {
+    return (size + alignof(std::max_align_t) - 1) &
+           ~(alignof(std::max_align_t) - 1);
+}
+
+std::atomic<size_t> arenaCount{0};
+} // namespace
+
+thread_local AstArena *AstArena::current_ = nullptr;
+
+AstArena::Scope::Scope(size_t sizeHint)
+    : arena{new AstArena(sizeHint)}, previous{AstArena::current_} {
+    AstArena::current_ = arena;
+}
+
+AstArena::Scope::~Scope() {
+    AstArena::current_ = previous;
+    arena->scoped = false;
+    arena->releaseIfUnused();
+}
+
+AstArena::AstArena(size_t sizeHint)
+    : nextBlockSize{std::clamp(alignUp(sizeHint), MIN_BLOCK_SIZE,
+                               MAX_BLOCK_SIZE)} {
+    arenaCount++;
+}
+
+AstArena::~AstArena() { arenaCount--; }
+
+size_t AstArena::liveArenas() { return arenaCount.load(); }
+
+void AstArena::addBlock(size_t minimumSize) {
+    const size_t size = std::max(nextBlockSize, minimumSize);
+    blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+    cursor = blocks.back().get();
+    limit = cursor + size;
+    bytesReserved_ += size;
+
+    nextBlockSize = std::min(nextBlockSize * 2, MAX_BLOCK_SIZE);
+}
+
+void *AstArena::bumpAllocate(size_t size) {
+    size = alignUp(size);
+    if (cursor == nullptr || static_cast<size_t>(limit - cursor) < size)
+        addBlock(size);
+
+    void *pointer = cursor;
+    cursor += size;
+    liveNodes_++;
+    return pointer;
+}
+
+void AstArena::releaseIfUnused() {
+    if (!scoped && liveNodes_ == 0)
+        delete this;
+}
+
+void *AstArena::allocate(size_t size) {
+    AllocationHeader *header;
+    if (current_ != nullptr)
+        header = static_cast<AllocationHeader *>(
+            current_->bumpAllocate(HEADER_SIZE + size));
+    else
+        header = static_cast<AllocationHeader *>(
+            ::operator new(HEADER_SIZE + size));
+
+    header->arena = current_;
+    return reinterpret_cast<std::byte *>(header) + HEADER_SIZE;
+}
+
+void AstArena::deallocate(void *pointer) noexcept {
+    if (pointer == nullptr)
+        return;
+
+    AllocationHeader *header = reinterpret_cast<AllocationHeader *>(
+        static_cast<std::byte *>(pointer) - HEADER_SIZE);
+    AstArena *arena = header->arena;
+    if (arena == nullptr) {
+        ::operator delete(header);
+        return;
+    }
+
+    arena->liveNodes_--;
+    arena->releaseIfUnused();
+}
@@ -0,0 +1,143 @@
+#include "parser/constant_folder.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "parser/statement.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// Value of a number literal, or of a negated one
+static std::optional<double> constantValue(Expression &expression) {
+    if (auto *literal = dynamic_cast<LiteralExpression *>(&expression)) {
+        if (literal->type() != TokenType::NUMBER)
+            return {};
+        return std::strtod(literal->literal().c_str(), nullptr);
+    }
+
+    auto *unary = dynamic_cast<UnaryExpression *>(&expression);
+    if (unary == nullptr || unary->op().type() != TokenType::MINUS)
+        return {};
+    auto *literal = dynamic_cast<LiteralExpression *>(&unary->operand());
+    if (literal == nullptr || literal->type() != TokenType::NUMBER)
+        return {};
+    return -std::strtod(literal->literal().c_str(), nullptr);
+}
+
+// Shortest spelling that reads back as value, negated literal if negative.
+// The minus takes the location of the operator it replaces.
+static std::unique_ptr<Expression> makeConstant(double value, const Token &at) {
+    char spelling[32];
+    auto [end, error] =
+        std::to_chars(spelling, spelling + sizeof(spelling), std::fabs(value));
+    auto literal = std::make_unique<LiteralExpression>(
+        TokenType::NUMBER, std::string_view(spelling, end - spelling));
+
+    if (!std::signbit(value))
+        return literal;
+    return std::make_unique<UnaryExpression>(
+        Token(TokenType::MINUS, at.sourceOffset(), at.length(), "-"),
+        std::move(literal));
+}
+
+std::unique_ptr<Expression>
+ConstantFolder::fold(std::unique_ptr<Expression> expression) {
+    folded.clear();
+    walkPostOrder(*expression, *this);
+    if (folded.back() != nullptr)
+        return std::move(folded.back());
+    return expression;
+}
+
+void ConstantFolder::fold(Statement &statement) { statement.accept(*this); }
+
+void ConstantFolder::visitExpressionStatement(ExpressionStatement &statement) {
+    statement.setExpression(fold(statement.borrowExpression()));
+}
+
+void ConstantFolder::visitDefineStatement(DefineStatement &statement) {
+    // Patterns too, or they wouldn't match folded sources
+    statement.setPattern(fold(statement.borrowPattern()));
+    statement.setReplacement(fold(statement.borrowReplacement()));
+}
+
+void ConstantFolder::visitApplyStatement(ApplyStatement &statement) {
+    statement.setExpression(fold(statement.borrowExpression()));
+}
+
+void ConstantFolder::visitNormalizeStatement(NormalizeStatement &statement) {
+    statement.setExpression(fold(statement.borrowExpression()));
+}
+
+void ConstantFolder::visitShowStatement(ShowStatement &) {}
+
+std::unique_ptr<Expression> ConstantFolder::takeFolded() {
+    std::unique_ptr<Expression> replacement = std::move(folded.back());
+    folded.pop_back();
+    return replacement;
+}
+
+void ConstantFolder::visitLiteralExpression(LiteralExpression &) {
+    folded.push_back(nullptr);
+}
+
+void ConstantFolder::visitBinaryExpression(BinaryExpression &expression) {
+    if (auto right = takeFolded())
+        expression.setRight(std::move(right));
+    if (auto left = takeFolded())
+        expression.setLeft(std::move(left));
+    folded.push_back(nullptr);
+
+    std::optional<double> left = constantValue(expression.left());
+    std::optional<double> right = constantValue(expression.right());
+    if (!left || !right)
+        return;
+
+    double value;
+    switch (expression.op().type()) {
+    case TokenType::PLUS:
+        value = *left + *right;
+        break;
+    case TokenType::MINUS:
+        value = *left - *right;
+        break;
+    case TokenType::STAR:
+        value = *left * *right;
+        break;
+    case TokenType::SLASH:
+        value = *left / *right;
+        break;
+    default:
+        // Not evaluated on numbers, leave the error to runtime
+        return;
+    }
+
+    // Infinities and NaN have no literal spelling
+    if (!std::isfinite(value))
+        return;
+
+    folded.back() = makeConstant(value, expression.op());
+    foldedNodes_++;
+}
+
+void ConstantFolder::visitUnaryExpression(UnaryExpression &expression) {
+    if (auto operand = takeFolded())
+        expression.setOperand(std::move(operand));
+    folded.push_back(nullptr);
+
+    // A negated literal is already as folded as it gets
+    if (expression.op().type() != TokenType::MINUS ||
+        dynamic_cast<LiteralExpression *>(&expression.operand()) != nullptr)
+        return;
+
+    std::optional<double> operand = constantValue(expression.operand());
+    if (!operand)
+        return;
+
+    folded.back() = makeConstant(-*operand, expression.op());
+    foldedNodes_++;
+}
@@ -0,0 +1,150 @@
+#include "parser/expression.h"
+#include "carl_stats.h"
+#include "parser/tree_printer.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+bool Expression::operator==(const Expression &other) const {
+    // Iterative, trees can be deeper than the stack
+    std::vector<std::pair<const Expression *, const Expression *>> pending{
+        {this, &other}};
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+
+        if (a == b)
+            continue;
+        if (a->hash() != b->hash())
+            return false;
+
+        if (auto *literal = dynamic_cast<const LiteralExpression *>(a)) {
+            auto *otherLiteral = dynamic_cast<const LiteralExpression *>(b);
+            if (otherLiteral == nullptr ||
+                literal->type() != otherLiteral->type() ||
+                literal->literal() != otherLiteral->literal())
+                return false;
+        } else if (auto *binary = dynamic_cast<const BinaryExpression *>(a)) {
+            auto *otherBinary = dynamic_cast<const BinaryExpression *>(b);
+            if (otherBinary == nullptr ||
+                binary->op().type() != otherBinary->op().type() ||
+                binary->op().symbol() != otherBinary->op().symbol())
+                return false;
+            pending.emplace_back(&binary->left(), &otherBinary->left());
+            pending.emplace_back(&binary->right(), &otherBinary->right());
+        } else {
+            auto *unary = static_cast<const UnaryExpression *>(a);
+            auto *otherUnary = dynamic_cast<const UnaryExpression *>(b);
+            if (otherUnary == nullptr ||
+                unary->op().type() != otherUnary->op().type() ||
+                unary->op().symbol() != otherUnary->op().symbol())
+                return false;
+            pending.emplace_back(&unary->operand(), &otherUnary->operand());
+        }
+    }
+    return true;
+}
+
+void Expression::destroyChildren() {
+    // Children are detached before they are destroyed, so every destructor
+    // called from here finds a childless node
+    std::vector<std::unique_ptr<Expression>> pending;
+    releaseChildren(pending);
+    while (!pending.empty()) {
+        std::unique_ptr<Expression> node = std::move(pending.back());
+        pending.pop_back();
+        node->releaseChildren(pending);
+    }
+}
+
+std::string Expression::toString() const {
+    std::string output;
+    appendTree(*this, output);
+    return output;
+}
+
+std::unique_ptr<Expression> Expression::clone() const {
+    struct Frame {
+        const Expression *node;
+        bool expanded;
+    };
+
+    // Copies are built bottom up, children before their parent
+    std::vector<Frame> pending{{this, false}};
+    std::vector<std::unique_ptr<Expression>> built;
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        pending.pop_back();
+        const Expression *node = frame.node;
+
+        if (!frame.expanded && node->arity() > 0) {
+            pending.push_back({node, true});
+            for (size_t i = node->arity(); i > 0; i--)
+                pending.push_back({&node->child(i - 1), false});
+            continue;
+        }
+
+        if (auto *literal = dynamic_cast<const LiteralExpression *>(node)) {
+            built.push_back(std::make_unique<LiteralExpression>(
+                literal->type(), literal->literal()));
+        } else if (auto *binary = dynamic_cast<const BinaryExpression *>(node)) {
+            std::unique_ptr<Expression> right = std::move(built.back());
+            built.pop_back();
+            std::unique_ptr<Expression> left = std::move(built.back());
+            built.back() = std::make_unique<BinaryExpression>(
+                std::move(left), binary->op(), std::move(right));
+        } else {
+            auto *unary = static_cast<const UnaryExpression *>(node);
+            built.back() = std::make_unique<UnaryExpression>(
+                unary->op(), std::move(built.back()));
+        }
+        CARL_STAT_COUNT(STAT_CLONED_NODES);
+    }
+    return std::move(built.back());
+}
+
+void walkPostOrder(Expression &root, IExpressionVisitor &visitor) {
+    struct Frame {
+        Expression *node;
+        bool expanded;
+    };
+
+    std::vector<Frame> pending{{&root, false}};
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        pending.pop_back();
+        Expression *node = frame.node;
+
+        if (!frame.expanded && node->arity() > 0) {
+            pending.push_back({node, true});
+            for (size_t i = node->arity(); i > 0; i--)
+                pending.push_back({&node->child(i - 1), false});
+            continue;
+        }
+        node->accept(visitor);
+    }
+}
+
+void Expression::refreshHash() const {
+    // Iterative like everything else here, a stale path can be as deep as
+    // the tree
+    std::vector<std::pair<const Expression *, bool>> pending{{this, false}};
+    while (!pending.empty()) {
+        auto [node, expanded] = pending.back();
+        pending.pop_back();
+
+        if (!expanded) {
+            pending.emplace_back(node, true);
+            for (size_t i = 0; i < node->arity(); i++) {
+                if (node->child(i).hashStale_)
+                    pending.emplace_back(&node->child(i), false);
+            }
+            continue;
+        }
+        node->hash_ = node->computeHash();
+        node->hashStale_ = false;
+    }
+}
@@ -0,0 +1,103 @@
+#include "parser/flat_expression.h"
+#include "parser/expression.h"
+#include "parser/iexpression_visitor.h"
+
+#include <cassert>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+// Appends nodes as walkPostOrder visits them, keeping the indices of the
+// subtrees whose parent wasn't visited yet
+class Flattener : public IExpressionVisitor {
+private:
+    FlatExpression &flat;
+    std::vector<FlatExpression::Index> subtrees;
+
+public:
+    Flattener(FlatExpression &flat_) : flat{flat_} {}
+
+    void visitLiteralExpression(LiteralExpression &expression) override {
+        subtrees.push_back(flat.addLiteral(expression.type(), expression.literal()));
+    }
+
+    void visitBinaryExpression(BinaryExpression &expression) override {
+        subtrees.pop_back(); // Right operand, the node appended last
+        FlatExpression::Index left = subtrees.back();
+        subtrees.back() = flat.addBinary(expression.op(), left);
+    }
+
+    void visitUnaryExpression(UnaryExpression &expression) override {
+        subtrees.back() = flat.addUnary(expression.op());
+    }
+};
+} // namespace
+
+FlatExpression::FlatExpression(Expression &root) {
+    Flattener flattener{*this};
+    walkPostOrder(root, flattener);
+}
+
+void FlatExpression::reserve(size_t nodes) {
+    arities_.reserve(nodes);
+    types_.reserve(nodes);
+    symbols_.reserve(nodes);
+    lefts_.reserve(nodes);
+    offsets_.reserve(nodes);
+    lengths_.reserve(nodes);
+}
+
+FlatExpression::Index FlatExpression::add(uint8_t arity, TokenType type,
+                                          uint32_t symbol, Index left,
+                                          uint32_t offset, uint32_t length) {
+    arities_.push_back(arity);
+    types_.push_back(type);
+    symbols_.push_back(symbol);
+    lefts_.push_back(left);
+    offsets_.push_back(offset);
+    lengths_.push_back(length);
+    return root();
+}
+
+FlatExpression::Index FlatExpression::addLiteral(TokenType type,
+                                                 std::string_view literal) {
+    literals_.emplace_back(literal);
+    return add(0, type, static_cast<uint32_t>(literals_.size() - 1), 0, 0, 0);
+}
+
+FlatExpression::Index FlatExpression::addUnary(const Token &op) {
+    assert(!empty());
+    return add(1, op.type(), static_cast<uint32_t>(op.symbol()), 0,
+               op.sourceOffset(), op.length());
+}
+
+FlatExpression::Index FlatExpression::addBinary(const Token &op, Index left) {
+    assert(size() >= 2 && left < root());
+    return add(2, op.type(), static_cast<uint32_t>(op.symbol()), left,
+               op.sourceOffset(), op.length());
+}
+
+std::unique_ptr<Expression> FlatExpression::toExpression() const {
+    // Post-order, so the operands of each node are on top of the stack
+    std::vector<std::unique_ptr<Expression>> built;
+    for (Index node = 0; node < size(); node++) {
+        switch (arity(node)) {
+        case 0:
+            built.push_back(std::make_unique<LiteralExpression>(type(node), literal(node)));
+            break;
+        case 1:
+            built.back() = std::make_unique<UnaryExpression>(token(node), std::move(built.back()));
+            break;
+        default: {
+            std::unique_ptr<Expression> right = std::move(built.back());
+            built.pop_back();
+            built.back() = std::make_unique<BinaryExpression>(
+                std::move(built.back()), token(node), std::move(right));
+        }
+        }
+    }
+    assert(built.size() == 1);
+    return std::move(built.back());
+}
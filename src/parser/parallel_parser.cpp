@@ -0,0 +1,100 @@
+#include "parser/parallel_parser.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+ParallelParser::ParallelParser(size_t threads, size_t chunkSize_)
+    : pool{threads}, chunkSize{std::max<size_t>(chunkSize_, 1)} {}
+
+std::vector<uint32_t> ParallelParser::split(std::string_view source, size_t chunkSize) {
+    if (source.size() > UINT32_MAX)
+        throw std::length_error("Source exceeds 4 GiB");
+
+    std::vector<uint32_t> starts{0};
+    size_t next = chunkSize;
+    size_t i = 0;
+    while (i < source.size()) {
+        switch (source[i]) {
+        case '"':
+            // Strings end at the next quote, unterminated ones at the end
+            i = source.find('"', i + 1);
+            if (i == std::string_view::npos)
+                return starts;
+            break;
+        case '#':
+            i = source.find('\n', i + 1);
+            if (i == std::string_view::npos)
+                return starts;
+            break;
+        case ';':
+            if (i + 1 >= next && i + 1 < source.size()) {
+                starts.push_back(static_cast<uint32_t>(i + 1));
+                next = i + 1 + chunkSize;
+            }
+            break;
+        }
+        i++;
+    }
+    return starts;
+}
+
+std::vector<std::unique_ptr<Statement>> ParallelParser::parse(std::string_view source) {
+    const std::vector<uint32_t> starts = split(source, chunkSize);
+    if (starts.size() == 1) {
+        Lexer lexer{source};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        return parser.parse();
+    }
+
+    struct Part {
+        std::vector<std::unique_ptr<Statement>> statements;
+        std::exception_ptr lexerError;
+        std::exception_ptr parserError;
+    };
+    std::vector<Part> parts(starts.size());
+
+    pool.parallelFor(starts.size(), 1, [&](size_t index, size_t) {
+        const uint32_t end = index + 1 < starts.size()
+                                 ? starts[index + 1]
+                                 : static_cast<uint32_t>(source.size());
+        Part &part = parts[index];
+        std::vector<Token> tokens;
+        try {
+            Lexer lexer{source, starts[index], end};
+            tokens = lexer.tokenize();
+        } catch (...) {
+            part.lexerError = std::current_exception();
+            return;
+        }
+        try {
+            Parser parser{std::move(tokens), source};
+            part.statements = parser.parse();
+        } catch (...) {
+            part.parserError = std::current_exception();
+        }
+    });
+
+    for (Part &part : parts)
+        if (part.lexerError)
+            std::rethrow_exception(part.lexerError);
+    for (Part &part : parts)
+        if (part.parserError)
+            std::rethrow_exception(part.parserError);
+
+    size_t count = 0;
+    for (Part &part : parts)
+        count += part.statements.size();
+    std::vector<std::unique_ptr<Statement>> statements;
+    statements.reserve(count);
+    for (Part &part : parts)
+        for (auto &statement : part.statements)
+            statements.push_back(std::move(statement));
+    return statements;
+}
@@ -1,4 +1,6 @@
 #include "parser/parser.h"
+#include "carl_stats.h"
+#include "parser/ast_arena.h"
 #include "parser/expression.h"
 #include "parser/parser_errors.h"
 #include "parser/statement.h"
@@ -6,13 +8,20 @@
 #include <exception>
 #include <initializer_list>
 #include <memory>
+#include <vector>
 
 std::vector<std::unique_ptr<Statement>> Parser::parse() {
+    CARL_STAT_TIME(STAT_PARSE);
+    // All nodes of this parse share one arena, there's at most one node per
+    // token
+    AstArena::Scope arena{lexemes.size() * sizeof(BinaryExpression)};
+
     std::vector<std::unique_ptr<Statement>> statements;
     while (!isAtEnd()) {
         statements.push_back(command());
     }
 
+    CARL_STAT_ADD(STAT_STATEMENTS, statements.size());
     return statements;
 }
 
@@ -39,49 +48,78 @@ std::unique_ptr<Statement> Parser::showStatement() {
     std::unique_ptr<Expression> expr = expression();
 
     if (!matchAny({TokenType::SEMICOLON}))
-        throw MissingTerminator(previous());
+        throw MissingTerminator(previous(), text(previous()));
 
     return std::make_unique<ShowStatement>(std::move(expr));
 }
 
 std::unique_ptr<Statement> Parser::applyStatement() {
+    const Token apply = previous();
+    if (matchAny({TokenType::STAR}))
+        return normalizeStatement(apply);
+
     if (!matchAny({TokenType::IDENTIFIER}))
-        throw SyntaxError(previous(), "Expected a rule name after apply command");
-    Token ruleName = previous();
+        throw SyntaxError(previous(), text(previous()), "Expected a rule name after apply command");
+    const Token &ruleName = previous();
     if (!matchAny({TokenType::COLON}))
-        throw SyntaxError(previous(), "Expected a seperator ':' between rule name and expression");
+        throw SyntaxError(previous(), text(previous()), "Expected a seperator ':' between rule name and expression");
 
     std::unique_ptr<Expression> expr = expression();
 
     if (!matchAny({TokenType::SEMICOLON}))
-        throw MissingTerminator(previous());
+        throw MissingTerminator(previous(), text(previous()));
 
-    return std::make_unique<ApplyStatement>(ruleName.literal(), std::move(expr));
+    return std::make_unique<ApplyStatement>(ruleName.symbol(), std::move(expr));
+}
+
+std::unique_ptr<Statement> Parser::normalizeStatement(const Token &apply) {
+    const Token keyword{TokenType::APPLY, apply.sourceOffset(),
+                        previous().sourceEnd() - apply.sourceOffset(), "apply*"};
+
+    // Without rule names every defined rule is used
+    std::vector<SymbolId> ruleNames;
+    if (peek().type() != TokenType::COLON) {
+        do {
+            if (!matchAny({TokenType::IDENTIFIER}))
+                throw SyntaxError(previous(), text(previous()), "Expected a rule name after apply*");
+            ruleNames.push_back(previous().symbol());
+        } while (matchAny({TokenType::COMMA}));
+    }
+
+    if (!matchAny({TokenType::COLON}))
+        throw SyntaxError(previous(), text(previous()), "Expected a seperator ':' between rule names and expression");
+
+    std::unique_ptr<Expression> expr = expression();
+
+    if (!matchAny({TokenType::SEMICOLON}))
+        throw MissingTerminator(previous(), text(previous()));
+
+    return std::make_unique<NormalizeStatement>(keyword, std::move(ruleNames), std::move(expr));
 }
 
 std::unique_ptr<Statement> Parser::defineStatement() {
     if (!matchAny({TokenType::IDENTIFIER}))
-        throw SyntaxError(previous(), "Expected a rule name after definition");
+        throw SyntaxError(previous(), text(previous()), "Expected a rule name after definition");
 
-    Token ruleName = previous();
+    const Token &ruleName = previous();
 
     if (!matchAny({TokenType::ARROW}))
-        throw SyntaxError(previous(), "Expected '->' after rule name");
+        throw SyntaxError(previous(), text(previous()), "Expected '->' after rule name");
 
     std::unique_ptr<Expression> pattern = expression();
 
     if (!matchAny({TokenType::EQUALS}))
-        throw SyntaxError(previous(),
+        throw SyntaxError(previous(), text(previous()),
                           "Expected a '=' after pattern expression");
 
     std::unique_ptr<Expression> replacement = expression();
 
     if (!matchAny({TokenType::SEMICOLON}))
-        throw MissingTerminator(previous());
+        throw MissingTerminator(previous(), text(previous()));
 
     std::unique_ptr<Statement> definitionStatement =
         std::make_unique<DefineStatement>(
-            ruleName.literal(), std::move(pattern), std::move(replacement));
+            ruleName.symbol(), std::move(pattern), std::move(replacement));
     return std::move(definitionStatement);
 }
 
@@ -91,94 +129,121 @@ std::unique_ptr<Statement> Parser::expressionStatement() {
     std::unique_ptr<Expression> expr = expression();
 
     if (!matchAny({TokenType::SEMICOLON})) {
-        throw MissingTerminator(previous());
+        throw MissingTerminator(previous(), text(previous()));
     }
 
     return std::make_unique<ExpressionStatement>(std::move(expr));
 }
 
-std::unique_ptr<Expression> Parser::expression() { return equality(); }
-
-std::unique_ptr<Expression> Parser::equality() {
-    std::unique_ptr<Expression> expression = comparison();
-    while (matchAny({TokenType::BANG_EQUALS, TokenType::EQUALS_EQUALS})) {
-        Token equialityOp = previous();
-        std::unique_ptr<Expression> right = comparison();
-        std::unique_ptr<Expression> binOp = std::make_unique<BinaryExpression>(
-            std::move(expression), equialityOp, std::move(right));
-        expression = std::move(binOp);
-    }
-    return expression;
-}
-std::unique_ptr<Expression> Parser::comparison() {
-    std::unique_ptr<Expression> expression = term();
-    while (matchAny({TokenType::GREATER, TokenType::GREATER_EQUALS,
-                     TokenType::LESS, TokenType::LESS_EQUALS})) {
-        Token comparisonOp = previous();
-        std::unique_ptr<Expression> right = term();
-        std::unique_ptr<Expression> binOp = std::make_unique<BinaryExpression>(
-            std::move(expression), comparisonOp, std::move(right));
-        expression = std::move(binOp);
-    }
-    return expression;
-}
-std::unique_ptr<Expression> Parser::term() {
-    std::unique_ptr<Expression> expression = factor();
-    while (matchAny({TokenType::PLUS, TokenType::MINUS})) {
-        Token termOp = previous();
-        std::unique_ptr<Expression> right = factor();
-        std::unique_ptr<Expression> binOp = std::make_unique<BinaryExpression>(
-            std::move(expression), termOp, std::move(right));
-        expression = std::move(binOp);
+// Binding strength of the binary operators, 0 for tokens that end an
+// expression. All of them are left associative.
+static int binaryPrecedence(TokenType type) {
+    switch (type) {
+        case BANG_EQUALS:
+        case EQUALS_EQUALS:
+            return 1;
+        case GREATER:
+        case GREATER_EQUALS:
+        case LESS:
+        case LESS_EQUALS:
+            return 2;
+        case PLUS:
+        case MINUS:
+            return 3;
+        case SLASH:
+        case STAR:
+            return 4;
+        default:
+            return 0;
     }
-    return expression;
 }
-std::unique_ptr<Expression> Parser::factor() {
-    std::unique_ptr<Expression> expression = unary();
-    while (matchAny({TokenType::SLASH, TokenType::STAR})) {
-        Token factorOp = previous();
-        std::unique_ptr<Expression> right = unary();
-        std::unique_ptr<Expression> binOp = std::make_unique<BinaryExpression>(
-            std::move(expression), factorOp, std::move(right));
-        expression = std::move(binOp);
-    }
-    return expression;
-}
-std::unique_ptr<Expression> Parser::unary() {
-    if (matchAny({TokenType::BANG, TokenType::MINUS})) {
-        Token unaryOp = previous();
-        std::unique_ptr<Expression> operand = unary();
-        return std::make_unique<UnaryExpression>(
-            UnaryExpression{unaryOp, std::move(operand)});
+
+// Prefix operators bind tighter than any binary operator
+static constexpr int PREFIX_PRECEDENCE = 5;
+// Open brackets are never reduced by an operator
+static constexpr int BRACKET_PRECEDENCE = 0;
+
+namespace {
+// An operator still waiting for operands, or an open bracket
+struct PendingOperator {
+    Token op;
+    int precedence;
+};
+} // namespace
+
+// Operator precedence parsing with explicit operand and operator stacks, so
+// the nesting depth of brackets and operators is bounded by memory rather
+// than by the call stack
+std::unique_ptr<Expression> Parser::expression() {
+    std::vector<std::unique_ptr<Expression>> operands;
+    std::vector<PendingOperator> operators;
+    size_t openBrackets{0};
+
+    // Reduces the operators binding at least as tight as precedence, down to
+    // the innermost open bracket
+    auto reduce = [&](int precedence) {
+        while (!operators.empty() && operators.back().precedence >= precedence) {
+            PendingOperator pending = operators.back();
+            operators.pop_back();
+
+            std::unique_ptr<Expression> right = std::move(operands.back());
+            operands.pop_back();
+            if (pending.precedence == PREFIX_PRECEDENCE) {
+                operands.push_back(std::make_unique<UnaryExpression>(
+                    pending.op, std::move(right)));
+                continue;
+            }
+            std::unique_ptr<Expression> left = std::move(operands.back());
+            operands.back() = std::make_unique<BinaryExpression>(
+                std::move(left), pending.op, std::move(right));
+        }
+    };
+
+    while (true) {
+        // Prefix operators and open brackets, then an operand
+        while (matchAny({TokenType::BANG, TokenType::MINUS, TokenType::LPAREN})) {
+            const Token &token = previous();
+            if (token.type() == TokenType::LPAREN) {
+                operators.push_back({token, BRACKET_PRECEDENCE});
+                openBrackets++;
+            } else {
+                operators.push_back({token, PREFIX_PRECEDENCE});
+            }
+        }
+        operands.push_back(primary());
+
+        // Each ')' closes exactly one open bracket, any other ends the
+        // expression for the caller to handle
+        while (openBrackets > 0 && matchAny({TokenType::RPAREN})) {
+            reduce(BRACKET_PRECEDENCE + 1);
+            operators.pop_back();
+            openBrackets--;
+        }
+
+        int precedence = binaryPrecedence(peek().type());
+        if (precedence == 0)
+            break;
+        reduce(precedence);
+        operators.push_back({peek(), precedence});
+        consume();
     }
-    return primary();
+
+    if (openBrackets > 0)
+        throw MissingClosingBracket(peek().sourceOffset(), peek().length());
+
+    reduce(BRACKET_PRECEDENCE + 1);
+    return std::move(operands.back());
 }
+
 std::unique_ptr<Expression> Parser::primary() {
     if (matchAny({TokenType::FALSE, TokenType::TRUE, TokenType::NUMBER,
                   TokenType::STRING})) {
-        Token literal = previous();
-        return std::make_unique<LiteralExpression>(
-            LiteralExpression(literal.type(), literal.literal()));
+        const Token &literal = previous();
+        return std::make_unique<LiteralExpression>(literal.type(),
+                                                   text(literal));
     }
 
-    if (matchAny({TokenType::LPAREN})) {
-        std::unique_ptr<Expression> innerExpression = expression();
-
-        uint16_t length{0};
-        do {
-            // Consumes token in matchAny()...
-            length += peek().length();
-        } while (matchAny({TokenType::RPAREN}));
-
-        // Verify it wasn't a EOF token
-        Token token = previous();
-        if (token.type() != TokenType::RPAREN) {
-            throw MissingClosingBracket(peek().sourceOffset(), length);
-        }
-        return innerExpression;
-    }
-
-    throw UnexpectedToken(peek());
+    throw UnexpectedToken(peek(), text(peek()));
 }
 
 bool Parser::matchAny(std::initializer_list<TokenType> tokenTypes) {
@@ -197,9 +262,13 @@ inline bool Parser::isAtEnd() const {
     return lexemes[currentIndex].type() == TokenType::END_OF_FILE;
 }
 
-inline Token Parser::previous() const { return lexemes[currentIndex - 1]; }
+inline const Token &Parser::previous() const { return lexemes[currentIndex - 1]; }
 
-inline Token Parser::peek() const { return lexemes[currentIndex]; }
+inline const Token &Parser::peek() const { return lexemes[currentIndex]; }
+
+inline std::string_view Parser::text(const Token &token) const {
+    return token.text(source);
+}
 
 inline bool Parser::isOfType(TokenType typeToCheck,
                              std::initializer_list<TokenType> types) const {
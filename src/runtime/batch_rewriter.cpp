@@ -0,0 +1,58 @@
+#include "runtime/batch_rewriter.h"
+
+#include <algorithm>
+
+// Terms a worker keeps between expressions before starting over. Keeping them
+// lets expressions with common subterms share work, clearing them bounds
+// memory on long batches.
+static constexpr size_t WORKER_TABLE_LIMIT = 1 << 16;
+
+BatchRewriter::BatchRewriter(const Environment &environment, size_t threads,
+                             size_t budget)
+    : environment{environment}, pool{threads}, rewriteBudget{budget} {
+    for (size_t i = 0; i < pool.size(); i++)
+        workers.push_back(std::make_unique<Worker>());
+}
+
+template <typename Normalize>
+std::vector<BatchResult>
+BatchRewriter::run(const std::vector<std::unique_ptr<Expression>> &expressions,
+                   Normalize normalize) {
+    std::vector<BatchResult> results(expressions.size());
+
+    // Small tasks so stealing can balance expressions of uneven cost, but not
+    // so small that queueing dominates
+    const size_t grain = std::clamp<size_t>(
+        expressions.size() / (pool.size() * 8), 1, 64);
+
+    pool.parallelFor(expressions.size(), grain, [&](size_t index, size_t id) {
+        Worker &worker = *workers[id];
+        if (worker.terms.size() > WORKER_TABLE_LIMIT)
+            worker.terms.clear();
+
+        const Term *source = worker.terms.intern(*expressions[index]);
+        NormalizeResult normalized = normalize(worker, source);
+        results[index] = BatchResult{TermTable::toExpression(normalized.term),
+                                     normalized.rewrites};
+    });
+
+    return results;
+}
+
+std::vector<BatchResult> BatchRewriter::normalize(
+    const std::vector<std::unique_ptr<Expression>> &expressions) {
+    std::shared_ptr<const RuleSet> rules = environment.snapshot();
+    return run(expressions, [&](Worker &worker, const Term *source) {
+        return worker.rewriter.normalize(worker.terms, source,
+                                         rules->ruleIndex(), rewriteBudget);
+    });
+}
+
+std::vector<BatchResult> BatchRewriter::normalize(
+    const std::vector<std::unique_ptr<Expression>> &expressions,
+    const std::vector<const Rule *> &rules) {
+    return run(expressions, [&](Worker &worker, const Term *source) {
+        return worker.rewriter.normalize(worker.terms, source, rules,
+                                         rewriteBudget);
+    });
+}
@@ -0,0 +1,38 @@
+#include "runtime/carl_object.h"
+#include "carl_stats.h"
+#include "runtime/string_pool.h"
+
+#include <new>
+
+ObjString *ObjString::create(std::string_view first, std::string_view second) {
+    CARL_STAT_COUNT(STAT_STRING_ALLOCATIONS);
+    const size_t length = first.size() + second.size();
+    void *memory = StringPool::local().allocate(sizeof(ObjString) + length + 1);
+
+    ObjString *string = new (memory) ObjString{Obj{OBJ_STRING},
+                                               static_cast<uint32_t>(length)};
+    first.copy(string->chars(), first.size());
+    second.copy(string->chars() + first.size(), second.size());
+    string->chars()[length] = '\0';
+    return string;
+}
+
+void ObjString::destroy(ObjString *string) noexcept {
+    StringPool::local().deallocate(string, sizeof(ObjString) + string->length + 1);
+}
+
+Value Value::string(std::string_view first, std::string_view second) {
+    Value value;
+    const size_t length = first.size() + second.size();
+    if (length <= SHORT_STRING_MAX) {
+        value.type = ValueType::VALUE_SHORT_STRING;
+        value.shortLength = static_cast<uint8_t>(length);
+        first.copy(value.shortChars, first.size());
+        second.copy(value.shortChars + first.size(), second.size());
+        return value;
+    }
+
+    value.type = ValueType::VALUE_OBJ;
+    value.obj = reinterpret_cast<Obj *>(ObjString::create(first, second));
+    return value;
+}
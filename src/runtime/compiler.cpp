@@ -0,0 +1,165 @@
+#include "runtime/compiler.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "runtime/carl_object.h"
+#include "runtime/chunk.h"
+#include "runtime/runtime_errors.h"
+
+#include <cstdlib>
+#include <string>
+
+void Compiler::begin() {
+    chunk = Chunk();
+    numberConstants.clear();
+    stackDepth = 0;
+    maxStackDepth = 0;
+}
+
+Chunk Compiler::finish() {
+    chunk.write(OP_RETURN);
+    chunk.setMaxStackDepth(maxStackDepth);
+    return std::move(chunk);
+}
+
+Chunk Compiler::compile(Expression &expression) {
+    begin();
+    // Operands are compiled before their operator, the VM is a stack machine
+    walkPostOrder(expression, *this);
+    return finish();
+}
+
+Chunk Compiler::compile(const FlatExpression &expression) {
+    begin();
+    // Already in postfix order
+    for (FlatExpression::Index node = 0; node < expression.size(); node++) {
+        switch (expression.arity(node)) {
+        case 0:
+            emitLiteral(expression.type(node), expression.literal(node));
+            break;
+        case 1:
+            emitUnary(expression.token(node));
+            break;
+        default:
+            emitBinary(expression.token(node));
+        }
+    }
+    return finish();
+}
+
+void Compiler::pushed(size_t count) {
+    stackDepth += count;
+    if (stackDepth > maxStackDepth)
+        maxStackDepth = stackDepth;
+}
+
+void Compiler::popped(size_t count) { stackDepth -= count; }
+
+void Compiler::emitConstantIndex(size_t index) {
+    if (index <= UINT8_MAX) {
+        chunk.write(OP_CONSTANT);
+        chunk.write(static_cast<uint8_t>(index));
+    } else {
+        chunk.write(OP_CONSTANT_LONG);
+        chunk.write(static_cast<uint8_t>(index & 0xff));
+        chunk.write(static_cast<uint8_t>((index >> 8) & 0xff));
+        chunk.write(static_cast<uint8_t>((index >> 16) & 0xff));
+    }
+    pushed();
+}
+
+void Compiler::emitConstant(Value value) {
+    // Numbers are deduplicated since deep arithmetic trees tend to repeat them
+    if (value.type == ValueType::VALUE_NUMBER) {
+        auto it = numberConstants.find(value.number);
+        if (it != numberConstants.end()) {
+            emitConstantIndex(it->second);
+            return;
+        }
+    }
+
+    if (chunk.constants().size() >= maxConstants)
+        throw TooManyConstants(0, 0, maxConstants);
+
+    size_t index = chunk.addConstant(value);
+    if (value.type == ValueType::VALUE_NUMBER)
+        numberConstants[value.number] = index;
+    emitConstantIndex(index);
+}
+
+void Compiler::visitLiteralExpression(LiteralExpression &expression) {
+    emitLiteral(expression.type(), expression.literal());
+}
+
+void Compiler::visitUnaryExpression(UnaryExpression &expression) {
+    emitUnary(expression.op());
+}
+
+void Compiler::visitBinaryExpression(BinaryExpression &expression) {
+    emitBinary(expression.op());
+}
+
+void Compiler::emitLiteral(TokenType type, const std::string &literal) {
+    switch (type) {
+    case TokenType::STRING: {
+        Value value = Value::string(literal);
+        emitConstant(value);
+        break;
+    }
+    case TokenType::TRUE:
+        chunk.write(OP_TRUE);
+        pushed();
+        break;
+    case TokenType::FALSE:
+        chunk.write(OP_FALSE);
+        pushed();
+        break;
+    case TokenType::NUMBER: {
+        Value value;
+        value.type = ValueType::VALUE_NUMBER;
+        // The lexer only produces well formed numbers, and like the
+        // constant folder, ones too large for a double become inf
+        value.number = std::strtod(literal.c_str(), nullptr);
+        emitConstant(value);
+        break;
+    }
+
+    default:
+        throw InternalError(0, 0, "no instruction for literals of type " +
+                                      TokenTypesToString[type]);
+    }
+}
+
+void Compiler::emitUnary(const Token &op) {
+    switch (op.type()) {
+    case TokenType::MINUS:
+        chunk.write(OP_NEGATE, op.sourceOffset(), op.length());
+        break;
+    case TokenType::BANG:
+        chunk.write(OP_NOT, op.sourceOffset(), op.length());
+        break;
+
+    default:
+        throw InternalError(op, "no instruction for operator '" + op.literal() + "'");
+    }
+}
+
+void Compiler::emitBinary(const Token &op) {
+    switch (op.type()) {
+    case TokenType::PLUS:
+        chunk.write(OP_ADD, op.sourceOffset(), op.length());
+        break;
+    case TokenType::MINUS:
+        chunk.write(OP_SUBTRACT, op.sourceOffset(), op.length());
+        break;
+    case TokenType::STAR:
+        chunk.write(OP_MULTIPLY, op.sourceOffset(), op.length());
+        break;
+    case TokenType::SLASH:
+        chunk.write(OP_DIVIDE, op.sourceOffset(), op.length());
+        break;
+
+    default:
+        throw InternalError(op, "no instruction for operator '" + op.literal() + "'");
+    }
+    popped();
+}
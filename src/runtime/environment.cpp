@@ -0,0 +1,103 @@
+#include "runtime/environment.h"
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+void RuleSet::define(SymbolId name, std::shared_ptr<const Rule> rule) {
+    auto &slot = definitions[name];
+    if (slot != nullptr)
+        index.remove(slot.get());
+    else if (needsIndexing() && inLibrary(name))
+        shadowed++;
+
+    index.insert(rule.get());
+    slot = std::move(rule);
+}
+
+void RuleSet::attach(std::shared_ptr<const RuleLibrary> library_) {
+    assert(library == nullptr);
+    library = std::move(library_);
+    libraryOrder = index.reserveOrders(library->size());
+    for (const auto &definition : definitions)
+        if (inLibrary(definition.first))
+            shadowed++;
+}
+
+void RuleSet::indexLibrary() {
+    if (!needsIndexing())
+        return;
+    for (uint32_t rule = 0; rule < library->size(); rule++) {
+        // Names defined since take precedence
+        auto [slot, inserted] =
+            definitions.try_emplace(internSymbol(library->name(rule)));
+        if (!inserted)
+            continue;
+        slot->second = library->rule(rule);
+        index.insert(slot->second.get(), libraryOrder + rule);
+    }
+    libraryIndexed = true;
+    shadowed = 0;
+}
+
+const Rule *RuleSet::find(SymbolId name) const {
+    auto it = definitions.find(name);
+    if (it != definitions.end())
+        return it->second.get();
+    return needsIndexing() ? share(name).get() : nullptr;
+}
+
+std::shared_ptr<const Rule> RuleSet::share(SymbolId name) const {
+    auto it = definitions.find(name);
+    if (it != definitions.end())
+        return it->second;
+    if (!needsIndexing())
+        return nullptr;
+
+    // The library keeps the rules it decoded
+    const uint32_t rule = library->find(symbolName(name));
+    return rule != RuleLibrary::NONE ? library->rule(rule) : nullptr;
+}
+
+Environment::Environment() : current{std::make_shared<RuleSet>()} {}
+
+std::shared_ptr<const RuleSet> Environment::snapshot() const {
+    std::lock_guard lock{mutex};
+    return current;
+}
+
+RuleSet &Environment::writable() {
+    // New references are only handed out under the lock, so the count can
+    // only drop while it's held. Once it's 1 every reader has let go; the
+    // fence orders their last reads before the writes that follow.
+    if (current.use_count() > 1)
+        current = std::make_shared<RuleSet>(*current);
+    else
+        std::atomic_thread_fence(std::memory_order_acquire);
+    return *current;
+}
+
+void Environment::addDefinition(SymbolId name,
+                                std::unique_ptr<Rule> definition) {
+    std::lock_guard lock{mutex};
+    writable().define(name, std::move(definition));
+}
+
+void Environment::addDefinitions(
+    std::vector<std::pair<SymbolId, std::unique_ptr<Rule>>> definitions) {
+    std::lock_guard lock{mutex};
+    RuleSet &rules = writable();
+    for (auto &[name, definition] : definitions)
+        rules.define(name, std::move(definition));
+}
+
+void Environment::loadLibrary(std::shared_ptr<const RuleLibrary> library) {
+    std::lock_guard lock{mutex};
+    writable().attach(std::move(library));
+}
+
+void Environment::indexLibrary() {
+    std::lock_guard lock{mutex};
+    if (current->needsIndexing())
+        writable().indexLibrary();
+}
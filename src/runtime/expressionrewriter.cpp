@@ -1,7 +1,9 @@
 #include "runtime/expressionrewriter.h"
+#include "carl_stats.h"
 #include "lexer/token.h"
 #include "parser/ast_printer.h"
 #include "parser/expression.h"
+#include "runtime/runtime_errors.h"
 #include <cassert>
 #include <exception>
 #include <fmt/core.h>
@@ -18,11 +20,11 @@ ExpressionRewriter::substitute(std::unique_ptr<Expression> rootSource,
 
     // Create reverse polish notation sequence for the pattern to search for
     state = PROCCESING_PATTERN;
-    pattern->accept(*this);
+    walkPostOrder(*pattern, *this);
 
     state = PROCESSING_SOURCE;
 
-    rootSource->accept(*this);
+    walkPostOrder(*rootSource, *this);
 
     // No substitution needed when no matches are found
     if (!match)
@@ -30,7 +32,7 @@ ExpressionRewriter::substitute(std::unique_ptr<Expression> rootSource,
 
     // Resolve all symbols in this->replacement to the corresponding found in the
     // source
-    this->replacement->accept(*this);
+    walkPostOrder(*this->replacement, *this);
 
     if (replacementParent == nullptr)
         return std::move(this->replacement);
@@ -139,8 +141,13 @@ void ExpressionRewriter::resolveReplacement() {
     LiteralExpression *nodeStr = static_cast<LiteralExpression *>(node);
     auto correspondingExpression = symbolMap.find(nodeStr->literal());
     assert(correspondingExpression != symbolMap.end());
+
+    // The bound subexpression is still owned by the source, which gets
+    // destroyed when the match is replaced, so the replacement needs its own
+    // copy
+    std::unique_ptr<Expression> value = correspondingExpression->second->clone();
     if (node->parent == nullptr) {
-        this->replacement = std::unique_ptr<Expression>(correspondingExpression->second);
+        this->replacement = std::move(value);
         return;
     }
     switch (node->parent->expressionType()) {
@@ -154,7 +161,6 @@ void ExpressionRewriter::resolveReplacement() {
 
         // Figure out which side of operator the nodeToReplace is on
         bool rhs = &parent->right() == node ? true : false;
-        auto value = std::unique_ptr<Expression>(correspondingExpression->second);
 
         if (rhs)
             parent->setRight(std::move(value));
@@ -166,8 +172,7 @@ void ExpressionRewriter::resolveReplacement() {
     case EXPR_NEGATE: {
         UnaryExpression *parent = static_cast<UnaryExpression *>(node->parent);
 
-        parent->setOperand(
-            std::unique_ptr<Expression>(correspondingExpression->second));
+        parent->setOperand(std::move(value));
         break;
     }
 
@@ -199,11 +204,211 @@ void ExpressionRewriter::visitLiteralExpression(LiteralExpression &expression) {
     push(expression);
 }
 void ExpressionRewriter::visitBinaryExpression(BinaryExpression &expression) {
-    expression.left().accept(*this);
-    expression.right().accept(*this);
     push(expression);
 }
 void ExpressionRewriter::visitUnaryExpression(UnaryExpression &expression) {
-    expression.operand().accept(*this);
     push(expression);
 }
+
+const Term *ExpressionRewriter::substitute(TermTable &table,
+                                           const Term *source,
+                                           const Rule &rule) {
+    if (cache != nullptr) {
+        if (const Term *cached = cache->find(rule.id(), source)) {
+            CARL_STAT_COUNT(STAT_RULE_TRIES);
+            if (cached != source)
+                CARL_STAT_COUNT(STAT_RULE_REWRITES);
+            return cached;
+        }
+    }
+
+    termPath.clear();
+    termsWithoutMatch.clear();
+
+    // Post-order walk keeping the path from the root, so a match can be
+    // spliced in by rebuilding only its ancestors
+    termPath.push_back(TermFrame{source, 0});
+    while (!termPath.empty()) {
+        TermFrame &frame = termPath.back();
+        if (frame.nextChild < frame.term->arity()) {
+            const Term *child = frame.term->child(frame.nextChild++);
+            // Literals are cheaper to match again than to look up
+            if (child->arity() == 0) {
+                termPath.push_back(TermFrame{child, 0});
+                continue;
+            }
+
+            if (cache != nullptr) {
+                const Term *cached = cache->find(rule.id(), child);
+                if (cached == nullptr) {
+                    termPath.push_back(TermFrame{child, 0});
+                    continue;
+                }
+                CARL_STAT_COUNT(STAT_RULE_TRIES);
+                // Everything before child had no match, so a match inside
+                // child is the first one
+                if (cached != child) {
+                    CARL_STAT_COUNT(STAT_RULE_REWRITES);
+                    return splice(table, rule, cached);
+                }
+            } else if (!termsWithoutMatch.contains(child)) {
+                // Shared subterms only have to be searched once
+                termPath.push_back(TermFrame{child, 0});
+            }
+            continue;
+        }
+
+        CARL_STAT_COUNT(STAT_RULE_TRIES);
+        if (!rule.matcher().match(frame.term, matchState)) {
+            if (frame.term->arity() != 0) {
+                if (cache != nullptr)
+                    cache->insert(rule.id(), frame.term, frame.term);
+                else
+                    termsWithoutMatch.insert(frame.term);
+            }
+            termPath.pop_back();
+            continue;
+        }
+
+        CARL_STAT_COUNT(STAT_RULE_REWRITES);
+        const Term *result = rule.matcher().build(table, matchState);
+        if (cache != nullptr && frame.term->arity() != 0)
+            cache->insert(rule.id(), frame.term, result);
+        termPath.pop_back();
+        return splice(table, rule, result);
+    }
+
+    return source;
+}
+
+const Term *ExpressionRewriter::splice(TermTable &table, const Rule &rule,
+                                       const Term *result) {
+    while (!termPath.empty()) {
+        const TermFrame &parent = termPath.back();
+        const bool rhs = parent.nextChild == 2;
+        result = table.withChildren(parent.term,
+                                    rhs ? parent.term->left() : result,
+                                    rhs ? result : parent.term->right());
+        if (cache != nullptr)
+            cache->insert(rule.id(), parent.term, result);
+        termPath.pop_back();
+    }
+    return result;
+}
+
+NormalizeResult ExpressionRewriter::normalize(TermTable &table,
+                                              const Term *source,
+                                              const std::vector<const Rule *> &rules,
+                                              size_t budget,
+                                              const Token *statement) {
+    return normalizeWith(table, source, budget, statement,
+                         [&rules](const Term *) -> const std::vector<const Rule *> & {
+                             return rules;
+                         });
+}
+
+NormalizeResult ExpressionRewriter::normalize(TermTable &table,
+                                              const Term *source,
+                                              const RuleIndex &index,
+                                              size_t budget,
+                                              const Token *statement) {
+    return normalizeWith(table, source, budget, statement,
+                         [this, &index](const Term *term) -> const std::vector<const Rule *> & {
+                             index.candidates(term, candidateRules, candidateScratch);
+                             return candidateRules;
+                         });
+}
+
+template <typename RulesFor>
+NormalizeResult ExpressionRewriter::normalizeWith(TermTable &table,
+                                                  const Term *source,
+                                                  size_t budget,
+                                                  const Token *statement,
+                                                  RulesFor rulesFor) {
+    worklist.clear();
+    normalForms.clear();
+    size_t rewrites = 0;
+
+    worklist.push_back(NormalizeFrame{source, nullptr});
+    while (!worklist.empty()) {
+        NormalizeFrame frame = worklist.back();
+        if (normalForms.contains(frame.term)) {
+            worklist.pop_back();
+            continue;
+        }
+
+        // Waiting on the rewritten term, which is now normalized
+        if (frame.redex != nullptr) {
+            normalForms[frame.term] = normalForms.at(frame.redex);
+            worklist.pop_back();
+            continue;
+        }
+
+        // Children first, the ones already normalized aren't revisited
+        bool pending = false;
+        for (size_t i = 0; i < frame.term->arity(); i++) {
+            const Term *child = frame.term->child(i);
+            if (!normalForms.contains(child)) {
+                worklist.push_back(NormalizeFrame{child, nullptr});
+                pending = true;
+            }
+        }
+        if (pending)
+            continue;
+
+        const Term *left = frame.term->left() == nullptr
+                               ? nullptr
+                               : normalForms.at(frame.term->left());
+        const Term *right = frame.term->right() == nullptr
+                                ? nullptr
+                                : normalForms.at(frame.term->right());
+        const Term *term = table.withChildren(frame.term, left, right);
+
+        // The children of term are normal forms, so a rule can only match
+        // at its root and substitute() would give the same result. Both
+        // share the cache, across statements.
+        const bool cacheable = cache != nullptr && term->arity() != 0;
+        const Term *rewritten = nullptr;
+        for (const Rule *rule : rulesFor(term)) {
+            CARL_STAT_COUNT(STAT_RULE_TRIES);
+            if (cacheable) {
+                if (const Term *cached = cache->find(rule->id(), term)) {
+                    if (cached == term)
+                        continue;
+                    CARL_STAT_COUNT(STAT_RULE_REWRITES);
+                    rewritten = cached;
+                    break;
+                }
+            }
+            if (rule->matcher().match(term, matchState)) {
+                CARL_STAT_COUNT(STAT_RULE_REWRITES);
+                rewritten = rule->matcher().build(table, matchState);
+                if (cacheable)
+                    cache->insert(rule->id(), term, rewritten);
+                break;
+            }
+            if (cacheable)
+                cache->insert(rule->id(), term, term);
+        }
+
+        if (rewritten == nullptr) {
+            normalForms[frame.term] = term;
+            normalForms[term] = term;
+            worklist.pop_back();
+            continue;
+        }
+
+        if (++rewrites > budget)
+            throw RewriteLimitExceeded(
+                statement != nullptr ? statement->sourceOffset() : 0,
+                statement != nullptr ? statement->length() : 0,
+                fmt::format("Rewrite budget of {} exhausted, the rules might "
+                            "not terminate",
+                            budget));
+
+        worklist.back().redex = rewritten;
+        worklist.push_back(NormalizeFrame{rewritten, nullptr});
+    }
+
+    return NormalizeResult{normalForms.at(source), rewrites};
+}
@@ -1,14 +1,16 @@
 #include "runtime/interpreter.h"
+#include "carl_stats.h"
 #include "lexer/token.h"
 #include "parser/ast_printer.h"
+#include "parser/constant_folder.h"
 #include "parser/expression.h"
 #include "parser/statement.h"
 #include "runtime/carl_object.h"
 #include "runtime/expressionrewriter.h"
 #include "runtime/runtime_errors.h"
-#include <cstring>
 #include <fmt/core.h>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <vector>
 
@@ -22,17 +24,59 @@ Interpreter::Interpreter(std::unique_ptr<Statement> _statement) {
 }
 
 std::optional<Value> Interpreter::interpret(std::vector<std::unique_ptr<Statement>> statements_) {
+    // Chunks are keyed by expression address, which the new statements might
+    // reuse
+    chunks.clear();
+    flats.clear();
+    program.reset();
     statements = std::move(statements_);
+    statementsFolded = false;
     return interpret();
 }
 
+std::optional<Value> Interpreter::interpret(std::shared_ptr<const ParsedProgram> program_) {
+    chunks.clear();
+    flats.clear();
+    statements.clear();
+    program = std::move(program_);
+    return run(program->statements());
+}
+
 std::optional<Value> Interpreter::interpret() {
+    if (program)
+        return run(program->statements());
+
+    // Once per statement list, so re-running them doesn't fold again
+    if (constantFolding && !statementsFolded) {
+        ConstantFolder folder;
+        for (auto &statement : statements)
+            folder.fold(*statement);
+        statementsFolded = true;
+        // Folded nodes may reuse the addresses of compiled ones
+        chunks.clear();
+        flats.clear();
+    }
+    return run(statements);
+}
+
+std::optional<Value> Interpreter::run(const std::vector<std::unique_ptr<Statement>> &list) {
     while (workingStack.size() > 0) {
         workingStack.pop();
     }
+    // Terms are only referenced while a statement runs, but are kept a
+    // while so later statements can reuse cached rewrites of them. Clearing
+    // also frees the text of their literals.
+    if (terms.size() > TERM_TABLE_LIMIT) {
+        terms.clear();
+        rewriteCache.clear();
+    }
 
-    for (int i = 0; i < statements.size(); i++) {
-        statements[i]->accept(*this);
+    for (size_t i = 0; i < list.size(); i++) {
+        // Only the last value is handed to the caller, earlier ones are
+        // released here
+        if (i > 0)
+            discardValues();
+        list[i]->accept(*this);
     }
 
     // Statements might not produce a value
@@ -42,50 +86,144 @@ std::optional<Value> Interpreter::interpret() {
     return workingStack.top();
 }
 
+void Interpreter::discardValues() {
+    while (!workingStack.empty()) {
+        workingStack.top().dispose();
+        workingStack.pop();
+    }
+}
+
 void Interpreter::visitExpressionStatement(ExpressionStatement &statement) {
-    statement.expression().accept(*this);
+    CARL_STAT_TIME(STAT_VISIT_EXPRESSION);
+    if (mode == EXECUTE_TREE_WALK) {
+        walkPostOrder(statement.expression(), *this);
+        return;
+    }
+
+    Expression *expression = &statement.expression();
+    if (mode == EXECUTE_FLAT) {
+        auto flat = flats.find(expression);
+        if (flat == flats.end())
+            flat = flats.emplace(expression, FlatExpression{*expression}).first;
+        evaluate(flat->second);
+        return;
+    }
+
+    // Programs come with their bytecode
+    const Chunk *compiled = program ? program->chunk(*expression) : nullptr;
+    if (compiled == nullptr) {
+        auto chunk = chunks.find(expression);
+        if (chunk == chunks.end()) {
+            try {
+                chunk = chunks.emplace(expression, compiler.compile(*expression)).first;
+            } catch (const TooManyConstants &) {
+                // Too large for a chunk, but the tree walker has no limit
+                walkPostOrder(*expression, *this);
+                return;
+            }
+        }
+        compiled = &chunk->second;
+    }
+
+    workingStack.push(vm.run(*compiled));
 }
 
 void Interpreter::visitDefineStatement(DefineStatement &statement) {
-    // NOTE: this invalidates the statement since we move the pattern & replacement. Is this okay?
-    std::unique_ptr<Rule> newDefinition = std::make_unique<Rule>(statement.borrowPattern(), statement.borrowReplacement());
-    environment.addDefinition(statement.ruleName(), std::move(newDefinition));
+    CARL_STAT_TIME(STAT_VISIT_DEFINE);
+    std::unique_ptr<Rule> newDefinition = std::make_unique<Rule>(statement.pattern(), statement.replacement());
+    environment.addDefinition(statement.ruleSymbol(), std::move(newDefinition));
 }
 
 void Interpreter::visitApplyStatement(ApplyStatement& statement) {
-    auto definition = environment.getDefinition(statement.ruleName());
-    if (definition == environment.end()) {
+    CARL_STAT_TIME(STAT_VISIT_APPLY);
+    // Rules stay alive and unchanged while the snapshot is held
+    std::shared_ptr<const RuleSet> rules = environment.snapshot();
+    const Rule *definition = rules->find(statement.ruleSymbol());
+    if (definition == nullptr) {
         throw NoRuleFound(Token(TokenType::APPLY, 0, 5, "apply"), "Definition '" + statement.ruleName() + "' is not defined");
     }
+    // Rewriting works on the interned source, so neither the statement nor
+    // the rule has to be copied
+    const Term *source = terms.intern(statement.expression());
     ExpressionRewriter rewriter;
-    auto res = rewriter.substitute(statement.borrowExpression(), definition->second->copyPattern(), definition->second->copyReplacement());
-    this->result = res->toString();
-    std::cout << "\t# " << res->toString() << std::endl;
+    rewriter.setCache(&rewriteCache);
+    const Term *res = rewriter.substitute(terms, source, *definition);
+    this->result = TermTable::toString(res);
+    std::cout << "\t# " << this->result << std::endl;
 }
 
+void Interpreter::visitNormalizeStatement(NormalizeStatement &statement) {
+    CARL_STAT_TIME(STAT_VISIT_NORMALIZE);
+    // Candidates come from the index, which needs every rule of a library
+    if (statement.ruleNames().empty())
+        environment.indexLibrary();
+    std::shared_ptr<const RuleSet> ruleSet = environment.snapshot();
+    std::vector<const Rule *> rules;
+    for (SymbolId ruleName : statement.ruleNames()) {
+        const Rule *definition = ruleSet->find(ruleName);
+        if (definition == nullptr) {
+            throw NoRuleFound(statement.keyword(), "Definition '" + symbolName(ruleName) + "' is not defined");
+        }
+        rules.push_back(definition);
+    }
+
+    const Term *source = terms.intern(statement.expression());
+    ExpressionRewriter rewriter;
+    rewriter.setCache(&rewriteCache);
+    // Without explicit rules, candidates for each subterm come from the index
+    NormalizeResult normalized = rules.empty()
+        ? rewriter.normalize(terms, source, ruleSet->ruleIndex(), rewriteBudget, &statement.keyword())
+        : rewriter.normalize(terms, source, rules, rewriteBudget, &statement.keyword());
+
+    this->result = TermTable::toString(normalized.term);
+    this->rewrites = normalized.rewrites;
+    std::cout << "\t# " << this->result << " (" << this->rewrites << " rewrites)" << std::endl;
+}
 
 void Interpreter::visitShowStatement(ShowStatement& statement) {
+    CARL_STAT_TIME(STAT_VISIT_SHOW);
+    // Streamed, large expressions aren't built into a string first
     AstPrinter printer;
-    std::cout << "\t# " << printer.print(statement.expression()) << std::endl;
+    std::cout << "\t# ";
+    printer.print(statement.expression(), std::ostreambuf_iterator<char>(std::cout));
+    std::cout << std::endl;
 }
 
 void Interpreter::visitLiteralExpression(LiteralExpression &expression) {
-    switch (expression.type()) {
-    case TokenType::STRING: {
-        Value value;
-        value.type = ValueType::VALUE_OBJ;
+    CARL_STAT_COUNT(STAT_VISIT_LITERAL);
+    pushLiteral(expression.type(), expression.literal());
+}
 
-        // TODO: custom allocator
-        ObjString *objStr = new ObjString();
-        objStr->obj.objType = OBJ_STRING;
+void Interpreter::visitUnaryExpression(UnaryExpression &expression) {
+    CARL_STAT_COUNT(STAT_VISIT_UNARY);
+    applyUnary(expression.op());
+}
 
-        objStr->length = expression.literal().size();
-        objStr->chars = new char[objStr->length + 1];
-        std::memcpy(objStr->chars, expression.literal().c_str(),
-                    objStr->length);
-        objStr->chars[objStr->length] = '\0';
+void Interpreter::visitBinaryExpression(BinaryExpression &expression) {
+    CARL_STAT_COUNT(STAT_VISIT_BINARY);
+    applyBinary(expression.op());
+}
+
+void Interpreter::evaluate(const FlatExpression &expression) {
+    // Post-order, so each operator finds its operands on the stack
+    for (FlatExpression::Index node = 0; node < expression.size(); node++) {
+        switch (expression.arity(node)) {
+        case 0:
+            pushLiteral(expression.type(node), expression.literal(node));
+            break;
+        case 1:
+            applyUnary(expression.token(node));
+            break;
+        default:
+            applyBinary(expression.token(node));
+        }
+    }
+}
 
-        value.obj = reinterpret_cast<Obj *>(objStr);
+void Interpreter::pushLiteral(TokenType type, const std::string &literal) {
+    switch (type) {
+    case TokenType::STRING: {
+        Value value = Value::string(literal);
         workingStack.push(value);
         break;
     }
@@ -106,7 +244,7 @@ void Interpreter::visitLiteralExpression(LiteralExpression &expression) {
     case TokenType::NUMBER: {
         Value value;
         value.type = ValueType::VALUE_NUMBER;
-        value.number = std::stod(expression.literal()); // TODO: check for err
+        value.number = std::stod(literal); // TODO: check for err
         workingStack.push(value);
         break;
     }
@@ -116,12 +254,10 @@ void Interpreter::visitLiteralExpression(LiteralExpression &expression) {
     }
 }
 
-void Interpreter::visitUnaryExpression(UnaryExpression &expression) {
-    // Eval operand
-    expression.operand().accept(*this);
+void Interpreter::applyUnary(const Token &op) {
+    // The operand was evaluated first
     Value operand = workingStack.top();
     workingStack.pop();
-    const Token &op = expression.op();
 
     switch (op.type()) {
     case TokenType::MINUS:
@@ -156,18 +292,12 @@ void Interpreter::visitUnaryExpression(UnaryExpression &expression) {
     operand.dispose();
 }
 
-void Interpreter::visitBinaryExpression(BinaryExpression &expression) {
-    // Eval left
-    expression.left().accept(*this);
-    Value l = workingStack.top();
-    workingStack.pop();
-
-    // Eval right
-    expression.right().accept(*this);
+void Interpreter::applyBinary(const Token &op) {
+    // Both operands were evaluated first, right on top
     Value r = workingStack.top();
     workingStack.pop();
-
-    const Token &op = expression.op();
+    Value l = workingStack.top();
+    workingStack.pop();
 
     Value result;
     if (l.type == VALUE_NUMBER && r.type == VALUE_NUMBER) {
@@ -194,21 +324,7 @@ void Interpreter::visitBinaryExpression(BinaryExpression &expression) {
         }
         // String concat
     } else if (IS_STRING(l) && IS_STRING(r) && op.type() == TokenType::PLUS) {
-        ObjString *left = reinterpret_cast<ObjString *>(l.obj);
-        ObjString *right = reinterpret_cast<ObjString *>(r.obj);
-
-        size_t resultLength = left->length + right->length;
-        char *resultStr = new char[resultLength + 1];
-        std::memcpy(resultStr, left->chars, left->length);
-        std::memcpy(resultStr + left->length, right->chars, right->length);
-        resultStr[resultLength] = '\0';
-
-        ObjString *resultObjString = new ObjString();
-        resultObjString->length = resultLength;
-        resultObjString->chars = resultStr;
-        resultObjString->obj.objType = ObjectType::OBJ_STRING;
-        result.type = ValueType::VALUE_OBJ;
-        result.obj = reinterpret_cast<Obj *>(resultObjString);
+        result = Value::string(l.asString(), r.asString());
     } else {
         throw TypeMismatch(op, "Type Mismatch, binary operation expects two "
                                "numbers or two strings");
@@ -0,0 +1,112 @@
+#include "runtime/parse_cache.h"
+#include "carl_stats.h"
+#include "lexer/lexer.h"
+#include "parser/constant_folder.h"
+#include "parser/istatement_visitor.h"
+#include "parser/parser.h"
+#include "runtime/compiler.h"
+#include "runtime/runtime_errors.h"
+
+#include <functional>
+#include <utility>
+
+namespace {
+// Brings every expression of a statement into the state it's read in, so
+// running the program never writes to it: stale hashes are computed, and
+// expression statements compiled
+class Preparer : public IStatementVisitor {
+private:
+    std::unordered_map<const Expression *, Chunk> &chunks;
+    Compiler compiler;
+
+public:
+    Preparer(std::unordered_map<const Expression *, Chunk> &chunks_) : chunks{chunks_} {}
+
+    void visitExpressionStatement(ExpressionStatement &statement) override {
+        statement.expression().hash();
+        try {
+            chunks.emplace(&statement.expression(), compiler.compile(statement.expression()));
+        } catch (const RuntimeException &) {
+            // Left to the interpreter, which reports it when the statement runs
+        }
+    }
+
+    void visitDefineStatement(DefineStatement &statement) override {
+        statement.pattern().hash();
+        statement.replacement().hash();
+    }
+
+    void visitApplyStatement(ApplyStatement &statement) override {
+        statement.expression().hash();
+    }
+
+    void visitNormalizeStatement(NormalizeStatement &statement) override {
+        statement.expression().hash();
+    }
+
+    void visitShowStatement(ShowStatement &statement) override {
+        statement.expression().hash();
+    }
+};
+} // namespace
+
+ParsedProgram::ParsedProgram(std::vector<std::unique_ptr<Statement>> statements,
+                             bool constantFolding)
+    : statements_{std::move(statements)} {
+    if (constantFolding) {
+        ConstantFolder folder;
+        for (auto &statement : statements_)
+            folder.fold(*statement);
+    }
+
+    Preparer preparer{chunks};
+    for (auto &statement : statements_)
+        statement->accept(preparer);
+}
+
+const Chunk *ParsedProgram::chunk(const Expression &expression) const {
+    auto it = chunks.find(&expression);
+    return it != chunks.end() ? &it->second : nullptr;
+}
+
+ParseCache::ParseCache(size_t capacity) : entries{capacity} {}
+
+std::shared_ptr<const ParsedProgram> ParseCache::parse(std::string_view source) {
+    auto parseSource = [&] {
+        Lexer lexer{source};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        return std::make_shared<const ParsedProgram>(parser.parse(), constantFolding);
+    };
+    if (entries.capacity() == 0)
+        return parseSource();
+
+    const size_t hash = std::hash<std::string_view>{}(source);
+    const Entry *entry = entries.find(hash);
+    if (entry != nullptr && entry->source == source) {
+        stats_.hits++;
+        CARL_STAT_COUNT(STAT_PARSE_CACHE_HITS);
+        return entry->program;
+    }
+    stats_.misses++;
+    CARL_STAT_COUNT(STAT_PARSE_CACHE_MISSES);
+
+    // Parsed before touching the cache, errors leave it unchanged. Another
+    // source with the same hash is replaced.
+    std::shared_ptr<const ParsedProgram> program = parseSource();
+    if (entries.insert(hash, Entry{std::string{source}, program}))
+        stats_.evictions++;
+    return program;
+}
+
+void ParseCache::clear() {
+    entries.clear();
+}
+
+void ParseCache::setCapacity(size_t capacity) {
+    entries.setCapacity(capacity);
+}
+
+void ParseCache::setConstantFolding(bool enabled) {
+    constantFolding = enabled;
+    clear();
+}
@@ -0,0 +1,158 @@
+#include "runtime/pattern_matcher.h"
+#include "carl_stats.h"
+#include "runtime/term.h"
+
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+PatternMatcher::PatternMatcher(const Term *pattern, const Term *replacement) {
+    // Variables are interned, so the variable term identifies the variable
+    std::unordered_map<const Term *, uint16_t> variables;
+
+    std::vector<const Term *> pending{pattern};
+    while (!pending.empty()) {
+        const Term *term = pending.back();
+        pending.pop_back();
+
+        if (term->isVariable()) {
+            auto [it, inserted] = variables.try_emplace(term, slotCount);
+            if (inserted)
+                slotCount++;
+            matchCode.push_back(MatchInstruction{inserted ? MATCH_BIND : MATCH_BOUND,
+                                                 term->type(), 0, it->second, 0});
+            continue;
+        }
+
+        switch (term->arity()) {
+        case 0:
+            if (term->type() == TokenType::NUMBER)
+                matchCode.push_back(MatchInstruction{MATCH_NUMBER, term->type(), 0,
+                                                     0, term->number()});
+            else
+                matchCode.push_back(
+                    MatchInstruction{MATCH_TYPE, term->type(), 0, 0, 0});
+            break;
+
+        default:
+            matchCode.push_back(MatchInstruction{MATCH_NODE, term->type(),
+                                                 term->arity(), 0, 0});
+            for (size_t i = term->arity(); i > 0; i--)
+                pending.push_back(term->child(i - 1));
+        }
+    }
+
+    // Replacement in postfix order, built bottom up with a stack
+    struct Frame {
+        const Term *term;
+        bool expanded;
+    };
+    std::vector<Frame> frames{{replacement, false}};
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const Term *term = frame.term;
+
+        if (term->isVariable()) {
+            auto it = variables.find(term);
+            // Strings not bound by the pattern are just strings
+            if (it != variables.end()) {
+                buildCode.push_back(BuildInstruction{BUILD_SLOT, term->type(), 0,
+                                                     it->second, SymbolId{}, 0});
+                continue;
+            }
+        }
+
+        if (term->arity() == 0) {
+            buildCode.push_back(
+                BuildInstruction{BUILD_LITERAL, term->type(), 0, 0, SymbolId{},
+                                 static_cast<uint32_t>(literalTexts.size())});
+            literalTexts.push_back(term->literal());
+            continue;
+        }
+
+        if (frame.expanded) {
+            buildCode.push_back(BuildInstruction{BUILD_NODE, term->type(),
+                                                 term->arity(), 0, term->symbol(), 0});
+            continue;
+        }
+
+        frames.push_back(Frame{term, true});
+        for (size_t i = term->arity(); i > 0; i--)
+            frames.push_back(Frame{term->child(i - 1), false});
+    }
+}
+
+bool PatternMatcher::match(const Term *term, MatchState &state) const {
+    CARL_STAT_COUNT(STAT_MATCH_ATTEMPTS);
+    state.slots.resize(slotCount);
+    state.pending.clear();
+    state.pending.push_back(term);
+
+    for (const MatchInstruction &instruction : matchCode) {
+        const Term *node = state.pending.back();
+        state.pending.pop_back();
+
+        switch (instruction.op) {
+        case MATCH_NODE:
+            if (node->type() != instruction.type ||
+                node->arity() != instruction.arity)
+                return false;
+            for (size_t i = node->arity(); i > 0; i--)
+                state.pending.push_back(node->child(i - 1));
+            break;
+        case MATCH_NUMBER:
+            if (node->type() != TokenType::NUMBER ||
+                node->number() != instruction.number)
+                return false;
+            break;
+        case MATCH_TYPE:
+            if (node->type() != instruction.type || node->arity() != 0)
+                return false;
+            break;
+        case MATCH_BIND:
+            state.slots[instruction.slot] = node;
+            break;
+        case MATCH_BOUND:
+            // Hash-consed, so equal subterms are the same term
+            if (state.slots[instruction.slot] != node)
+                return false;
+            break;
+        }
+    }
+
+    assert(state.pending.empty());
+    CARL_STAT_COUNT(STAT_MATCH_HITS);
+    return true;
+}
+
+const Term *PatternMatcher::build(TermTable &table, MatchState &state) const {
+    state.pending.clear();
+
+    for (const BuildInstruction &instruction : buildCode) {
+        switch (instruction.op) {
+        case BUILD_SLOT:
+            state.pending.push_back(state.slots[instruction.slot]);
+            break;
+        case BUILD_LITERAL:
+            state.pending.push_back(
+                table.make(instruction.type, literalTexts[instruction.literal]));
+            break;
+        case BUILD_NODE: {
+            const Term *right = nullptr;
+            if (instruction.arity == 2) {
+                right = state.pending.back();
+                state.pending.pop_back();
+            }
+            const Term *left = state.pending.back();
+            state.pending.pop_back();
+            state.pending.push_back(
+                table.make(instruction.type, instruction.symbol, left, right));
+            break;
+        }
+        }
+    }
+
+    assert(state.pending.size() == 1);
+    return state.pending.back();
+}
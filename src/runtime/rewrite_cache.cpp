@@ -0,0 +1,30 @@
+#include "runtime/rewrite_cache.h"
+
+RewriteCache::RewriteCache(size_t capacity) : results{capacity} {}
+
+const Term *RewriteCache::find(uint64_t rule, const Term *term) {
+    if (results.capacity() == 0)
+        return nullptr;
+
+    const Term *const *result = results.find(Key{rule, term});
+    if (result == nullptr) {
+        stats_.misses++;
+        return nullptr;
+    }
+    stats_.hits++;
+    return *result;
+}
+
+void RewriteCache::insert(uint64_t rule, const Term *term,
+                          const Term *result) {
+    if (results.insert(Key{rule, term}, result))
+        stats_.evictions++;
+}
+
+void RewriteCache::clear() {
+    results.clear();
+}
+
+void RewriteCache::setCapacity(size_t capacity) {
+    results.setCapacity(capacity);
+}
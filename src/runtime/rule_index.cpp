@@ -0,0 +1,210 @@
+#include "runtime/rule_index.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+size_t RuleIndex::SymbolHash::operator()(const Symbol &symbol) const {
+    return std::hash<double>{}(symbol.number) ^
+           (static_cast<size_t>(symbol.type) << 2) ^ symbol.arity;
+}
+
+RuleIndex::Symbol RuleIndex::symbolOf(const Term *term) {
+    // Numbers match by value, so 1 and 1.0 must share an edge
+    if (term->type() == TokenType::NUMBER)
+        return Symbol{term->type(), 0, term->number()};
+    return Symbol{term->type(), term->arity(), 0};
+}
+
+RuleIndex::Node::~Node() {
+    // Descendants are detached before they are destroyed, so every
+    // destructor called from here finds a childless node
+    std::vector<std::unique_ptr<Node>> pending;
+    auto detach = [&pending](Node &node) {
+        for (auto &[symbol, child] : node.children) {
+            if (child != nullptr)
+                pending.push_back(std::move(child));
+        }
+        if (node.wildcard != nullptr)
+            pending.push_back(std::move(node.wildcard));
+    };
+
+    detach(*this);
+    while (!pending.empty()) {
+        std::unique_ptr<Node> node = std::move(pending.back());
+        pending.pop_back();
+        detach(*node);
+    }
+}
+
+RuleIndex::RuleIndex(const RuleIndex &other)
+    : nextOrder{other.nextOrder}, size_{other.size_}, nodes_{other.nodes_} {
+    std::vector<std::pair<const Node *, Node *>> pending{{&other.root, &root}};
+    while (!pending.empty()) {
+        auto [from, to] = pending.back();
+        pending.pop_back();
+
+        to->rules = from->rules;
+        for (const auto &[symbol, child] : from->children) {
+            auto &copy = to->children[symbol] = std::make_unique<Node>();
+            pending.emplace_back(child.get(), copy.get());
+        }
+        if (from->wildcard != nullptr) {
+            to->wildcard = std::make_unique<Node>();
+            pending.emplace_back(from->wildcard.get(), to->wildcard.get());
+        }
+    }
+}
+
+RuleIndex &RuleIndex::operator=(const RuleIndex &other) {
+    if (this != &other)
+        *this = RuleIndex{other};
+    return *this;
+}
+
+RuleIndex::Node *RuleIndex::path(const Term *pattern, bool create,
+                                 std::vector<Edge> *trail) {
+    Node *node = &root;
+    std::vector<const Term *> pending{pattern};
+    while (!pending.empty()) {
+        const Term *term = pending.back();
+        pending.pop_back();
+
+        if (trail != nullptr)
+            trail->push_back(Edge{node, term});
+
+        std::unique_ptr<Node> *next;
+        if (term->isVariable()) {
+            next = &node->wildcard;
+        } else {
+            Symbol symbol = symbolOf(term);
+            if (!create) {
+                auto it = node->children.find(symbol);
+                if (it == node->children.end())
+                    return nullptr;
+                next = &it->second;
+            } else {
+                next = &node->children[std::move(symbol)];
+            }
+
+            // Prefix order: left subterm before right
+            for (size_t i = term->arity(); i > 0; i--)
+                pending.push_back(term->child(i - 1));
+        }
+
+        if (*next == nullptr) {
+            if (!create)
+                return nullptr;
+            *next = std::make_unique<Node>();
+            nodes_++;
+        }
+        node = next->get();
+    }
+    return node;
+}
+
+void RuleIndex::insert(const Rule *rule) {
+    insert(rule, nextOrder++);
+}
+
+void RuleIndex::insert(const Rule *rule, size_t order) {
+    path(rule->pattern(), true)->rules.push_back(Entry{rule, order});
+    size_++;
+}
+
+size_t RuleIndex::reserveOrders(size_t count) {
+    const size_t first = nextOrder;
+    nextOrder += count;
+    return first;
+}
+
+void RuleIndex::remove(const Rule *rule) {
+    std::vector<Edge> trail;
+    Node *node = path(rule->pattern(), false, &trail);
+    if (node == nullptr)
+        return;
+
+    auto it = std::find_if(node->rules.begin(), node->rules.end(),
+                           [rule](const Entry &entry) { return entry.rule == rule; });
+    if (it == node->rules.end())
+        return;
+    node->rules.erase(it);
+    size_--;
+
+    // Unlink the nodes left empty, deepest first, so redefining a rule
+    // doesn't grow the tree
+    while (!trail.empty() && node->rules.empty() && node->children.empty() &&
+           node->wildcard == nullptr) {
+        Edge edge = trail.back();
+        trail.pop_back();
+        if (edge.term->isVariable())
+            edge.from->wildcard.reset();
+        else
+            edge.from->children.erase(symbolOf(edge.term));
+        nodes_--;
+        node = edge.from;
+    }
+}
+
+std::vector<const Rule *> RuleIndex::candidates(const Term *term) const {
+    std::vector<const Rule *> rules;
+    Scratch scratch;
+    candidates(term, rules, scratch);
+    return rules;
+}
+
+void RuleIndex::candidates(const Term *term, std::vector<const Rule *> &rules,
+                           Scratch &scratch) const {
+    std::vector<Entry> &found = scratch.found;
+    std::vector<State> &states = scratch.states;
+    std::vector<Pending> &pending = scratch.pending;
+    found.clear();
+    states.clear();
+    pending.clear();
+
+    pending.push_back(Pending{term, NONE});
+    states.push_back(State{&root, 0});
+
+    while (!states.empty()) {
+        const State state = states.back();
+        states.pop_back();
+
+        if (state.pending == NONE) {
+            found.insert(found.end(), state.node->rules.begin(),
+                         state.node->rules.end());
+            continue;
+        }
+
+        const Term *next = pending[state.pending].term;
+        const uint32_t rest = pending[state.pending].next;
+
+        // A variable matches the whole subterm
+        if (state.node->wildcard != nullptr)
+            states.push_back(State{state.node->wildcard.get(), rest});
+
+        auto child = state.node->children.find(symbolOf(next));
+        if (child == state.node->children.end())
+            continue;
+
+        // The children go in front of the rest, the first one outermost
+        uint32_t list = rest;
+        for (size_t i = next->arity(); i > 0; i--) {
+            pending.push_back(Pending{next->child(i - 1), list});
+            list = static_cast<uint32_t>(pending.size() - 1);
+        }
+        states.push_back(State{child->second.get(), list});
+    }
+
+    std::sort(found.begin(), found.end(), [](const Entry &a, const Entry &b) {
+        return a.order < b.order;
+    });
+
+    rules.clear();
+    for (const Entry &entry : found)
+        rules.push_back(entry.rule);
+}
@@ -0,0 +1,474 @@
+#include "runtime/rule_library.h"
+#include "lexer/token.h"
+#include "parser/flat_expression.h"
+#include "runtime/pattern_matcher.h"
+#include "runtime/term.h"
+
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace {
+constexpr char MAGIC[8] = {'C', 'A', 'R', 'L', 'R', 'U', 'L', 'E'};
+// Written in the byte order of the machine, so images only load on machines
+// with the same one
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t SECTION_ALIGNMENT = 8;
+
+enum Section {
+    SECTION_RULES,   // ImageRule per rule, in definition order
+    SECTION_BUCKETS, // Open addressing table of rule indices, by name
+    SECTION_NODES,   // Patterns and replacements as FlatExpression nodes
+    SECTION_MATCH,   // Match instructions of all rules
+    SECTION_BUILD,   // Build instructions of all rules
+    SECTION_STRINGS, // Where each string is in SECTION_CHARS
+    SECTION_CHARS,   // Names and literals, not terminated
+    SECTION_COUNT,
+};
+
+struct SectionRange {
+    uint64_t offset; // From the start of the image
+    uint64_t count;  // Elements, not bytes
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    SectionRange sections[SECTION_COUNT];
+};
+
+// Elements [begin, begin + count) of a section
+struct Range {
+    uint32_t begin;
+    uint32_t count;
+};
+
+struct ImageRule {
+    uint32_t name; // String index
+    uint32_t slots;
+    Range pattern;
+    Range replacement;
+    Range match;
+    Range build;
+};
+
+// A FlatExpression node. Left is relative to the first node of the
+// expression, strings are literals or operator spellings.
+struct ImageNode {
+    uint8_t arity;
+    uint8_t type;
+    uint16_t padding;
+    uint32_t string;
+    uint32_t left;
+};
+
+struct ImageMatch {
+    uint8_t op;
+    uint8_t type;
+    uint8_t arity;
+    uint8_t padding;
+    uint16_t slot;
+    uint16_t padding2;
+    double number;
+};
+
+struct ImageBuild {
+    uint8_t op;
+    uint8_t type;
+    uint8_t arity;
+    uint8_t padding;
+    uint16_t slot;
+    uint16_t padding2;
+    uint32_t string;
+};
+
+struct ImageString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Explicit padding, so images are the same for the same rules
+static_assert(sizeof(Header) == 16 + 16 * SECTION_COUNT);
+static_assert(sizeof(ImageRule) == 40);
+static_assert(sizeof(ImageNode) == 12);
+static_assert(sizeof(ImageMatch) == 16);
+static_assert(sizeof(ImageBuild) == 12);
+static_assert(std::is_trivially_copyable_v<ImageMatch>);
+
+constexpr size_t ELEMENT_SIZES[SECTION_COUNT] = {
+    sizeof(ImageRule),  sizeof(uint32_t),    sizeof(ImageNode), sizeof(ImageMatch),
+    sizeof(ImageBuild), sizeof(ImageString), sizeof(char),
+};
+
+// FNV-1a, std::hash may differ between the writer and the reader
+uint64_t hashName(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+const Header &headerOf(const std::byte *image) {
+    return *reinterpret_cast<const Header *>(image);
+}
+
+template <typename T> const T *sectionOf(const std::byte *image, Section section) {
+    return reinterpret_cast<const T *>(image + headerOf(image).sections[section].offset);
+}
+
+uint64_t countOf(const std::byte *image, Section section) {
+    return headerOf(image).sections[section].count;
+}
+
+[[noreturn]] void corrupt() {
+    throw RuleLibraryError(INVALID_LIBRARY, "Rule library is corrupt");
+}
+
+// Range within section, as a pointer to its first element
+template <typename T>
+const T *rangeOf(const std::byte *image, Section section, Range range) {
+    if (range.begin > countOf(image, section) ||
+        range.count > countOf(image, section) - range.begin)
+        corrupt();
+    return sectionOf<T>(image, section) + range.begin;
+}
+
+std::string_view stringOf(const std::byte *image, uint32_t index) {
+    if (index >= countOf(image, SECTION_STRINGS))
+        corrupt();
+    const ImageString &string = sectionOf<ImageString>(image, SECTION_STRINGS)[index];
+    const char *chars = rangeOf<char>(image, SECTION_CHARS,
+                                      Range{string.offset, string.length});
+    return std::string_view{chars, string.length};
+}
+
+TokenType typeOf(uint8_t type) {
+    if (type > static_cast<uint8_t>(TokenType::END_OF_FILE))
+        corrupt();
+    return static_cast<TokenType>(type);
+}
+
+// Nodes are checked to form exactly one tree, which FlatExpression assumes
+FlatExpression decodeExpression(const std::byte *image, Range range) {
+    const ImageNode *nodes = rangeOf<ImageNode>(image, SECTION_NODES, range);
+    FlatExpression expression;
+    expression.reserve(range.count);
+    size_t subtrees = 0;
+    for (uint32_t node = 0; node < range.count; node++) {
+        const ImageNode &encoded = nodes[node];
+        const TokenType type = typeOf(encoded.type);
+        const std::string_view text = stringOf(image, encoded.string);
+        switch (encoded.arity) {
+        case 0:
+            expression.addLiteral(type, text);
+            subtrees++;
+            break;
+        case 1:
+            if (subtrees < 1)
+                corrupt();
+            expression.addUnary(Token(type, 0, text.size(), text));
+            break;
+        case 2:
+            if (subtrees < 2 || encoded.left >= node - 1)
+                corrupt();
+            expression.addBinary(Token(type, 0, text.size(), text), encoded.left);
+            subtrees--;
+            break;
+        default:
+            corrupt();
+        }
+    }
+    if (subtrees != 1)
+        corrupt();
+    return expression;
+}
+
+// Checked so match() and build() never run off their stacks or read a
+// slot that wasn't bound
+PatternMatcher decodeMatcher(const std::byte *image, const ImageRule &rule) {
+    const ImageMatch *match = rangeOf<ImageMatch>(image, SECTION_MATCH, rule.match);
+    const ImageBuild *build = rangeOf<ImageBuild>(image, SECTION_BUILD, rule.build);
+    // Every slot is bound by one instruction
+    if (rule.slots > rule.match.count)
+        corrupt();
+    std::vector<bool> bound(rule.slots);
+
+    std::vector<MatchInstruction> matchCode;
+    matchCode.reserve(rule.match.count);
+    size_t pending = 1;
+    for (uint32_t i = 0; i < rule.match.count; i++) {
+        const ImageMatch &encoded = match[i];
+        if (pending == 0 || encoded.op > MATCH_BOUND || encoded.arity > 2)
+            corrupt();
+        pending--;
+        switch (encoded.op) {
+        case MATCH_NODE:
+            pending += encoded.arity;
+            break;
+        case MATCH_BIND:
+            if (encoded.slot >= rule.slots || bound[encoded.slot])
+                corrupt();
+            bound[encoded.slot] = true;
+            break;
+        case MATCH_BOUND:
+            if (encoded.slot >= rule.slots || !bound[encoded.slot])
+                corrupt();
+            break;
+        }
+        matchCode.push_back(MatchInstruction{static_cast<MatchOpCode>(encoded.op),
+                                             typeOf(encoded.type), encoded.arity,
+                                             encoded.slot, encoded.number});
+    }
+    if (pending != 0)
+        corrupt();
+
+    std::vector<BuildInstruction> buildCode;
+    buildCode.reserve(rule.build.count);
+    std::vector<std::string> literals;
+    size_t built = 0;
+    for (uint32_t i = 0; i < rule.build.count; i++) {
+        const ImageBuild &encoded = build[i];
+        SymbolId symbol{};
+        uint32_t literal = 0;
+        switch (encoded.op) {
+        case BUILD_SLOT:
+            if (encoded.slot >= rule.slots || !bound[encoded.slot])
+                corrupt();
+            built++;
+            break;
+        case BUILD_LITERAL:
+            literal = static_cast<uint32_t>(literals.size());
+            literals.emplace_back(stringOf(image, encoded.string));
+            built++;
+            break;
+        case BUILD_NODE:
+            if (encoded.arity < 1 || encoded.arity > 2 || built < encoded.arity)
+                corrupt();
+            symbol = internSymbol(stringOf(image, encoded.string));
+            built -= encoded.arity - 1;
+            break;
+        default:
+            corrupt();
+        }
+        buildCode.push_back(BuildInstruction{static_cast<BuildOpCode>(encoded.op),
+                                             typeOf(encoded.type), encoded.arity,
+                                             encoded.slot, symbol, literal});
+    }
+    if (built != 1)
+        corrupt();
+
+    return PatternMatcher{std::move(matchCode), std::move(buildCode), std::move(literals),
+                          rule.slots};
+}
+
+// Why the image can't be used, or nullptr if its header is sound
+const char *checkHeader(const std::byte *image, size_t size) {
+    if (size < sizeof(Header) ||
+        std::memcmp(headerOf(image).magic, MAGIC, sizeof(MAGIC)) != 0)
+        return "is not a rule library";
+    const Header &header = headerOf(image);
+    if (header.byteOrder != BYTE_ORDER_MARK)
+        return "was compiled on a machine with another byte order";
+    if (header.version != RuleLibrary::VERSION)
+        return "was compiled by another version of carl, compile it again";
+
+    for (size_t section = 0; section < SECTION_COUNT; section++) {
+        const SectionRange &range = header.sections[section];
+        if (range.offset % SECTION_ALIGNMENT != 0 || range.offset > size ||
+            range.count > (size - range.offset) / ELEMENT_SIZES[section])
+            return "is truncated or corrupt";
+    }
+    // Lookups probe with a mask
+    if (!std::has_single_bit(header.sections[SECTION_BUCKETS].count))
+        return "is corrupt";
+    return nullptr;
+}
+
+template <typename T>
+void writeSection(std::ostream &out, uint64_t &written, const SectionRange &range,
+                  const T *data) {
+    static const char padding[SECTION_ALIGNMENT] = {};
+    out.write(padding, range.offset - written);
+    out.write(reinterpret_cast<const char *>(data), range.count * sizeof(T));
+    written = range.offset + range.count * sizeof(T);
+}
+} // namespace
+
+void RuleLibrary::write(std::ostream &out,
+                        const std::vector<std::pair<SymbolId, const Rule *>> &rules) {
+    std::vector<ImageRule> imageRules;
+    std::vector<ImageNode> nodes;
+    std::vector<ImageMatch> match;
+    std::vector<ImageBuild> build;
+    std::vector<ImageString> strings;
+    std::string chars;
+
+    // Every distinct string is stored once
+    std::unordered_map<std::string, uint32_t> stringIndices;
+    auto stringIndex = [&](const std::string &text) {
+        auto [it, inserted] = stringIndices.try_emplace(text, strings.size());
+        if (inserted) {
+            strings.push_back(ImageString{static_cast<uint32_t>(chars.size()),
+                                          static_cast<uint32_t>(text.size())});
+            chars += text;
+        }
+        return it->second;
+    };
+    auto encodeExpression = [&](const Term *term) {
+        FlatExpression flat = TermTable::toFlat(term);
+        Range range{static_cast<uint32_t>(nodes.size()), static_cast<uint32_t>(flat.size())};
+        for (FlatExpression::Index node = 0; node < flat.size(); node++)
+            nodes.push_back(ImageNode{flat.arity(node), static_cast<uint8_t>(flat.type(node)),
+                                      0, stringIndex(flat.literal(node)), flat.left(node)});
+        return range;
+    };
+
+    for (const auto &[name, rule] : rules) {
+        const PatternMatcher &matcher = rule->matcher();
+        ImageRule imageRule{};
+        imageRule.name = stringIndex(symbolName(name));
+        imageRule.slots = static_cast<uint32_t>(matcher.slots());
+        imageRule.pattern = encodeExpression(rule->pattern());
+        imageRule.replacement = encodeExpression(rule->replacement());
+
+        imageRule.match = Range{static_cast<uint32_t>(match.size()),
+                                static_cast<uint32_t>(matcher.matchInstructions().size())};
+        for (const MatchInstruction &instruction : matcher.matchInstructions())
+            match.push_back(ImageMatch{instruction.op, static_cast<uint8_t>(instruction.type),
+                                       instruction.arity, 0, instruction.slot, 0,
+                                       instruction.number});
+
+        imageRule.build = Range{static_cast<uint32_t>(build.size()),
+                                static_cast<uint32_t>(matcher.buildInstructions().size())};
+        for (const BuildInstruction &instruction : matcher.buildInstructions()) {
+            uint32_t string = 0;
+            if (instruction.op == BUILD_LITERAL)
+                string = stringIndex(matcher.literals()[instruction.literal]);
+            else if (instruction.op == BUILD_NODE)
+                string = stringIndex(symbolName(instruction.symbol));
+            build.push_back(ImageBuild{instruction.op, static_cast<uint8_t>(instruction.type),
+                                       instruction.arity, 0, instruction.slot, 0, string});
+        }
+        imageRules.push_back(imageRule);
+    }
+    if (chars.size() > UINT32_MAX || nodes.size() > UINT32_MAX)
+        throw RuleLibraryError(INVALID_LIBRARY, "Too many rules for one library");
+
+    // At most half full, so probes stay short
+    std::vector<uint32_t> buckets(std::bit_ceil(rules.size() * 2 + 1), NONE);
+    const size_t mask = buckets.size() - 1;
+    for (uint32_t rule = 0; rule < rules.size(); rule++) {
+        size_t bucket = hashName(symbolName(rules[rule].first)) & mask;
+        while (buckets[bucket] != NONE)
+            bucket = (bucket + 1) & mask;
+        buckets[bucket] = rule;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    const size_t counts[SECTION_COUNT] = {imageRules.size(), buckets.size(), nodes.size(),
+                                          match.size(),      build.size(),   strings.size(),
+                                          chars.size()};
+    uint64_t offset = sizeof(Header);
+    for (size_t section = 0; section < SECTION_COUNT; section++) {
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.sections[section] = SectionRange{offset, counts[section]};
+        offset += counts[section] * ELEMENT_SIZES[section];
+    }
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    writeSection(out, written, header.sections[SECTION_RULES], imageRules.data());
+    writeSection(out, written, header.sections[SECTION_BUCKETS], buckets.data());
+    writeSection(out, written, header.sections[SECTION_NODES], nodes.data());
+    writeSection(out, written, header.sections[SECTION_MATCH], match.data());
+    writeSection(out, written, header.sections[SECTION_BUILD], build.data());
+    writeSection(out, written, header.sections[SECTION_STRINGS], strings.data());
+    writeSection(out, written, header.sections[SECTION_CHARS], chars.data());
+}
+
+std::shared_ptr<const RuleLibrary> RuleLibrary::open(const std::string &path) {
+    const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0 || !S_ISREG(status.st_mode)) {
+        if (file >= 0)
+            ::close(file);
+        throw RuleLibraryError(UNREADABLE_LIBRARY, "Could not open '" + path + "'");
+    }
+
+    const size_t size = status.st_size;
+    // Mapping an empty file fails, it isn't a library either way
+    void *mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)
+                            : MAP_FAILED;
+    ::close(file);
+    if (mapped == MAP_FAILED)
+        throw RuleLibraryError(size > 0 ? UNREADABLE_LIBRARY : INVALID_LIBRARY,
+                               "'" + path + "' is not a rule library");
+
+    // Owns the mapping from here, unmapping it if the header is rejected
+    std::shared_ptr<const RuleLibrary> library{
+        new RuleLibrary{static_cast<const std::byte *>(mapped), size}};
+    if (const char *problem = checkHeader(library->image, size))
+        throw RuleLibraryError(INVALID_LIBRARY, "'" + path + "' " + problem);
+    return library;
+}
+
+RuleLibrary::~RuleLibrary() {
+    munmap(const_cast<std::byte *>(image), imageSize);
+}
+
+size_t RuleLibrary::size() const {
+    return countOf(image, SECTION_RULES);
+}
+
+std::string_view RuleLibrary::name(uint32_t index) const {
+    assert(index < size());
+    return stringOf(image, sectionOf<ImageRule>(image, SECTION_RULES)[index].name);
+}
+
+uint32_t RuleLibrary::find(std::string_view name) const {
+    const uint32_t *buckets = sectionOf<uint32_t>(image, SECTION_BUCKETS);
+    const uint64_t bucketCount = countOf(image, SECTION_BUCKETS);
+    uint64_t bucket = hashName(name) & (bucketCount - 1);
+    for (uint64_t probes = 0; probes < bucketCount; probes++) {
+        const uint32_t index = buckets[bucket];
+        if (index == NONE)
+            return NONE;
+        if (index < size() && this->name(index) == name)
+            return index;
+        bucket = (bucket + 1) & (bucketCount - 1);
+    }
+    return NONE;
+}
+
+std::shared_ptr<const Rule> RuleLibrary::rule(uint32_t index) const {
+    assert(index < size());
+    std::lock_guard lock{mutex};
+    auto [it, inserted] = decoded.try_emplace(index);
+    if (inserted) {
+        try {
+            it->second = decode(index);
+        } catch (...) {
+            decoded.erase(it);
+            throw;
+        }
+    }
+    return it->second;
+}
+
+std::shared_ptr<const Rule> RuleLibrary::decode(uint32_t index) const {
+    const ImageRule &rule = sectionOf<ImageRule>(image, SECTION_RULES)[index];
+    FlatExpression pattern = decodeExpression(image, rule.pattern);
+    FlatExpression replacement = decodeExpression(image, rule.replacement);
+    return std::make_shared<Rule>(pattern, replacement, decodeMatcher(image, rule));
+}
@@ -0,0 +1,55 @@
+#include "runtime/string_pool.h"
+
+#include <bit>
+#include <new>
+
+StringPool &StringPool::local() {
+    static thread_local StringPool pool;
+    return pool;
+}
+
+size_t StringPool::classOf(size_t size) {
+    if (size <= MIN_CLASS_SIZE)
+        return 0;
+    return std::bit_width(size - 1) - std::bit_width(MIN_CLASS_SIZE - 1);
+}
+
+void StringPool::refill(size_t sizeClass) {
+    const size_t blockSize = MIN_CLASS_SIZE << sizeClass;
+    slabs.push_back(std::make_unique<std::byte[]>(SLAB_SIZE));
+    bytesReserved_ += SLAB_SIZE;
+
+    // Thread the new blocks onto the free list, lowest address first
+    std::byte *slab = slabs.back().get();
+    FreeBlock *head = freeLists[sizeClass];
+    for (size_t offset = SLAB_SIZE; offset >= blockSize; offset -= blockSize) {
+        FreeBlock *block = new (slab + offset - blockSize) FreeBlock{head};
+        head = block;
+    }
+    freeLists[sizeClass] = head;
+}
+
+void *StringPool::allocate(size_t size) {
+    liveBlocks_++;
+    if (size > MAX_CLASS_SIZE)
+        return ::operator new(size);
+
+    const size_t sizeClass = classOf(size);
+    if (freeLists[sizeClass] == nullptr)
+        refill(sizeClass);
+
+    FreeBlock *block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->next;
+    return block;
+}
+
+void StringPool::deallocate(void *pointer, size_t size) noexcept {
+    liveBlocks_--;
+    if (size > MAX_CLASS_SIZE) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    const size_t sizeClass = classOf(size);
+    freeLists[sizeClass] = new (pointer) FreeBlock{freeLists[sizeClass]};
+}
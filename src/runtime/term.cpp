@@ -0,0 +1,234 @@
+#include "runtime/term.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include "parser/iexpression_visitor.h"
+#include "parser/structural_hash.h"
+#include "parser/tree_printer.h"
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+// Builds terms bottom up from an expression tree
+class TermInterner : public IExpressionVisitor {
+private:
+    TermTable &table;
+    std::vector<const Term *> workingStack;
+
+public:
+    TermInterner(TermTable &table_) : table{table_} {}
+
+    const Term *intern(Expression &expression) {
+        walkPostOrder(expression, *this);
+        assert(workingStack.size() == 1);
+        return workingStack.back();
+    }
+
+    void visitLiteralExpression(LiteralExpression &expression) override {
+        workingStack.push_back(
+            table.make(expression.type(), expression.literal()));
+    }
+
+    void visitBinaryExpression(BinaryExpression &expression) override {
+        const Term *right = workingStack.back();
+        workingStack.pop_back();
+        const Term *left = workingStack.back();
+        workingStack.pop_back();
+
+        const Token &op = expression.op();
+        workingStack.push_back(table.make(op.type(), op.symbol(), left, right));
+    }
+
+    void visitUnaryExpression(UnaryExpression &expression) override {
+        const Term *operand = workingStack.back();
+        workingStack.pop_back();
+
+        const Token &op = expression.op();
+        workingStack.push_back(table.make(op.type(), op.symbol(), operand));
+    }
+};
+} // namespace
+
+const Term *TermTable::make(const Key &key) {
+    auto it = terms.find(key);
+    if (it != terms.end())
+        return *it;
+
+    // Literal terms are unique per table, and so is their text
+    const std::string *literal = key.left != nullptr
+                                     ? &symbolName(key.symbol)
+                                     : &literals.emplace_back(key.literal);
+    const Term *term = &storage.emplace_back(key.type, key.symbol, literal,
+                                             key.left, key.right, key.hash);
+    terms.insert(term);
+    return term;
+}
+
+const Term *TermTable::make(TokenType type, SymbolId symbol, const Term *left,
+                            const Term *right) {
+    // Children contribute their structural hash rather than their address, so
+    // the same structure hashes the same in every table
+    const size_t hash = right != nullptr
+                            ? structuralHash(type, symbol, left->hash(), right->hash())
+                            : structuralHash(type, symbol, left->hash());
+    return make(Key{type, symbol, {}, left, right, hash});
+}
+
+const Term *TermTable::make(TokenType type, std::string_view literal) {
+    return make(Key{type, SymbolId{}, literal, nullptr, nullptr,
+                    structuralHash(type, literal)});
+}
+
+const Term *TermTable::withChildren(const Term *term, const Term *left,
+                                    const Term *right) {
+    if (term->left() == left && term->right() == right)
+        return term;
+    return make(term->type(), term->symbol(), left, right);
+}
+
+const Term *TermTable::intern(Expression &expression) {
+    TermInterner interner{*this};
+    return interner.intern(expression);
+}
+
+const Term *TermTable::intern(const FlatExpression &expression) {
+    std::vector<const Term *> interned(expression.size());
+    for (FlatExpression::Index node = 0; node < expression.size(); node++) {
+        switch (expression.arity(node)) {
+        case 0:
+            interned[node] = make(expression.type(node), expression.literal(node));
+            break;
+        case 1:
+            interned[node] = make(expression.type(node), expression.symbol(node),
+                                  interned[expression.operand(node)]);
+            break;
+        default:
+            interned[node] = make(expression.type(node), expression.symbol(node),
+                                  interned[expression.left(node)],
+                                  interned[expression.right(node)]);
+        }
+    }
+    return interned.back();
+}
+
+namespace {
+// A term whose children are handled before it is, when expanded
+struct TermFrame {
+    const Term *term;
+    bool expanded;
+};
+} // namespace
+
+const Term *TermTable::import(const Term *term) {
+    // Memoized so shared subterms are copied once
+    std::unordered_map<const Term *, const Term *> imported;
+    std::vector<TermFrame> pending{{term, false}};
+    while (!pending.empty()) {
+        TermFrame frame = pending.back();
+        pending.pop_back();
+        const Term *node = frame.term;
+        if (imported.contains(node))
+            continue;
+
+        if (!frame.expanded && node->arity() > 0) {
+            pending.push_back({node, true});
+            for (size_t i = node->arity(); i > 0; i--)
+                pending.push_back({node->child(i - 1), false});
+            continue;
+        }
+
+        if (node->arity() == 0) {
+            imported.emplace(node, make(node->type(), node->literal()));
+            continue;
+        }
+        const Term *left = imported.at(node->left());
+        const Term *right = node->right() ? imported.at(node->right()) : nullptr;
+        imported.emplace(node, make(node->type(), node->symbol(), left, right));
+    }
+    return imported.at(term);
+}
+
+std::unique_ptr<Expression> TermTable::toExpression(const Term *term) {
+    // Built bottom up, children before their parent
+    std::vector<TermFrame> pending{{term, false}};
+    std::vector<std::unique_ptr<Expression>> built;
+    while (!pending.empty()) {
+        TermFrame frame = pending.back();
+        pending.pop_back();
+        const Term *node = frame.term;
+
+        if (!frame.expanded && node->arity() > 0) {
+            pending.push_back({node, true});
+            for (size_t i = node->arity(); i > 0; i--)
+                pending.push_back({node->child(i - 1), false});
+            continue;
+        }
+
+        const Token op(node->type(), 0, node->literal().size(), node->symbol());
+        switch (node->arity()) {
+        case 0:
+            built.push_back(std::make_unique<LiteralExpression>(node->type(),
+                                                                node->literal()));
+            break;
+        case 1:
+            built.back() =
+                std::make_unique<UnaryExpression>(op, std::move(built.back()));
+            break;
+        default: {
+            std::unique_ptr<Expression> right = std::move(built.back());
+            built.pop_back();
+            built.back() = std::make_unique<BinaryExpression>(
+                std::move(built.back()), op, std::move(right));
+        }
+        }
+    }
+    return std::move(built.back());
+}
+
+FlatExpression TermTable::toFlat(const Term *term) {
+    FlatExpression flat;
+    // Indices of the subtrees whose parent wasn't appended yet
+    std::vector<FlatExpression::Index> subtrees;
+    std::vector<TermFrame> pending{{term, false}};
+    while (!pending.empty()) {
+        TermFrame frame = pending.back();
+        pending.pop_back();
+        const Term *node = frame.term;
+
+        if (!frame.expanded && node->arity() > 0) {
+            pending.push_back({node, true});
+            for (size_t i = node->arity(); i > 0; i--)
+                pending.push_back({node->child(i - 1), false});
+            continue;
+        }
+
+        const Token op(node->type(), 0, node->literal().size(), node->symbol());
+        switch (node->arity()) {
+        case 0:
+            subtrees.push_back(flat.addLiteral(node->type(), node->literal()));
+            break;
+        case 1:
+            subtrees.back() = flat.addUnary(op);
+            break;
+        default:
+            subtrees.pop_back();
+            subtrees.back() = flat.addBinary(op, subtrees.back());
+        }
+    }
+    return flat;
+}
+
+std::string TermTable::toString(const Term *term) {
+    std::string output;
+    appendTree(*term, output);
+    return output;
+}
+
+void TermTable::clear() {
+    terms.clear();
+    storage.clear();
+    literals.clear();
+}
@@ -0,0 +1,87 @@
+#include "runtime/thread_pool.h"
+
+#include <utility>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threadCount; i++)
+        threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+void ThreadPool::run(std::vector<Task> tasks) {
+    if (tasks.empty())
+        return;
+
+    // Dealt out round robin, stealing evens out the rest
+    for (size_t i = 0; i < tasks.size(); i++) {
+        Queue &queue = *queues[i % queues.size()];
+        std::lock_guard lock{queue.mutex};
+        queue.tasks.push_back(std::move(tasks[i]));
+    }
+
+    std::unique_lock lock{mutex};
+    queued += tasks.size();
+    pending += tasks.size();
+    wake.notify_all();
+    finished.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::take(size_t worker, Task &task) {
+    for (size_t i = 0; i < queues.size(); i++) {
+        Queue &queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard lock{queue.mutex};
+        if (queue.tasks.empty())
+            continue;
+
+        // Own work newest first while it is still in cache, stolen work
+        // oldest first
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::work(size_t worker) {
+    while (true) {
+        {
+            std::unique_lock lock{mutex};
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0)
+                return;
+            queued--;
+        }
+
+        // A task is reserved for this worker, but it may sit in any queue.
+        // A batch is queued completely before any of it is reserved and
+        // every reservation takes one task, so one pass over the queues
+        // finds it. Should that ever change, yield instead of spinning.
+        Task task;
+        while (!take(worker, task))
+            std::this_thread::yield();
+        task(worker);
+
+        std::lock_guard lock{mutex};
+        if (--pending == 0)
+            finished.notify_all();
+    }
+}
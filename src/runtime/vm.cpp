@@ -0,0 +1,132 @@
+#include "runtime/vm.h"
+#include "runtime/carl_object.h"
+#include "runtime/chunk.h"
+#include "runtime/runtime_errors.h"
+
+#include <string>
+
+void VM::typeMismatch(const Chunk &chunk, const uint8_t *ip, const Value *top,
+                      const char *reason) {
+    // Release whatever is still on the stack before unwinding
+    for (Value *value = stack.data(); value != top; value++)
+        value->dispose();
+
+    // ip has already moved past the failing instruction
+    const SourceSpan *span = chunk.spanAt(ip - chunk.code().data() - 1);
+    if (span == nullptr)
+        throw TypeMismatch(0, 0, reason);
+    throw TypeMismatch(span->sourceOffset, span->length, reason);
+}
+
+void VM::internalError(const Chunk &chunk, const uint8_t *ip, const Value *top,
+                       std::string reason) {
+    for (Value *value = stack.data(); value != top; value++)
+        value->dispose();
+
+    const SourceSpan *span = chunk.spanAt(ip - chunk.code().data() - 1);
+    if (span == nullptr)
+        throw InternalError(0, 0, reason);
+    throw InternalError(span->sourceOffset, span->length, reason);
+}
+
+#define BINARY_NUMBER_OP(assignOp)                                              \
+    do {                                                                       \
+        if (top[-2].type != VALUE_NUMBER || top[-1].type != VALUE_NUMBER)      \
+            typeMismatch(chunk, ip, top,                                       \
+                         "Type Mismatch, binary operation expects two "        \
+                         "numbers or two strings");                            \
+        top[-2].number assignOp top[-1].number;                                \
+        top--;                                                                 \
+    } while (false)
+
+Value VM::run(const Chunk &chunk) {
+    if (stack.size() < chunk.maxStackDepth())
+        stack.resize(chunk.maxStackDepth());
+
+    const uint8_t *ip = chunk.code().data();
+    const Value *constants = chunk.constants().data();
+    Value *top = stack.data();
+
+    for (;;) {
+        switch (static_cast<OpCode>(*ip++)) {
+        case OP_CONSTANT: {
+            const Value &constant = constants[*ip++];
+            *top++ = constant.copy();
+            break;
+        }
+        case OP_CONSTANT_LONG: {
+            size_t index = ip[0] | (ip[1] << 8) | (ip[2] << 16);
+            ip += 3;
+            const Value &constant = constants[index];
+            *top++ = constant.copy();
+            break;
+        }
+        case OP_TRUE:
+            top->type = ValueType::VALUE_BOOL;
+            top->number = 1.0; // 1 is true
+            top++;
+            break;
+        case OP_FALSE:
+            top->type = ValueType::VALUE_BOOL;
+            top->number = 0.0; // 0 is false
+            top++;
+            break;
+
+        case OP_NEGATE: {
+            Value &operand = top[-1];
+            if (operand.type != ValueType::VALUE_NUMBER)
+                typeMismatch(chunk, ip, top,
+                             "Type Mismatch, because can't negate a type "
+                             "that's not a number");
+            operand.number = -operand.number;
+            break;
+        }
+        case OP_NOT: {
+            Value &operand = top[-1];
+            if (operand.type != ValueType::VALUE_BOOL)
+                typeMismatch(
+                    chunk, ip, top,
+                    "Type Mismatch, because can't NOT a non-boolean value");
+            operand.number = operand.number == 1.0 ? 0.0 : 1.0;
+            break;
+        }
+
+        case OP_ADD: {
+            Value &l = top[-2];
+            Value &r = top[-1];
+            if (l.type == VALUE_NUMBER && r.type == VALUE_NUMBER) {
+                l.number += r.number;
+            } else if (IS_STRING(l) && IS_STRING(r)) {
+                Value result = Value::string(l.asString(), r.asString());
+                l.dispose();
+                r.dispose();
+                l = result;
+            } else {
+                typeMismatch(chunk, ip, top,
+                             "Type Mismatch, binary operation expects two "
+                             "numbers or two strings");
+            }
+            top--;
+            break;
+        }
+        case OP_SUBTRACT:
+            BINARY_NUMBER_OP(-=);
+            break;
+        case OP_MULTIPLY:
+            BINARY_NUMBER_OP(*=);
+            break;
+        case OP_DIVIDE:
+            BINARY_NUMBER_OP(/=);
+            break;
+
+        case OP_RETURN:
+            return *--top;
+
+        default:
+            internalError(chunk, ip, top,
+                          "unknown instruction " + std::to_string(ip[-1]));
+        }
+    }
+}
+
+#undef BINARY_NUMBER_OP
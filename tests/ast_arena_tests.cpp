@@ -0,0 +1,82 @@
+#include "lexer/lexer.h"
+#include "parser/ast_arena.h"
+#include "parser/ast_printer.h"
+#include "parser/expression.h"
+#include "parser/parser.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+
+TEST_CASE("Ast Arena", "[AST Arena]") {
+    const size_t arenasBefore = AstArena::liveArenas();
+
+    SECTION("Nodes outside a scope come from the heap") {
+        REQUIRE(AstArena::current() == nullptr);
+        auto l = std::make_unique<LiteralExpression>(TokenType::NUMBER, "1");
+        CHECK(AstArena::liveArenas() == arenasBefore);
+    }
+
+    SECTION("Nodes inside a scope come from the arena") {
+        std::unique_ptr<Expression> tree;
+        {
+            AstArena::Scope scope;
+            auto l = std::make_unique<LiteralExpression>(TokenType::NUMBER, "1");
+            auto r = std::make_unique<LiteralExpression>(TokenType::NUMBER, "2");
+            tree = std::make_unique<BinaryExpression>(
+                std::move(l), Token(TokenType::PLUS, 0, 1, "+"), std::move(r));
+
+            CHECK(scope.get().liveNodes() == 3);
+            CHECK(scope.get().blockCount() == 1);
+            CHECK(AstArena::current() == &scope.get());
+        }
+        CHECK(AstArena::current() == nullptr);
+
+        // The arena outlives its scope while nodes are still alive
+        CHECK(AstArena::liveArenas() == arenasBefore + 1);
+        AstPrinter printer;
+        CHECK(printer.print(*tree) == "(1 + 2)");
+
+        tree.reset();
+        CHECK(AstArena::liveArenas() == arenasBefore);
+    }
+
+    SECTION("Scopes nest") {
+        AstArena::Scope outer;
+        {
+            AstArena::Scope inner;
+            CHECK(AstArena::current() == &inner.get());
+        }
+        CHECK(AstArena::current() == &outer.get());
+    }
+
+    SECTION("Grows past the first block") {
+        std::unique_ptr<Expression> tree;
+        {
+            AstArena::Scope scope;
+            tree = std::make_unique<LiteralExpression>(TokenType::NUMBER, "0");
+            for (int i = 0; i < 10000; i++) {
+                tree = std::make_unique<UnaryExpression>(
+                    Token(TokenType::MINUS, 0, 1, "-"), std::move(tree));
+            }
+            CHECK(scope.get().liveNodes() == 10001);
+            CHECK(scope.get().blockCount() > 1);
+        }
+        tree.reset();
+        CHECK(AstArena::liveArenas() == arenasBefore);
+    }
+
+    SECTION("Parsed statements own their arena") {
+        Lexer lexer{"1 + 2 * 3; show 4 - 5;"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        auto statements = parser.parse();
+        CHECK(AstArena::liveArenas() == arenasBefore + 1);
+
+        auto *statement = dynamic_cast<ExpressionStatement *>(statements[0].get());
+        auto copy = statement->expression().clone();
+
+        statements.clear();
+        CHECK(AstArena::liveArenas() == arenasBefore);
+
+        AstPrinter printer;
+        CHECK(printer.print(*copy) == "(1 + (2 * 3))");
+    }
+}
@@ -1,8 +1,12 @@
 #include "lexer/token.h"
 #include "parser/ast_printer.h"
 #include "parser/expression.h"
+#include "parser/tree_printer.h"
 #include <catch2/catch_test_macros.hpp>
+#include <iterator>
 #include <memory>
+#include <sstream>
+#include <string>
 
 TEST_CASE("Ast Printer Test", "[AST Printer]") {
     AstPrinter printer;
@@ -32,3 +36,38 @@ TEST_CASE("Ast Printer Test", "[AST Printer]") {
         CHECK(printer.print(*u4) == "!!!!true");
     }
 }
+
+TEST_CASE("Tree printer", "[AST Printer]") {
+    std::unique_ptr<Expression> expression = std::make_unique<BinaryExpression>(
+        std::make_unique<UnaryExpression>(
+            Token(TokenType::MINUS, 0, 1, "-"),
+            std::make_unique<LiteralExpression>(TokenType::NUMBER, "1")),
+        Token(TokenType::STAR, 0, 1, "*"),
+        std::make_unique<BinaryExpression>(
+            std::make_unique<LiteralExpression>(TokenType::STRING, "x"),
+            Token(TokenType::PLUS, 0, 1, "+"),
+            std::make_unique<LiteralExpression>(TokenType::NUMBER, "2")));
+
+    SECTION("Styles") {
+        CHECK(expression->toString() == "(-1*(x+2))");
+        CHECK(AstPrinter{}.print(*expression) == "(-1 * (x + 2))");
+        CHECK(printedLength(*expression) == 10);
+        CHECK(printedLength(*expression, PRINT_SPACED) == 14);
+    }
+
+    SECTION("Output iterators") {
+        std::ostringstream stream;
+        printTree(*expression, std::ostreambuf_iterator<char>(stream), PRINT_SPACED);
+        CHECK(stream.str() == "(-1 * (x + 2))");
+
+        // Into a preallocated buffer, the iterator returned is one past the
+        // last character written
+        char buffer[16];
+        char *end = printTree(*expression, buffer);
+        CHECK(std::string(buffer, end) == "(-1*(x+2))");
+
+        std::string appended = "= ";
+        appendTree(*expression, appended);
+        CHECK(appended == "= (-1*(x+2))");
+    }
+}
@@ -0,0 +1,116 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/batch_rewriter.h"
+#include "runtime/environment.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/interpreter.h"
+#include "runtime/runtime_errors.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "runtime/thread_pool.h"
+#include "test_helpers.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Thread pool", "[ThreadPool]") {
+    ThreadPool pool{4};
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Runs every index once") {
+        std::vector<std::atomic<int>> visits(1000);
+        std::atomic<size_t> maxWorker{0};
+        pool.parallelFor(visits.size(), 7, [&](size_t index, size_t worker) {
+            // Catch assertions are not thread safe, check after the batch
+            size_t seen = maxWorker;
+            while (worker > seen && !maxWorker.compare_exchange_weak(seen, worker)) {}
+            visits[index]++;
+        });
+        CHECK(maxWorker < 4);
+        for (const auto &count : visits)
+            CHECK(count == 1);
+    }
+
+    SECTION("Empty batch") {
+        std::atomic<bool> called{false};
+        pool.parallelFor(0, 1, [&](size_t, size_t) { called = true; });
+        CHECK_FALSE(called);
+    }
+
+    SECTION("Rethrows the first exception and stays usable") {
+        CHECK_THROWS_AS(pool.parallelFor(100, 1,
+                                         [](size_t index, size_t) {
+                                             if (index == 42)
+                                                 throw std::runtime_error("42");
+                                         }),
+                        std::runtime_error);
+
+        std::atomic<size_t> sum{0};
+        pool.parallelFor(100, 3, [&](size_t index, size_t) { sum += index; });
+        CHECK(sum == 4950);
+    }
+}
+
+TEST_CASE("Batch normalization", "[BatchRewriter]") {
+    Environment environment;
+    environment.addDefinition("zero", parseRule("\"A\" + 0", "\"A\""));
+    environment.addDefinition("one", parseRule("\"A\" * 1", "\"A\""));
+    environment.addDefinition("neg", parseRule("-(-\"A\")", "\"A\""));
+
+    std::vector<std::unique_ptr<Expression>> expressions;
+    for (int i = 0; i < 200; i++) {
+        std::string n = std::to_string(i);
+        expressions.push_back(
+            parseExpression("--((" + n + " + 0) * 1) * (" + n + " * 5)"));
+    }
+
+    SECTION("Results in input order, same as one at a time") {
+        BatchRewriter batch{environment, 4};
+        auto results = batch.normalize(expressions);
+        REQUIRE(results.size() == expressions.size());
+
+        TermTable table;
+        ExpressionRewriter rewriter;
+        for (size_t i = 0; i < expressions.size(); i++) {
+            NormalizeResult expected = rewriter.normalize(
+                table, table.intern(*expressions[i]),
+                environment.snapshot()->ruleIndex(),
+                DEFAULT_REWRITE_BUDGET);
+            CHECK(results[i].expression->toString() ==
+                  TermTable::toString(expected.term));
+            CHECK(results[i].rewrites == expected.rewrites);
+        }
+        CHECK(results[7].expression->toString() == "(7*(7*5))");
+        CHECK(results[7].rewrites == 3);
+    }
+
+    SECTION("Explicit rules") {
+        BatchRewriter batch{environment, 2};
+        auto rules = std::vector<const Rule *>{
+            environment.getDefinition("zero").get()};
+        auto results = batch.normalize(expressions, rules);
+        CHECK(results[3].expression->toString() == "(--(3*1)*(3*5))");
+        CHECK(results[3].rewrites == 1);
+    }
+
+    SECTION("Errors propagate") {
+        environment.addDefinition("commute", parseRule("\"A\" * \"B\"",
+                                                       "\"B\" * \"A\""));
+        BatchRewriter batch{environment, 4, 100};
+        CHECK_THROWS_AS(batch.normalize(expressions), RewriteLimitExceeded);
+    }
+
+    SECTION("Interpreter environment") {
+        Lexer lexer{"define zero -> \"A\" + 0 = \"A\";"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.interpret();
+
+        BatchRewriter batch{interpreter.getEnvironment(), 3};
+        auto results = batch.normalize(expressions);
+        CHECK(results[199].expression->toString() == "(--(199*1)*(199*5))");
+    }
+}
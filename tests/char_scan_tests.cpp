@@ -0,0 +1,90 @@
+#include "lexer/char_scan.h"
+#include "lexer/lexer.h"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<ScanLevel> levels() {
+    std::vector<ScanLevel> levels;
+    for (ScanLevel level : {ScanLevel::SCALAR, ScanLevel::SSE2, ScanLevel::AVX2})
+        if (level <= supportedScanLevel())
+            levels.push_back(level);
+    return levels;
+}
+
+// Restores the level picked at startup
+struct ScanLevelGuard {
+    const ScanLevel previous{scanLevel()};
+    ~ScanLevelGuard() { setScanLevel(previous); }
+};
+
+TEST_CASE("Scanning character runs", "[CharScan]") {
+    ScanLevelGuard guard;
+    for (ScanLevel level : levels()) {
+        setScanLevel(level);
+        INFO("Level " << static_cast<int>(level));
+
+        CHECK(skipWhitespace(" \t\r\n x", 0) == 5);
+        CHECK(skipWhitespace("x", 0) == 0);
+        CHECK(skipWhitespace("  ", 0) == 2);
+        CHECK(skipWhitespace("\v", 0) == 0);
+        CHECK(skipDigits("0123456789.5", 0) == 10);
+        CHECK(skipDigits("12", 5) == 5);
+        CHECK(skipIdentifier("rule_name-two+1", 0) == 13);
+        CHECK(skipIdentifier("AZaz@[`{", 0) == 4);
+        CHECK(skipIdentifier("\xc3\xa9", 0) == 0);
+        CHECK(findCharacter("abc\"def\"", 1, '"') == 3);
+        CHECK(findCharacter("# comment", 0, '\n') == 9);
+        CHECK(findCharacter("abc", 7, '\n') == 3);
+
+        // Runs crossing and ending at every position of a vector
+        for (size_t length = 0; length < 100; length++) {
+            const std::string digits = std::string(length, '7') + "x";
+            CHECK(skipDigits(digits, 0) == length);
+            CHECK(skipDigits(digits.substr(0, length), 0) == length);
+            CHECK(skipIdentifier("+" + std::string(length, 'q'), 1) == length + 1);
+            CHECK(skipWhitespace(std::string(length, ' ') + "\n;", 0) == length + 1);
+        }
+    }
+}
+
+TEST_CASE("Vectorized scans agree with the scalar one", "[CharScan]") {
+    ScanLevelGuard guard;
+    std::mt19937 random{11};
+    // Mostly characters of the classes, so runs get long
+    const std::string alphabet = "   \t\n\r0123456789azAZ_-@[`{/:;\"#\x80\xff";
+    for (int round = 0; round < 2000; round++) {
+        std::string text(random() % 80, ' ');
+        for (char &c : text)
+            c = alphabet[random() % alphabet.size()];
+        if (round % 2)
+            for (char &c : text)
+                c = random() % 4 ? "5a "[random() % 3] : c;
+        const size_t from = text.empty() ? 0 : random() % text.size();
+
+        setScanLevel(ScanLevel::SCALAR);
+        const size_t whitespace = skipWhitespace(text, from);
+        const size_t digits = skipDigits(text, from);
+        const size_t identifier = skipIdentifier(text, from);
+        for (ScanLevel level : levels()) {
+            setScanLevel(level);
+            INFO("Level " << static_cast<int>(level) << ", '" << text << "' from " << from);
+            CHECK(skipWhitespace(text, from) == whitespace);
+            CHECK(skipDigits(text, from) == digits);
+            CHECK(skipIdentifier(text, from) == identifier);
+        }
+    }
+}
+
+TEST_CASE("Lexing at every scan level", "[CharScan]") {
+    ScanLevelGuard guard;
+    const std::string source = "define long_rule-name -> \"A\" + 0 = \"A\";    # comment; \"\n"
+                               "\t\t12345678901234567890.125 * \"a string with ; and #\";\n";
+    setScanLevel(ScanLevel::SCALAR);
+    const std::string expected = Lexer::tokensToString(Lexer{source}.tokenize(), source);
+    for (ScanLevel level : levels()) {
+        setScanLevel(level);
+        CHECK(Lexer::tokensToString(Lexer{source}.tokenize(), source) == expected);
+    }
+}
@@ -0,0 +1,98 @@
+#include "lexer/lexer.h"
+#include "parser/ast_printer.h"
+#include "parser/constant_folder.h"
+#include "parser/parser.h"
+#include "parser/statement.h"
+#include "runtime/interpreter.h"
+#include "runtime/runtime_errors.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+static std::string fold(std::string source) {
+    ConstantFolder folder;
+    return folder.fold(parseExpression(source))->toString();
+}
+
+TEST_CASE("Constant folding", "[ConstantFolder]") {
+    SECTION("Numeric subtrees") {
+        CHECK(fold("2 * 3") == "6");
+        CHECK(fold("(1 + 2) * (10 / 4)") == "7.5");
+        CHECK(fold("0.1 + 0.2") == "0.30000000000000004");
+    }
+
+    SECTION("Only the constant parts") {
+        CHECK(fold("(2 * 3) + \"x\"") == "(6+x)");
+        CHECK(fold("\"x\" * (1 + 1) * 4") == "((x*2)*4)");
+    }
+
+    SECTION("Negative results are negated literals") {
+        CHECK(fold("2 - 5") == "-3");
+        CHECK(fold("-2 * 3") == "-6");
+        CHECK(fold("-(-4)") == "4");
+        CHECK(fold("-4") == "-4");
+
+        ConstantFolder folder;
+        auto folded = folder.fold(parseExpression("1 - 3"));
+        auto *negation = dynamic_cast<UnaryExpression *>(folded.get());
+        REQUIRE(negation != nullptr);
+        CHECK(negation->op().type() == TokenType::MINUS);
+        CHECK(negation->operand().toString() == "2");
+    }
+
+    SECTION("Operations that aren't safe to fold") {
+        CHECK(fold("1 / 0") == "(1/0)");
+        CHECK(fold("\"a\" + \"b\"") == "(a+b)");
+    }
+
+    SECTION("Counts folded operators") {
+        ConstantFolder folder;
+        folder.fold(parseExpression("(1 + 2) * (3 + \"x\")"));
+        CHECK(folder.foldedNodes() == 1);
+    }
+}
+
+TEST_CASE("Interpreter with constant folding", "[ConstantFolder:Interpreter]") {
+    SECTION("Same values as without") {
+        for (bool folding : {false, true}) {
+            Lexer lexer{"(2 + 3) * -(4 - 6) / 2;"};
+            Parser parser{lexer.tokenize(), lexer.text()};
+            Interpreter interpreter{parser.parse()};
+            interpreter.setConstantFolding(folding);
+            auto result = interpreter.interpret();
+            REQUIRE(result.has_value());
+            CHECK(result->number == 5);
+        }
+    }
+
+    SECTION("Definitions are folded") {
+        Lexer lexer{"define twice -> \"A\" * (1 + 1) = \"A\" + \"A\";"
+                    "define grow -> \"A\" = \"A\" * (2 + 2);"
+                    "apply twice : \"y\" * 2;"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.setConstantFolding(true);
+        interpreter.interpret();
+        CHECK(interpreter.result == "(y+y)");
+
+        auto grow = interpreter.getEnvironment().getDefinition("grow");
+        REQUIRE(grow != nullptr);
+        CHECK(TermTable::toString(grow->replacement()) == "(A*4)");
+    }
+
+    SECTION("Type mismatches keep their location") {
+        std::string source = "(2 * 3) + \"x\";";
+        Lexer lexer{source};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.setConstantFolding(true);
+        try {
+            interpreter.interpret();
+            FAIL("Expected a type mismatch");
+        } catch (const TypeMismatch &error) {
+            // The + operator, same as without folding
+            CHECK(error.what(source).starts_with("0:8 - 0:9"));
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include "lexer/lexer.h"
+#include "parser/ast_printer.h"
+#include "parser/constant_folder.h"
+#include "parser/expression.h"
+#include "parser/parser.h"
+#include "runtime/carl_object.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/interpreter.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Deep enough to overflow the call stack of any recursive traversal
+static constexpr size_t DEPTH = 1'000'000;
+
+// 1 + 0 + 0 + ..., a left-deep chain of DEPTH operators
+static std::string leftDeepSum(const std::string &addend) {
+    std::string source = "1";
+    source.reserve(DEPTH * (addend.size() + 3));
+    for (size_t i = 0; i < DEPTH; i++)
+        source += " + " + addend;
+    return source;
+}
+
+static double evaluate(const std::string &source, ExecutionMode mode) {
+    Interpreter interpreter;
+    interpreter.setExecutionMode(mode);
+    auto result = interpreter.interpret(parseStatements(source + ";"));
+    REQUIRE(result.has_value());
+    REQUIRE(result->type == ValueType::VALUE_NUMBER);
+    return result->number;
+}
+
+TEST_CASE("Deep expression trees", "[Expression:Deep]") {
+    SECTION("Left-deep sums") {
+        auto tree = parseExpression(leftDeepSum("1"));
+        auto copy = tree->clone();
+        CHECK(*copy == *tree);
+
+        std::string text = tree->toString();
+        CHECK(text.size() == 1 + DEPTH * 4);
+        CHECK(text.ends_with("+1)+1)+1)"));
+
+        AstPrinter printer;
+        CHECK(printer.print(*tree).size() == 1 + DEPTH * 6);
+
+        TermTable table;
+        const Term *term = table.intern(*tree);
+        CHECK(TermTable::toString(term) == text);
+        CHECK(*TermTable::toExpression(term) == *tree);
+
+        TermTable other;
+        CHECK(TermTable::toString(other.import(term)) == text);
+
+        ConstantFolder folder;
+        CHECK(folder.fold(std::move(copy))->toString() == std::to_string(DEPTH + 1));
+    }
+
+    SECTION("Evaluated by both interpreters") {
+        std::string source = leftDeepSum("2");
+        CHECK(evaluate(source, EXECUTE_TREE_WALK) == 2 * DEPTH + 1);
+        CHECK(evaluate(source, EXECUTE_BYTECODE) == 2 * DEPTH + 1);
+    }
+
+    SECTION("Prefix chains and brackets") {
+        std::string negations(DEPTH, '-');
+        CHECK(evaluate(negations + "3", EXECUTE_TREE_WALK) == 3);
+        CHECK(evaluate(negations + "3", EXECUTE_BYTECODE) == 3);
+
+        auto bracketed = parseExpression(std::string(DEPTH, '(') + "3" +
+                                         std::string(DEPTH, ')') + " - 1");
+        CHECK(bracketed->toString() == "(3-1)");
+    }
+
+    SECTION("Rewritten to a normal form") {
+        Rule zero{parseExpression("\"A\" + 0"), parseExpression("\"A\"")};
+        auto tree = parseExpression(leftDeepSum("0"));
+
+        TermTable table;
+        ExpressionRewriter rewriter;
+        NormalizeResult result = rewriter.normalize(
+            table, table.intern(*tree), std::vector<const Rule *>{&zero}, 2 * DEPTH);
+        CHECK(TermTable::toString(result.term) == "1");
+        CHECK(result.rewrites == DEPTH);
+    }
+}
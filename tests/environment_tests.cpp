@@ -0,0 +1,107 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/environment.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST_CASE("Environment snapshots", "[Environment:Snapshot]") {
+    Environment environment;
+    environment.addDefinition("zero", parseRule("\"A\" + 0", "\"A\""));
+
+    SECTION("Undefined names") {
+        CHECK(environment.getDefinition("missing") == nullptr);
+        CHECK(environment.snapshot()->find(internSymbol("missing")) == nullptr);
+    }
+
+    SECTION("Snapshots don't see later definitions") {
+        auto before = environment.snapshot();
+        environment.addDefinition("one", parseRule("\"A\" * 1", "\"A\""));
+
+        CHECK(before->size() == 1);
+        CHECK(before->find(internSymbol("one")) == nullptr);
+        CHECK(environment.snapshot()->size() == 2);
+        CHECK(environment.getDefinition("one") != nullptr);
+    }
+
+    SECTION("Snapshots keep redefined rules alive") {
+        auto before = environment.snapshot();
+        const Rule *old = before->find(internSymbol("zero"));
+        environment.addDefinition("zero", parseRule("\"A\" * 0", "0"));
+
+        TermTable table;
+        auto sum = parseExpression("1 + 0");
+        auto candidates = before->candidates(table.intern(*sum));
+        REQUIRE(candidates.size() == 1);
+        CHECK(candidates[0] == old);
+        CHECK(TermTable::toString(old->pattern()) == "(A+0)");
+
+        CHECK(environment.snapshot()->candidates(table.intern(*sum)).empty());
+    }
+
+    SECTION("Unchanged environments hand out the same snapshot") {
+        CHECK(environment.snapshot() == environment.snapshot());
+    }
+
+    SECTION("Definitions added together are published together") {
+        std::vector<std::pair<SymbolId, std::unique_ptr<Rule>>> rules;
+        rules.emplace_back(internSymbol("one"), parseRule("\"A\" * 1", "\"A\""));
+        rules.emplace_back(internSymbol("neg"), parseRule("-(-\"A\")", "\"A\""));
+        environment.addDefinitions(std::move(rules));
+
+        auto snapshot = environment.snapshot();
+        CHECK(snapshot->size() == 3);
+        CHECK(snapshot->find(internSymbol("neg")) != nullptr);
+    }
+}
+
+TEST_CASE("Environment with concurrent readers", "[Environment:Concurrent]") {
+    Environment environment;
+    environment.addDefinition("zero", parseRule("\"A\" + 0", "\"A\""));
+    std::atomic<bool> done{false};
+
+    // Readers normalize against whatever version is current while the rules
+    // are redefined underneath them
+    std::vector<std::thread> readers;
+    std::atomic<size_t> normalized{0};
+    std::atomic<size_t> unexpected{0};
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            TermTable table;
+            ExpressionRewriter rewriter;
+            auto source = parseExpression("(1 + 0) * 1");
+            do {
+                auto rules = environment.snapshot();
+                NormalizeResult result = rewriter.normalize(
+                    table, table.intern(*source), rules->ruleIndex(), 100);
+                std::string text = TermTable::toString(result.term);
+                // Either version of "one" is defined, or none yet.
+                // Catch assertions are not thread safe, so count here and
+                // check after joining.
+                if (text != "(1*1)" && text != "1" && text != "(1*2)")
+                    unexpected++;
+                normalized++;
+            } while (!done);
+        });
+    }
+
+    for (int i = 0; i < 200; i++) {
+        environment.addDefinition("one", parseRule("\"A\" * 1", "\"A\""));
+        environment.addDefinition("one", parseRule("\"A\" * 1", "\"A\" * 2"));
+    }
+    done = true;
+    for (std::thread &reader : readers)
+        reader.join();
+
+    CHECK(unexpected == 0);
+    CHECK(normalized >= 4);
+    CHECK(environment.snapshot()->size() == 2);
+}
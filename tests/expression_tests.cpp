@@ -0,0 +1,77 @@
+#include "lexer/lexer.h"
+#include "parser/expression.h"
+#include "parser/parser.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+TEST_CASE("Expression structural hash", "[Expression:Hash]") {
+    SECTION("Equal structure, equal hash") {
+        auto a = parseExpression("(1 + \"x\") * -2");
+        auto b = parseExpression("(1+\"x\")*-2");
+        CHECK(a->hash() == b->hash());
+        CHECK(*a == *b);
+        CHECK(*a->clone() == *a);
+    }
+
+    SECTION("Different structure") {
+        auto a = parseExpression("1 + 2");
+        for (std::string other : {"2 + 1", "1 - 2", "1 + \"2\"", "-(1 + 2)", "1 + 2 + 0"}) {
+            auto b = parseExpression(other);
+            CHECK_FALSE(*a == *b);
+            CHECK(*a != *b);
+        }
+    }
+
+    SECTION("Same as the interned term") {
+        TermTable table;
+        auto expression = parseExpression("(1 + \"x\") * -2");
+        CHECK(table.intern(*expression)->hash() == expression->hash());
+    }
+
+    SECTION("Setters update the node and its ancestors") {
+        auto expression = parseExpression("(1 + 2) * -(3 + 4)");
+        auto &product = static_cast<BinaryExpression &>(*expression);
+        auto &negation = static_cast<UnaryExpression &>(product.right());
+        auto &sum = static_cast<BinaryExpression &>(negation.operand());
+
+        sum.setRight(std::make_unique<LiteralExpression>(TokenType::NUMBER, "5"));
+        CHECK(*expression == *parseExpression("(1 + 2) * -(3 + 5)"));
+
+        negation.setOperand(std::make_unique<LiteralExpression>(TokenType::NUMBER, "7"));
+        product.setLeft(std::make_unique<LiteralExpression>(TokenType::STRING, "y"));
+        auto expected = parseExpression("\"y\" * -7");
+        CHECK(expression->hash() == expected->hash());
+        CHECK(*expression == *expected);
+    }
+
+    SECTION("Deduplication") {
+        std::vector<std::unique_ptr<Expression>> expressions;
+        for (std::string source : {"1 + 2", "1+2", "2 + 1", "(1 + 2)", "-1"})
+            expressions.push_back(parseExpression(source));
+
+        std::unordered_set<const Expression *, ExpressionHash, ExpressionEqual> unique;
+        for (const auto &expression : expressions)
+            unique.insert(expression.get());
+        CHECK(unique.size() == 3);
+    }
+
+    SECTION("Deep trees") {
+        auto build = [](int leaf) {
+            std::unique_ptr<Expression> tree =
+                std::make_unique<LiteralExpression>(TokenType::NUMBER, "0");
+            for (int i = 1; i < 10000; i++)
+                tree = std::make_unique<BinaryExpression>(
+                    std::move(tree), Token(TokenType::PLUS, 0, 1, "+"),
+                    std::make_unique<LiteralExpression>(
+                        TokenType::NUMBER, std::to_string(i == 5000 ? leaf : i)));
+            return tree;
+        };
+        CHECK(*build(5000) == *build(5000));
+        CHECK_FALSE(*build(5000) == *build(-1));
+    }
+}
@@ -0,0 +1,91 @@
+#include "lexer/lexer.h"
+#include "parser/flat_expression.h"
+#include "parser/parser.h"
+#include "runtime/chunk.h"
+#include "runtime/compiler.h"
+#include "runtime/interpreter.h"
+#include "runtime/runtime_errors.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+static Value run(std::string source, ExecutionMode mode) {
+    Lexer lexer{source + ";"};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+    interpreter.setExecutionMode(mode);
+    return interpreter.interpret().value();
+}
+
+TEST_CASE("Flat expression layout", "[FlatExpression]") {
+    auto expression = parseExpression("(1 + 2) * -3");
+    FlatExpression flat{*expression};
+
+    SECTION("Nodes in post-order, root last") {
+        REQUIRE(flat.size() == 6);
+        CHECK(flat.literal(0) == "1");
+        CHECK(flat.literal(1) == "2");
+        CHECK(flat.type(2) == TokenType::PLUS);
+        CHECK(flat.left(2) == 0);
+        CHECK(flat.right(2) == 1);
+        CHECK(flat.literal(3) == "3");
+        CHECK(flat.type(4) == TokenType::MINUS);
+        CHECK(flat.arity(4) == 1);
+        CHECK(flat.operand(4) == 3);
+        CHECK(flat.root() == 5);
+        CHECK(flat.type(5) == TokenType::STAR);
+        CHECK(flat.left(5) == 2);
+        CHECK(flat.right(5) == 4);
+    }
+
+    SECTION("Operators keep their location") {
+        CHECK(flat.token(2).sourceOffset() == 3);
+        CHECK(flat.token(5).sourceOffset() == 8);
+    }
+
+    SECTION("Round trips") {
+        CHECK(*flat.toExpression() == *expression);
+
+        TermTable table;
+        const Term *term = table.intern(flat);
+        CHECK(term == table.intern(*expression));
+        CHECK(TermTable::toString(term) == "((1+2)*-3)");
+        CHECK(table.intern(TermTable::toFlat(term)) == term);
+    }
+
+    SECTION("Compiles to the same bytecode as the tree") {
+        Compiler compiler;
+        Chunk fromFlat = compiler.compile(flat);
+        Chunk fromTree = compiler.compile(*expression);
+        CHECK(fromFlat.code() == fromTree.code());
+        CHECK(fromFlat.maxStackDepth() == fromTree.maxStackDepth());
+    }
+}
+
+TEST_CASE("Flat evaluation", "[FlatExpression]") {
+    for (std::string source : {"1 + 2 * 3 - 4 / 8", "-(2 - 5) * 4", "--7"}) {
+        Value flat = run(source, EXECUTE_FLAT);
+        Value tree = run(source, EXECUTE_TREE_WALK);
+        REQUIRE(flat.type == ValueType::VALUE_NUMBER);
+        CHECK(flat.number == tree.number);
+    }
+
+    Value text = run("\"Hello \" + \"World\"", EXECUTE_FLAT);
+    REQUIRE(IS_STRING(text));
+    CHECK(text.asString() == "Hello World");
+    text.dispose();
+
+    std::string source{"1 + (2 * \"str\");"};
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+    interpreter.setExecutionMode(EXECUTE_FLAT);
+    try {
+        interpreter.interpret();
+        FAIL("Expected a type mismatch");
+    } catch (const TypeMismatch &e) {
+        CHECK(e.what(source).starts_with("0:7 - 0:8"));
+    }
+}
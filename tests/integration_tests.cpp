@@ -1,15 +1,17 @@
 #include <catch2/catch_test_macros.hpp>
 #include <memory>
+#include <string>
 
 #include "lexer/lexer.h"
 #include "parser/ast_printer.h"
 #include "parser/parser.h"
 #include "runtime/expressionrewriter.h"
 #include "runtime/interpreter.h"
+#include "runtime/runtime_errors.h"
 
 TEST_CASE("A + 0 -> A") {
     Lexer lexer{"define zero -> \"A\" + 0 = \"A\";apply zero : 2 + 0;"};
-    Parser parser{lexer.tokenize()};
+    Parser parser{lexer.tokenize(), lexer.text()};
     auto ast = parser.parse();
     Interpreter interpreter{std::move(ast)};
 
@@ -19,7 +21,7 @@ TEST_CASE("A + 0 -> A") {
 
 TEST_CASE("A + B -> B + A") {
     Lexer lexer{"define abrule -> \"A\" + \"B\" = \"B\" + \"A\";apply abrule : 2 + 5;"};
-    Parser parser{lexer.tokenize()};
+    Parser parser{lexer.tokenize(), lexer.text()};
     auto ast = parser.parse();
     Interpreter interpreter{std::move(ast)};
 
@@ -29,10 +31,48 @@ TEST_CASE("A + B -> B + A") {
 
 TEST_CASE("square") {
     Lexer lexer{"define square -> (\"A\" + \"B\")*(\"A\" + \"B\") = \"A\"*\"A\" + 2*\"A\"*\"B\";apply square : (69+420)*(69+420);"};
-    Parser parser{lexer.tokenize()};
+    Parser parser{lexer.tokenize(), lexer.text()};
     auto ast = parser.parse();
     Interpreter interpreter{std::move(ast)};
 
     auto result = interpreter.interpret();
     CHECK(interpreter.result == "((69*69)+((2*69)*420))");
 }
+
+TEST_CASE("apply* normalizes") {
+    Lexer lexer{"define zero -> \"A\" + 0 = \"A\";define one -> \"A\" * 1 = \"A\";apply* zero, one : ((2 + 0) * 1) * (3 * 1);"};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    auto ast = parser.parse();
+    Interpreter interpreter{std::move(ast)};
+
+    interpreter.interpret();
+    CHECK(interpreter.result == "(2*3)");
+    CHECK(interpreter.rewrites == 3);
+}
+
+TEST_CASE("apply* without rule names uses every rule") {
+    Lexer lexer{"define zero -> \"A\" + 0 = \"A\";define one -> \"A\" * 1 = \"A\";define neg -> -(-\"A\") = \"A\";apply* : --((2 + 0) * 1);"};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    auto ast = parser.parse();
+    Interpreter interpreter{std::move(ast)};
+
+    interpreter.interpret();
+    CHECK(interpreter.result == "2");
+    CHECK(interpreter.rewrites == 3);
+}
+
+TEST_CASE("apply* reports a non-terminating rule at the statement") {
+    std::string source{"define swap -> \"A\" + \"B\" = \"B\" + \"A\";\napply* swap : 1 + 2;"};
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    auto ast = parser.parse();
+    Interpreter interpreter{std::move(ast)};
+    interpreter.setRewriteBudget(10);
+
+    try {
+        interpreter.interpret();
+        FAIL("Expected the rewrite limit to be exceeded");
+    } catch (const RewriteLimitExceeded &e) {
+        CHECK(e.what(source).starts_with("1:1 - 1:7"));
+    }
+}
@@ -52,11 +52,9 @@ TEST_CASE("Intepreter Literal tests", "[Intepreter:Literal]") {
             std::make_unique<ExpressionStatement>(std::move(l));
         Interpreter interpreter(std::move(s));
         auto res = interpreter.interpret();
-        CHECK(res.value().type == ValueType::VALUE_OBJ);
-
-        CHECK(res.value().obj->objType == ObjectType::OBJ_STRING);
-        const char *is = reinterpret_cast<ObjString *>(res.value().obj)->chars;
-        CHECK(strcmp(is, "HEHEHEAW") == 0);
+        // Short enough to be stored inline
+        CHECK(res.value().type == ValueType::VALUE_SHORT_STRING);
+        CHECK(res.value().asString() == "HEHEHEAW");
         res.value().dispose();
     }
 }
@@ -227,6 +225,7 @@ TEST_CASE("Interpreter Binary Operations", "[Interpreter:Binary]") {
         REQUIRE(res.value().type == ValueType::VALUE_OBJ);
 
         ObjString *resultStr = reinterpret_cast<ObjString *>(res.value().obj);
-        REQUIRE(strcmp("Hello World!", resultStr->chars) == 0);
+        REQUIRE(strcmp("Hello World!", resultStr->chars()) == 0);
+        res.value().dispose();
     }
 }
@@ -76,3 +76,41 @@ TEST_CASE("Testing Lexer Error Handling", "[Lexer errors]") {
         CHECK_THROWS_AS(lexer.tokenize(), UnrecognizedCharacter);
     }
 }
+
+TEST_CASE("Tokens reference the source", "[Lexer:Source]") {
+    SECTION("Borrowed source") {
+        std::string src{"define one -> \"A\" * 1 = \"A\";"};
+        std::string_view view{src};
+        Lexer lexer{view};
+        auto t = lexer.tokenize();
+
+        REQUIRE(t.size() == 10);
+        CHECK(t[1].lexeme(view) == "one");
+        CHECK(t[1].literal() == "one");
+        // Strings keep their quotes in the source but not in their text
+        CHECK(t[3].lexeme(view) == "\"A\"");
+        CHECK(t[3].text(view) == "A");
+        CHECK(t[5].lexeme(view) == "1");
+        CHECK(t[2].lexeme(view) == "->");
+        CHECK(t[2].literal() == "->");
+        CHECK(t[9].text(view).empty());
+    }
+
+    SECTION("Owned temporary") {
+        std::string prefix{"1 +"};
+        Lexer lexer{prefix + " 22"};
+        auto t = lexer.tokenize();
+        REQUIRE(t.size() == 4);
+        CHECK(t[2].text(lexer.text()) == "22");
+        CHECK(t[2].sourceOffset() == 4);
+        CHECK(t[2].length() == 2);
+    }
+
+    SECTION("Fixed spellings share symbols") {
+        Lexer lexer{"( ( true true"};
+        auto t = lexer.tokenize();
+        CHECK(t[0].symbol() == t[1].symbol());
+        CHECK(t[2].symbol() == t[3].symbol());
+        CHECK(t[2].literal() == "true");
+    }
+}
@@ -0,0 +1,82 @@
+#include "lexer/lexer.h"
+#include "lexer/lexer_errors.h"
+#include "lexer/line_index.h"
+#include "parser/parser.h"
+#include "parser/parser_errors.h"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <utility>
+
+TEST_CASE("Line index", "[LineIndex]") {
+    SECTION("Single line") {
+        LineIndex lines{"1 + 2;"};
+        CHECK(lines.lineCount() == 1);
+        CHECK(lines.locate(0) == std::pair<uint32_t, uint32_t>{0, 0});
+        CHECK(lines.locate(4) == std::pair<uint32_t, uint32_t>{0, 4});
+        CHECK(lines.locate(6) == std::pair<uint32_t, uint32_t>{0, 6});
+        CHECK(lines.describe(2, 1) == "0:2 - 0:3");
+    }
+
+    SECTION("Columns count from the preceding line break") {
+        LineIndex lines{"1;\n2 + 3;\n\n4;"};
+        CHECK(lines.lineCount() == 4);
+        CHECK(lines.locate(2) == std::pair<uint32_t, uint32_t>{0, 2});
+        // The line break itself still belongs to the line it ends
+        CHECK(lines.locate(3) == std::pair<uint32_t, uint32_t>{1, 1});
+        CHECK(lines.locate(5) == std::pair<uint32_t, uint32_t>{1, 3});
+        CHECK(lines.locate(11) == std::pair<uint32_t, uint32_t>{3, 1});
+        CHECK(lines.describe(5, 1) == "1:3 - 1:4");
+    }
+
+    SECTION("Empty source") {
+        LineIndex lines{std::string_view{}};
+        CHECK(lines.lineCount() == 1);
+        CHECK(lines.locate(0) == std::pair<uint32_t, uint32_t>{0, 0});
+    }
+}
+
+TEST_CASE("Locations past 64 KiB", "[LineIndex:Large]") {
+    // 100000 one character lines
+    std::string source;
+    for (int i = 0; i < 100000; i++)
+        source += "1\n";
+
+    SECTION("Token offsets do not wrap") {
+        Lexer lexer{source + "\"" + std::string(300, 'x') + "\";"};
+        auto tokens = lexer.tokenize();
+        REQUIRE(tokens.size() == 100003);
+        CHECK(tokens[99999].sourceOffset() == 199998);
+        CHECK(tokens[100000].sourceOffset() == 200000);
+        CHECK(tokens[100000].length() == 302);
+        CHECK(tokens[100000].text(lexer.text()).size() == 300);
+    }
+
+    SECTION("Errors report the right line") {
+        std::string input = source + "?";
+        Lexer lexer{input};
+        try {
+            lexer.tokenize();
+            FAIL("Expected a lexer error");
+        } catch (const LexerException &e) {
+            LineIndex lines{input};
+            CHECK(e.what(lines) == "100000:1 - 100000:2 Unrecognized Character");
+            CHECK(e.what(input) == e.what(lines));
+        }
+    }
+
+    SECTION("Parser errors") {
+        std::string input;
+        for (int i = 0; i < 100000; i++)
+            input += "1;\n";
+        input += "(1 + 2";
+        Lexer lexer{input};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        try {
+            parser.parse();
+            FAIL("Expected a parser error");
+        } catch (const ParserException &e) {
+            CHECK(e.what(LineIndex{input}) ==
+                  "Missing Closing Bracket at: 100000:6 - 100000:7");
+        }
+    }
+}
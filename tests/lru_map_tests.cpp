@@ -0,0 +1,64 @@
+#include "runtime/lru_map.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("LRU map", "[LruMap]") {
+    LruMap<int, std::string> map{3};
+    CHECK_FALSE(map.insert(1, "one"));
+    CHECK_FALSE(map.insert(2, "two"));
+    CHECK_FALSE(map.insert(3, "three"));
+    REQUIRE(map.find(1) != nullptr); // 2 is now the oldest
+    CHECK(map.insert(4, "four"));
+
+    CHECK(map.size() == 3);
+    CHECK(map.find(2) == nullptr);
+    CHECK(*map.find(1) == "one");
+    CHECK(*map.find(4) == "four");
+
+    SECTION("Updating an entry makes it the newest without evicting") {
+        CHECK_FALSE(map.insert(3, "drei"));
+        CHECK(map.insert(5, "five")); // Evicts 1, not 3
+        CHECK(map.find(1) == nullptr);
+        CHECK(*map.find(3) == "drei");
+    }
+
+    SECTION("Capacity 0 holds nothing") {
+        map.setCapacity(0);
+        CHECK_FALSE(map.insert(1, "one"));
+        CHECK(map.find(1) == nullptr);
+        CHECK(map.size() == 0);
+    }
+}
+
+TEST_CASE("LRU map agrees with a reference", "[LruMap]") {
+    // The reference keeps keys newest first in a plain vector
+    std::mt19937 random{5};
+    LruMap<int, int> map{8};
+    std::vector<std::pair<int, int>> reference;
+    for (int step = 0; step < 5000; step++) {
+        const int key = random() % 16;
+        auto it = std::find_if(reference.begin(), reference.end(),
+                               [key](const auto &entry) { return entry.first == key; });
+        if (random() % 2) {
+            int *value = map.find(key);
+            REQUIRE((value != nullptr) == (it != reference.end()));
+            if (value != nullptr) {
+                CHECK(*value == it->second);
+                std::rotate(reference.begin(), it, it + 1);
+            }
+        } else {
+            const bool evicted = it == reference.end() && reference.size() == 8;
+            if (it != reference.end())
+                reference.erase(it);
+            else if (evicted)
+                reference.pop_back();
+            reference.insert(reference.begin(), {key, step});
+            CHECK(map.insert(key, step) == evicted);
+        }
+        CHECK(map.size() == reference.size());
+    }
+}
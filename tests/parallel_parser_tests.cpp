@@ -0,0 +1,140 @@
+#include "lexer/lexer.h"
+#include "lexer/lexer_errors.h"
+#include "parser/istatement_visitor.h"
+#include "parser/parallel_parser.h"
+#include "parser/parser.h"
+#include "parser/parser_errors.h"
+#include "parser/statement.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+// One line per statement, enough to tell any two parses apart
+class Describer : public IStatementVisitor {
+public:
+    std::string text;
+
+    void visitExpressionStatement(ExpressionStatement &statement) override {
+        text += statement.expression().toString() + "\n";
+    }
+    void visitDefineStatement(DefineStatement &statement) override {
+        text += "define " + statement.ruleName() + " " + statement.pattern().toString() +
+                " " + statement.replacement().toString() + "\n";
+    }
+    void visitApplyStatement(ApplyStatement &statement) override {
+        text += "apply " + statement.ruleName() + " " + statement.expression().toString() +
+                "\n";
+    }
+    void visitNormalizeStatement(NormalizeStatement &statement) override {
+        text += "apply*";
+        for (SymbolId name : statement.ruleNames())
+            text += " " + symbolName(name);
+        text += " " + statement.expression().toString() + "\n";
+    }
+    void visitShowStatement(ShowStatement &statement) override {
+        text += "show " + statement.expression().toString() + "\n";
+    }
+};
+} // namespace
+
+// The statements source parses to, or the error it throws
+template <typename Parse> static std::string outcome(const std::string &source, Parse parse) {
+    try {
+        Describer describer;
+        for (auto &statement : parse(source))
+            statement->accept(describer);
+        return describer.text;
+    } catch (const LexerException &e) {
+        return "Lexer " + std::to_string(e.error_code()) + " " + e.what(source);
+    } catch (const ParserException &e) {
+        return "Parser " + std::to_string(e.error_code()) + " " + e.what(source);
+    }
+}
+
+static std::string sequential(const std::string &source) {
+    return outcome(source, [](const std::string &source) {
+        Lexer lexer{source};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        return parser.parse();
+    });
+}
+
+static std::string parallel(ParallelParser &parser, const std::string &source) {
+    return outcome(source, [&](const std::string &source) { return parser.parse(source); });
+}
+
+static const std::string program = "define zero -> \"A\" + 0 = \"A\";\n"
+                                   "# a comment; with a \" quote\n"
+                                   "apply zero : (1 + 2) + 0;\n"
+                                   "\"semi;colon\" * 2; show 1 - 2;\n"
+                                   "apply* zero, one : 3 + 0;\n"
+                                   "(1 + 2) * -3 / 2 == 9;\n";
+
+TEST_CASE("Splitting sources into chunks", "[ParallelParser]") {
+    SECTION("Chunks end after statements") {
+        CHECK(ParallelParser::split("1; 2; 3;", 1) == std::vector<uint32_t>{0, 2, 5});
+        CHECK(ParallelParser::split("1; 2; 3;", 4) == std::vector<uint32_t>{0, 5});
+        CHECK(ParallelParser::split("1; 2; 3;", 100) == std::vector<uint32_t>{0});
+        CHECK(ParallelParser::split("", 1) == std::vector<uint32_t>{0});
+    }
+
+    SECTION("Strings and comments don't end statements") {
+        CHECK(ParallelParser::split("\"a;b\"; # c;d\n2; 3", 1) ==
+              std::vector<uint32_t>{0, 6, 15});
+        CHECK(ParallelParser::split("1; \"a;b", 1) == std::vector<uint32_t>{0, 2});
+        CHECK(ParallelParser::split("1; # a;b", 1) == std::vector<uint32_t>{0, 2});
+    }
+}
+
+TEST_CASE("Parallel parsing", "[ParallelParser]") {
+    std::string large;
+    for (int i = 0; i < 200; i++)
+        large += program;
+
+    for (size_t chunkSize : {size_t{1}, size_t{7}, size_t{64}, size_t{4096},
+                             ParallelParser::DEFAULT_CHUNK_SIZE}) {
+        ParallelParser parser{4, chunkSize};
+
+        SECTION("Same statements as parsing sequentially, chunk size " +
+                std::to_string(chunkSize)) {
+            const std::string expected = sequential(large);
+            REQUIRE(expected.rfind("Parser", 0) == std::string::npos);
+            CHECK(parallel(parser, large) == expected);
+            CHECK(parser.parse(large).size() == 200 * 6);
+        }
+
+        SECTION("Errors are located in the whole source, chunk size " +
+                std::to_string(chunkSize)) {
+            for (std::string source : {large + "1 +;", large + "1 + (2;" + large,
+                                       large + "\"unterminated;", large + "5.;" + large,
+                                       "apply ;" + large + "1 @ 2;"}) {
+                const std::string expected = sequential(source);
+                REQUIRE((expected.rfind("Lexer", 0) == 0 || expected.rfind("Parser", 0) == 0));
+                CHECK(parallel(parser, source) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Parallel parsing damaged sources", "[ParallelParser]") {
+    // Deleting or inserting characters breaks strings, comments and
+    // statements in every way, the outcome must not depend on chunking
+    std::mt19937 random{7};
+    const std::string inserts = ";\"#\n(+";
+    ParallelParser parser{3, 1};
+    for (int round = 0; round < 500; round++) {
+        std::string source = program + program;
+        for (int edit = 0; edit < 3; edit++) {
+            const size_t at = random() % source.size();
+            if (random() % 2)
+                source.erase(at, 1);
+            else
+                source.insert(at, 1, inserts[random() % inserts.size()]);
+        }
+        INFO(source);
+        CHECK(parallel(parser, source) == sequential(source));
+    }
+}
@@ -0,0 +1,100 @@
+#include "parser/parser_errors.h"
+#include "parser/statement.h"
+#include "runtime/interpreter.h"
+#include "runtime/parse_cache.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+static double run(Interpreter &interpreter, std::shared_ptr<const ParsedProgram> program) {
+    std::optional<Value> result = interpreter.interpret(std::move(program));
+    REQUIRE(result.has_value());
+    REQUIRE(result->type == ValueType::VALUE_NUMBER);
+    return result->number;
+}
+
+TEST_CASE("Parse cache", "[ParseCache]") {
+    ParseCache cache{2};
+
+    SECTION("Repeated sources are parsed once") {
+        auto first = cache.parse("1 + 2;");
+        CHECK(cache.parse("1 + 2;") == first);
+        CHECK(cache.parse("1 + 3;") != first);
+        CHECK(cache.stats().hits == 1);
+        CHECK(cache.stats().misses == 2);
+        CHECK(cache.stats().hitRate() == 1.0 / 3);
+    }
+
+    SECTION("Least recently used programs are evicted") {
+        auto one = cache.parse("1;");
+        cache.parse("2;");
+        cache.parse("1;");
+        cache.parse("3;");
+        CHECK(cache.size() == 2);
+        CHECK(cache.stats().evictions == 1);
+        CHECK(cache.parse("1;") == one);
+        CHECK(cache.stats().hits == 2);
+        cache.parse("2;");
+        CHECK(cache.stats().misses == 4);
+    }
+
+    SECTION("Errors aren't cached") {
+        CHECK_THROWS_AS(cache.parse("(1 + 2;"), ParserException);
+        CHECK_THROWS_AS(cache.parse("(1 + 2;"), ParserException);
+        CHECK(cache.size() == 0);
+        CHECK(cache.stats().misses == 2);
+    }
+
+    SECTION("Disabled caches parse every time") {
+        cache.setCapacity(0);
+        CHECK(cache.parse("1;") != cache.parse("1;"));
+        CHECK(cache.size() == 0);
+    }
+
+    SECTION("Programs come with their bytecode") {
+        auto program = cache.parse("1 + 2 * 3; \"a\" == 1;");
+        auto &statements = program->statements();
+        auto &sum = static_cast<ExpressionStatement &>(*statements[0]).expression();
+        auto &comparison = static_cast<ExpressionStatement &>(*statements[1]).expression();
+        CHECK(program->chunk(sum) != nullptr);
+        // Left for the interpreter, which reports the error when it runs
+        CHECK(program->chunk(comparison) == nullptr);
+    }
+
+    SECTION("Folding happens once, when parsing") {
+        cache.setConstantFolding(true);
+        auto program = cache.parse("2 * 3 + \"x\";");
+        auto &expression = static_cast<ExpressionStatement &>(*program->statements()[0]).expression();
+        CHECK(expression.toString() == "(6+x)");
+    }
+}
+
+TEST_CASE("Interpreting cached programs", "[ParseCache]") {
+    ParseCache cache;
+    auto program = cache.parse("define one -> \"A\" * 1 = \"A\"; (1 + 2) * 4;");
+    const std::string before = static_cast<ExpressionStatement &>(*program->statements()[1])
+                                   .expression()
+                                   .toString();
+
+    for (ExecutionMode mode : {EXECUTE_BYTECODE, EXECUTE_TREE_WALK, EXECUTE_FLAT}) {
+        Interpreter first;
+        Interpreter second;
+        first.setExecutionMode(mode);
+        second.setExecutionMode(mode);
+        CHECK(run(first, program) == 12);
+        CHECK(run(second, program) == 12);
+        CHECK(run(first, cache.parse("define one -> \"A\" * 1 = \"A\"; (1 + 2) * 4;")) == 12);
+        CHECK(first.getEnvironment().getDefinition("one") != nullptr);
+    }
+
+    CHECK(static_cast<ExpressionStatement &>(*program->statements()[1]).expression().toString() ==
+          before);
+
+    Interpreter interpreter;
+    interpreter.setConstantFolding(true);
+    CHECK(run(interpreter, cache.parse("1 + 2 * 3;")) == 7);
+    CHECK(cache.parse("1 + 2 * 3;")->statements()[0] != nullptr);
+    CHECK(static_cast<ExpressionStatement &>(*cache.parse("1 + 2 * 3;")->statements()[0])
+              .expression()
+              .toString() == "(1+(2*3))");
+}
@@ -1,3 +1,4 @@
+#include "lexer/lexer.h"
 #include "lexer/token.h"
 #include "parser/ast_printer.h"
 #include "parser/expression.h"
@@ -195,6 +196,62 @@ TEST_CASE("Parser Binary", "[Parser:Binary]") {
     }
 }
 
+TEST_CASE("Parser Precedence", "[Parser:Precedence]") {
+    auto print = [](std::string source) {
+        Lexer lexer{source};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        auto statement = std::move(parser.parse()[0]);
+        AstPrinter printer;
+        return printer.print(dynamic_cast<ExpressionStatement *>(statement.get())->expression());
+    };
+
+    CHECK(print("1 + 2 * 3 - 4;") == "((1 + (2 * 3)) - 4)");
+    CHECK(print("1 - 2 - 3 < 4 == 5 / 6 / 7;") ==
+          "((((1 - 2) - 3) < 4) == ((5 / 6) / 7))");
+    CHECK(print("-1 * --2;") == "(-1 * --2)");
+    CHECK(print("-(1 + 2) * (3);") == "(-(1 + 2) * 3)");
+    // Each ')' closes exactly one bracket
+    CHECK(print("((1)) - 1;") == "(1 - 1)");
+    CHECK(print("(1 - (2 * 3)) * 2;") == "((1 - (2 * 3)) * 2)");
+}
+
+TEST_CASE("Parser Commands", "[Parser:Commands]") {
+    SECTION("apply*") {
+        std::vector<Token> lexemes = {
+            Token(TokenType::APPLY, 0, 5, "apply"),
+            Token(TokenType::STAR, 0, 1, "*"),
+            Token(TokenType::IDENTIFIER, 0, 4, "zero"),
+            Token(TokenType::COMMA, 0, 1, ","),
+            Token(TokenType::IDENTIFIER, 0, 3, "one"),
+            Token(TokenType::COLON, 0, 1, ":"),
+            Token(TokenType::NUMBER, 0, 1, "1"),
+            Token(TokenType::SEMICOLON, 0, 1, ";"),
+            Token(TokenType::END_OF_FILE, 0, 1, "\0"),
+        };
+        Parser parser{lexemes};
+        auto statement = std::move(parser.parse()[0]);
+        auto *normalize = dynamic_cast<NormalizeStatement *>(statement.get());
+        REQUIRE(normalize != nullptr);
+        CHECK(normalize->ruleNames() == std::vector<SymbolId>{internSymbol("zero"), internSymbol("one")});
+    }
+
+    SECTION("apply* without rule names") {
+        std::vector<Token> lexemes = {
+            Token(TokenType::APPLY, 0, 5, "apply"),
+            Token(TokenType::STAR, 0, 1, "*"),
+            Token(TokenType::COLON, 0, 1, ":"),
+            Token(TokenType::NUMBER, 0, 1, "1"),
+            Token(TokenType::SEMICOLON, 0, 1, ";"),
+            Token(TokenType::END_OF_FILE, 0, 1, "\0"),
+        };
+        Parser parser{lexemes};
+        auto statement = std::move(parser.parse()[0]);
+        auto *normalize = dynamic_cast<NormalizeStatement *>(statement.get());
+        REQUIRE(normalize != nullptr);
+        CHECK(normalize->ruleNames().empty());
+    }
+}
+
 TEST_CASE("Parser Exceptions", "[Parser:Exceptions]") {
     SECTION("Unexpected Token") {
         std::vector<Token> lexemes = {
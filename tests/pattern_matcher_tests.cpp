@@ -0,0 +1,100 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/pattern_matcher.h"
+#include "runtime/rule.h"
+#include "runtime/rule_index.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+TEST_CASE("Pattern compilation", "[PatternMatcher:Compile]") {
+    SECTION("Pattern in prefix order with variable slots") {
+        auto rule = parseRule("\"A\" + \"B\" * \"A\"", "\"B\"");
+        const auto &code = rule->matcher().matchInstructions();
+
+        REQUIRE(code.size() == 5);
+        CHECK(code[0].op == MATCH_NODE);
+        CHECK(code[0].type == TokenType::PLUS);
+        CHECK(code[1].op == MATCH_BIND);
+        CHECK(code[1].slot == 0);
+        CHECK(code[2].op == MATCH_NODE);
+        CHECK(code[2].type == TokenType::STAR);
+        CHECK(code[3].op == MATCH_BIND);
+        CHECK(code[3].slot == 1);
+        CHECK(code[4].op == MATCH_BOUND);
+        CHECK(code[4].slot == 0);
+    }
+
+    SECTION("Replacement in postfix order") {
+        auto rule = parseRule("\"A\" + \"B\"", "-(\"B\" + \"A\") * 2");
+        const auto &code = rule->matcher().buildInstructions();
+
+        REQUIRE(code.size() == 6);
+        CHECK(code[0].op == BUILD_SLOT);
+        CHECK(code[0].slot == 1);
+        CHECK(code[1].op == BUILD_SLOT);
+        CHECK(code[1].slot == 0);
+        CHECK(code[2].op == BUILD_NODE);
+        CHECK(code[2].type == TokenType::PLUS);
+        CHECK(code[3].op == BUILD_NODE);
+        CHECK(code[3].type == TokenType::MINUS);
+        CHECK(code[3].arity == 1);
+        CHECK(code[4].op == BUILD_LITERAL);
+        CHECK(rule->matcher().literals()[code[4].literal] == "2");
+        CHECK(code[5].op == BUILD_NODE);
+        CHECK(code[5].type == TokenType::STAR);
+    }
+}
+
+TEST_CASE("Pattern matching", "[PatternMatcher:Match]") {
+    TermTable table;
+    MatchState state;
+
+    auto intern = [&](std::string source) {
+        return table.intern(*parseExpression(source));
+    };
+
+    SECTION("Binds variables") {
+        auto rule = parseRule("\"A\" * 1", "\"A\"");
+        CHECK(rule->matcher().match(intern("(2 + 3) * 1"), state));
+        CHECK(TermTable::toString(rule->matcher().build(table, state)) == "(2+3)");
+        CHECK_FALSE(rule->matcher().match(intern("(2 + 3) * 2"), state));
+        CHECK_FALSE(rule->matcher().match(intern("(2 + 3) + 1"), state));
+        CHECK_FALSE(rule->matcher().match(intern("1"), state));
+    }
+
+    SECTION("Repeated variables must agree") {
+        auto rule = parseRule("\"A\" - \"A\"", "0");
+        CHECK(rule->matcher().match(intern("(1 + 2) - (1 + 2)"), state));
+        CHECK_FALSE(rule->matcher().match(intern("(1 + 2) - (2 + 1)"), state));
+    }
+
+    SECTION("Numbers compare by value") {
+        auto rule = parseRule("\"A\" + 0", "\"A\"");
+        CHECK(rule->matcher().match(intern("5 + 0.0"), state));
+        CHECK_FALSE(rule->matcher().match(intern("5 + 0.5"), state));
+
+        RuleIndex index;
+        index.insert(rule.get());
+        CHECK(index.candidates(intern("5 + 0.0")).size() == 1);
+    }
+
+    SECTION("Booleans and strings") {
+        auto rule = parseRule("!true", "false");
+        CHECK(rule->matcher().match(intern("!true"), state));
+        CHECK_FALSE(rule->matcher().match(intern("!false"), state));
+        CHECK(TermTable::toString(rule->matcher().build(table, state)) == "false");
+    }
+
+    SECTION("One matcher serves several states") {
+        auto rule = parseRule("\"A\" + \"B\"", "\"B\" + \"A\"");
+        MatchState other;
+        REQUIRE(rule->matcher().match(intern("1 + 2"), state));
+        REQUIRE(rule->matcher().match(intern("3 + 4"), other));
+        CHECK(TermTable::toString(rule->matcher().build(table, state)) == "(2+1)");
+        CHECK(TermTable::toString(rule->matcher().build(table, other)) == "(4+3)");
+    }
+}
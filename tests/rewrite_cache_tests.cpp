@@ -0,0 +1,168 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/interpreter.h"
+#include "runtime/rewrite_cache.h"
+#include "runtime/rule.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+TEST_CASE("Rewrite cache eviction", "[RewriteCache:LRU]") {
+    TermTable table;
+    const Term *a = table.make(TokenType::NUMBER, "1");
+    const Term *b = table.make(TokenType::NUMBER, "2");
+    const Term *c = table.make(TokenType::NUMBER, "3");
+
+    RewriteCache cache{2};
+    cache.insert(1, a, b);
+    cache.insert(1, b, c);
+    CHECK(cache.find(1, a) == b); // a is now the most recent
+    cache.insert(1, c, a);        // so b is evicted
+
+    CHECK(cache.size() == 2);
+    CHECK(cache.find(1, b) == nullptr);
+    CHECK(cache.find(1, a) == b);
+    CHECK(cache.find(1, c) == a);
+    CHECK(cache.find(2, a) == nullptr); // Other rule
+
+    CHECK(cache.stats().hits == 3);
+    CHECK(cache.stats().misses == 2);
+    CHECK(cache.stats().evictions == 1);
+
+    SECTION("Updating an entry doesn't evict") {
+        cache.insert(1, a, c);
+        CHECK(cache.find(1, a) == c);
+        CHECK(cache.stats().evictions == 1);
+    }
+
+    SECTION("Clearing keeps the statistics") {
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(cache.find(1, a) == nullptr);
+        CHECK(cache.stats().hits == 3);
+    }
+
+    SECTION("Disabled") {
+        cache.setCapacity(0);
+        cache.insert(1, a, b);
+        CHECK(cache.find(1, a) == nullptr);
+        CHECK(cache.size() == 0);
+    }
+}
+
+TEST_CASE("Cached substitution", "[RewriteCache:Substitute]") {
+    TermTable table;
+    RewriteCache cache;
+    ExpressionRewriter cached;
+    cached.setCache(&cache);
+    ExpressionRewriter uncached;
+
+    auto rule = parseRule("\"A\" + 0", "\"A\"");
+
+    SECTION("Same results as without a cache") {
+        for (std::string source :
+             {"(5 + 0) * (7 * 8)", "5 * 1", "((1 * 2) + 0) + 0",
+              "(3 * (4 + 0)) - (3 * (4 + 0))", "(2 * 3) * ((2 * 3) + 0)"}) {
+            auto expression = parseExpression(source);
+            const Term *term = table.intern(*expression);
+            const Term *expected = uncached.substitute(table, term, *rule);
+            CHECK(cached.substitute(table, term, *rule) == expected);
+            // Again, now from the cache
+            CHECK(cached.substitute(table, term, *rule) == expected);
+        }
+    }
+
+    SECTION("Repeated source hits") {
+        auto expression = parseExpression("(5 + 0) * (7 * 8)");
+        const Term *term = table.intern(*expression);
+        cached.substitute(table, term, *rule);
+        size_t hits = cache.stats().hits;
+        cached.substitute(table, term, *rule);
+        CHECK(cache.stats().hits == hits + 1);
+    }
+
+    SECTION("Subterms rewritten before are reused") {
+        auto inner = parseExpression("(7 * 8) * (5 + 0)");
+        cached.substitute(table, table.intern(*inner), *rule);
+
+        auto outer = parseExpression("1 - ((7 * 8) * (5 + 0))");
+        const Term *term = table.intern(*outer);
+        size_t hits = cache.stats().hits;
+        CHECK(TermTable::toString(cached.substitute(table, term, *rule)) ==
+              "(1-((7*8)*5))");
+        CHECK(cache.stats().hits == hits + 1);
+    }
+
+    SECTION("Subterms without a match are skipped") {
+        auto inner = parseExpression("(7 * 8) * 9");
+        cached.substitute(table, table.intern(*inner), *rule);
+
+        auto outer = parseExpression("((7 * 8) * 9) - (1 + 0)");
+        const Term *term = table.intern(*outer);
+        CHECK(TermTable::toString(cached.substitute(table, term, *rule)) ==
+              "(((7*8)*9)-1)");
+    }
+
+    SECTION("Redefined rules don't share entries") {
+        auto other = parseRule("\"A\" + 0", "\"A\" * 1");
+        CHECK(other->id() != rule->id());
+
+        auto expression = parseExpression("5 + 0");
+        const Term *term = table.intern(*expression);
+        CHECK(TermTable::toString(cached.substitute(table, term, *rule)) == "5");
+        CHECK(TermTable::toString(cached.substitute(table, term, *other)) ==
+              "(5*1)");
+    }
+}
+
+TEST_CASE("Interpreter apply cache", "[RewriteCache:Interpreter]") {
+    Lexer lexer{"define zero -> \"A\" + 0 = \"A\";"
+                "apply zero : (1 * 2) + 0;"
+                "apply zero : (1 * 2) + 0;"};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+    interpreter.interpret();
+
+    CHECK(interpreter.result == "(1*2)");
+    CHECK(interpreter.getRewriteCache().stats().hits == 1);
+    CHECK(interpreter.getRewriteCache().size() > 0);
+}
+
+TEST_CASE("Interpreter apply* cache", "[RewriteCache:Interpreter]") {
+    const std::string rules = "define zero -> \"A\" + 0 = \"A\";"
+                              "define one -> \"A\" * 1 = \"A\";";
+
+    SECTION("Same normal forms as without a cache") {
+        for (std::string statement : {"apply* zero, one : ((2 + 0) * 1) * (3 * 1);",
+                                      "apply* : ((2 + 0) * 1) + ((2 * 1) + 0);"}) {
+            Lexer lexer{rules + statement + statement};
+            Parser parser{lexer.tokenize(), lexer.text()};
+            Interpreter cached{parser.parse()};
+            cached.interpret();
+
+            Lexer uncachedLexer{rules + statement};
+            Parser uncachedParser{uncachedLexer.tokenize(), uncachedLexer.text()};
+            Interpreter uncached{uncachedParser.parse()};
+            uncached.setRewriteCacheCapacity(0);
+            uncached.interpret();
+
+            CHECK(cached.result == uncached.result);
+            CHECK(cached.rewrites == uncached.rewrites);
+        }
+    }
+
+    SECTION("Later statements hit") {
+        Lexer lexer{rules + "apply* zero, one : ((2 + 0) * 1) * (3 * 1);"
+                            "apply* zero, one : 5 - ((2 + 0) * 1);"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.interpret();
+
+        CHECK(interpreter.result == "(5-2)");
+        // (2 + 0) and (2 * 1) were rewritten by the first statement
+        CHECK(interpreter.getRewriteCache().stats().hits >= 2);
+    }
+}
@@ -0,0 +1,107 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/environment.h"
+#include "runtime/rule.h"
+#include "runtime/rule_index.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST_CASE("Rule Index", "[RuleIndex]") {
+    TermTable table;
+    RuleIndex index;
+
+    auto zero = parseRule("\"A\" + 0", "\"A\"");
+    auto one = parseRule("\"A\" * 1", "\"A\"");
+    auto commute = parseRule("\"A\" + \"B\"", "\"B\" + \"A\"");
+    auto negate = parseRule("-(-\"A\")", "\"A\"");
+    auto anything = parseRule("\"A\"", "\"A\"");
+    index.insert(zero.get());
+    index.insert(one.get());
+    index.insert(commute.get());
+    index.insert(negate.get());
+
+    auto lookup = [&](std::string source) {
+        auto expression = parseExpression(source);
+        return index.candidates(table.intern(*expression));
+    };
+
+    SECTION("Finds rules by shape") {
+        CHECK(lookup("5 + 0") == std::vector<const Rule *>{zero.get(), commute.get()});
+        CHECK(lookup("(1 * 2) + 3") == std::vector<const Rule *>{commute.get()});
+        CHECK(lookup("(1 + 2) * 1") == std::vector<const Rule *>{one.get()});
+        CHECK(lookup("--(2 + 3)") == std::vector<const Rule *>{negate.get()});
+        CHECK(lookup("-2").empty());
+        CHECK(lookup("2 / 3").empty());
+    }
+
+    SECTION("Wildcard at the root matches everything") {
+        index.insert(anything.get());
+        CHECK(lookup("2 / 3") == std::vector<const Rule *>{anything.get()});
+        CHECK(lookup("5 + 0") ==
+              std::vector<const Rule *>{zero.get(), commute.get(), anything.get()});
+    }
+
+    SECTION("Removed rules are no longer found") {
+        index.remove(zero.get());
+        CHECK(index.size() == 3);
+        CHECK(lookup("5 + 0") == std::vector<const Rule *>{commute.get()});
+    }
+
+    SECTION("Redefining rules doesn't grow the tree") {
+        const size_t nodes = index.nodes();
+        for (int i = 0; i < 100; i++) {
+            auto rule = parseRule("(\"A\" * " + std::to_string(i) + ") + 0", "\"A\"");
+            index.insert(rule.get());
+            CHECK(index.nodes() > nodes);
+            index.remove(rule.get());
+            CHECK(index.nodes() == nodes);
+        }
+        CHECK(lookup("5 + 0") == std::vector<const Rule *>{zero.get(), commute.get()});
+
+        index.remove(zero.get());
+        CHECK(index.nodes() < nodes);
+    }
+
+    SECTION("Reused buffers give the same candidates") {
+        RuleIndex::Scratch scratch;
+        std::vector<const Rule *> rules{anything.get()};
+        for (std::string source : {"5 + 0", "--(2 + 3)", "2 / 3", "((1 + 0) + 0) + 0"}) {
+            auto expression = parseExpression(source);
+            const Term *term = table.intern(*expression);
+            index.candidates(term, rules, scratch);
+            CHECK(rules == index.candidates(term));
+        }
+    }
+
+    SECTION("Only the matching rules among many") {
+        RuleIndex large;
+        std::vector<std::unique_ptr<Rule>> rules;
+        for (int i = 0; i < 1000; i++) {
+            rules.push_back(parseRule("\"A\" * " + std::to_string(i), "\"A\""));
+            large.insert(rules.back().get());
+        }
+
+        auto expression = parseExpression("(1 + 2) * 500");
+        CHECK(large.candidates(table.intern(*expression)) ==
+              std::vector<const Rule *>{rules[500].get()});
+    }
+}
+
+TEST_CASE("Environment keeps the index in sync", "[RuleIndex:Environment]") {
+    TermTable table;
+    Environment environment;
+    environment.addDefinition("zero", parseRule("\"A\" + 0", "\"A\""));
+    environment.addDefinition("zero", parseRule("\"A\" * 0", "0"));
+
+    auto sum = parseExpression("1 + 0");
+    CHECK(environment.snapshot()->candidates(table.intern(*sum)).empty());
+
+    auto product = parseExpression("1 * 0");
+    auto candidates = environment.snapshot()->candidates(table.intern(*product));
+    REQUIRE(candidates.size() == 1);
+    CHECK(candidates[0] == environment.getDefinition("zero").get());
+}
@@ -0,0 +1,193 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/environment.h"
+#include "runtime/interpreter.h"
+#include "runtime/rule.h"
+#include "runtime/rule_library.h"
+#include "runtime/runtime_errors.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+static std::string imagePath() {
+    return (std::filesystem::temp_directory_path() / "carl_rule_library_tests.carlc")
+        .string();
+}
+
+// Writes rules, given as name, pattern and replacement, to the image file
+static std::string writeLibrary(
+    std::vector<std::tuple<std::string, std::string, std::string>> definitions) {
+    std::vector<std::unique_ptr<Rule>> rules;
+    std::vector<std::pair<SymbolId, const Rule *>> library;
+    for (auto &[name, pattern, replacement] : definitions) {
+        rules.push_back(std::make_unique<Rule>(parseExpression(pattern),
+                                               parseExpression(replacement)));
+        library.emplace_back(internSymbol(name), rules.back().get());
+    }
+
+    std::ostringstream image;
+    RuleLibrary::write(image, library);
+    std::ofstream{imagePath(), std::ios::binary} << image.str();
+    return image.str();
+}
+
+static std::string run(Interpreter &interpreter, std::string source) {
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    interpreter.interpret(parser.parse());
+    return interpreter.result;
+}
+
+TEST_CASE("Rule library images", "[RuleLibrary]") {
+    writeLibrary({{"zero", "\"A\" + 0", "\"A\""},
+                  {"swap", "\"A\" * \"B\"", "\"B\" * \"A\""},
+                  {"same", "\"A\" - \"A\"", "0"}});
+    auto library = RuleLibrary::open(imagePath());
+
+    SECTION("Names are found in the image") {
+        REQUIRE(library->size() == 3);
+        CHECK(library->name(1) == "swap");
+        CHECK(library->find("same") == 2);
+        CHECK(library->find("missing") == RuleLibrary::NONE);
+    }
+
+    SECTION("Rules are decoded once, with their matcher") {
+        auto rule = library->rule(library->find("swap"));
+        CHECK(rule == library->rule(library->find("swap")));
+        CHECK(TermTable::toString(rule->pattern()) == "(A*B)");
+        CHECK(TermTable::toString(rule->replacement()) == "(B*A)");
+
+        Rule compiled{parseExpression("\"A\" * \"B\""), parseExpression("\"B\" * \"A\"")};
+        CHECK(rule->matcher().matchInstructions().size() ==
+              compiled.matcher().matchInstructions().size());
+        CHECK(rule->matcher().buildInstructions().size() ==
+              compiled.matcher().buildInstructions().size());
+        CHECK(rule->matcher().slots() == 2);
+    }
+
+    SECTION("Interpreters apply library rules") {
+        Interpreter interpreter;
+        interpreter.loadLibrary(library);
+        CHECK(run(interpreter, "apply swap : 2 * 3;") == "(3*2)");
+        CHECK(run(interpreter, "apply same : (1 + 2) - (1 + 2);") == "0");
+        CHECK(run(interpreter, "apply* : (5 + 0) - (5 + 0);") == "0");
+
+        // Definitions replace library rules of the same name
+        run(interpreter, "define zero -> \"A\" + 0 = 0;");
+        CHECK(run(interpreter, "apply* zero : 7 + 0;") == "0");
+        CHECK(run(interpreter, "apply* : 7 + 0;") == "0");
+    }
+
+    SECTION("Library rules rank before later definitions") {
+        Environment environment;
+        environment.loadLibrary(library);
+        environment.addDefinition("first", std::make_unique<Rule>(
+                                               parseExpression("\"A\" + 0"),
+                                               parseExpression("1")));
+        CHECK(environment.snapshot()->size() == 4);
+        environment.addDefinition("zero", std::make_unique<Rule>(
+                                              parseExpression("\"A\" + 0"),
+                                              parseExpression("2")));
+        CHECK(environment.snapshot()->size() == 4);
+
+        environment.indexLibrary();
+        auto snapshot = environment.snapshot();
+        CHECK(snapshot->size() == 4);
+        TermTable table;
+        auto candidates = snapshot->candidates(table.intern(*parseExpression("3 + 0")));
+        REQUIRE(candidates.size() == 2);
+        CHECK(candidates[0] == snapshot->find(internSymbol("first")));
+        CHECK(candidates[1] == snapshot->find(internSymbol("zero")));
+        CHECK(TermTable::toString(candidates[1]->replacement()) == "2");
+    }
+}
+
+TEST_CASE("Rejected rule libraries", "[RuleLibrary]") {
+    const std::string image = writeLibrary({{"zero", "\"A\" + 0", "\"A\""},
+                                            {"neg", "-(-\"A\")", "\"A\""}});
+    auto rewrite = [](std::string bytes) {
+        std::ofstream{imagePath(), std::ios::binary | std::ios::trunc} << bytes;
+    };
+
+    SECTION("Missing files") {
+        try {
+            RuleLibrary::open(imagePath() + ".missing");
+            FAIL("Expected an error");
+        } catch (const RuleLibraryError &e) {
+            CHECK(e.error_code() == UNREADABLE_LIBRARY);
+        }
+    }
+
+    SECTION("Other files, versions and truncated images") {
+        std::string otherVersion = image;
+        otherVersion[8] ^= 0x7f;
+        for (std::string bytes : {std::string{}, std::string{"define x -> 1 = 2;"},
+                                  otherVersion, image.substr(0, image.size() - 1)}) {
+            rewrite(bytes);
+            try {
+                RuleLibrary::open(imagePath());
+                FAIL("Expected an error");
+            } catch (const RuleLibraryError &e) {
+                CHECK(e.error_code() == INVALID_LIBRARY);
+            }
+        }
+    }
+
+    SECTION("Corrupt images throw instead of crashing") {
+        size_t rejected = 0;
+        for (size_t byte = 0; byte < image.size(); byte++) {
+            std::string corrupt = image;
+            corrupt[byte] ^= 0xff;
+            rewrite(corrupt);
+            try {
+                auto library = RuleLibrary::open(imagePath());
+                for (uint32_t rule = 0; rule < library->size(); rule++) {
+                    library->find(library->name(rule));
+                    library->rule(rule);
+                }
+            } catch (const RuleLibraryError &) {
+                rejected++;
+            }
+        }
+        CHECK(rejected > 0);
+    }
+
+    SECTION("Corrupt rules fail the statement that decodes them") {
+        size_t rejected = 0;
+        for (size_t byte = 0; byte < image.size(); byte++) {
+            std::string corrupt = image;
+            corrupt[byte] ^= 0xff;
+            rewrite(corrupt);
+            std::shared_ptr<const RuleLibrary> library;
+            try {
+                library = RuleLibrary::open(imagePath());
+            } catch (const RuleLibraryError &) {
+                continue;
+            }
+
+            // Only the header is checked so far
+            for (std::string statement : {"apply zero : 1 + 0;", "apply* zero, neg : --(1 + 0);",
+                                          "apply* : --(1 + 0);"}) {
+                Interpreter interpreter;
+                interpreter.loadLibrary(library);
+                try {
+                    run(interpreter, statement);
+                } catch (const RuleLibraryError &e) {
+                    CHECK(e.error_code() == INVALID_LIBRARY);
+                    rejected++;
+                } catch (const RuntimeException &) {
+                    // A corrupt name makes the rule unknown
+                }
+            }
+        }
+        CHECK(rejected > 0);
+    }
+}
@@ -0,0 +1,115 @@
+#include "lexer/line_index.h"
+#include "lexer/statement_reader.h"
+#include "lexer/symbol_table.h"
+#include "runtime/interpreter.h"
+#include "runtime/parse_cache.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> readAll(const std::string &source,
+                                        size_t chunkSize) {
+    std::istringstream input{source};
+    StatementReader reader{input, chunkSize};
+    std::vector<std::string> statements;
+    while (auto statement = reader.next())
+        statements.emplace_back(*statement);
+    return statements;
+}
+
+TEST_CASE("Statement splitting", "[StatementReader:Split]") {
+    // Small chunks so statements straddle chunk boundaries
+    for (size_t chunkSize : {1, 3, 4096}) {
+        SECTION("Plain statements, chunk size " + std::to_string(chunkSize)) {
+            auto statements = readAll("1 + 2;\ndefine x -> \"A\" = 0;", chunkSize);
+            REQUIRE(statements.size() == 2);
+            CHECK(statements[0] == "1 + 2;");
+            CHECK(statements[1] == "\ndefine x -> \"A\" = 0;");
+        }
+
+        SECTION("Strings and comments, chunk size " + std::to_string(chunkSize)) {
+            auto statements = readAll("\"a;b\" + \"c\"; # not; a statement\n2;", chunkSize);
+            REQUIRE(statements.size() == 2);
+            CHECK(statements[0] == "\"a;b\" + \"c\";");
+            CHECK(statements[1] == " # not; a statement\n2;");
+        }
+
+        SECTION("Trailing text, chunk size " + std::to_string(chunkSize)) {
+            CHECK(readAll("1;\n  # done\n", chunkSize).size() == 1);
+
+            auto statements = readAll("1; 2 + ", chunkSize);
+            REQUIRE(statements.size() == 2);
+            CHECK(statements[1] == " 2 + ");
+        }
+    }
+
+    SECTION("Empty input") {
+        CHECK(readAll("", 16).empty());
+    }
+}
+
+TEST_CASE("Statement positions", "[StatementReader:Position]") {
+    std::istringstream input{"1;\n22;\n\n  333; 4;"};
+    StatementReader reader{input, 2};
+
+    REQUIRE(reader.next());
+    CHECK(reader.offset() == 0);
+    CHECK(reader.line() == 0);
+
+    REQUIRE(reader.next());
+    CHECK(reader.offset() == 2);
+    CHECK(reader.line() == 0);
+    CHECK(reader.column() == 2);
+
+    auto third = reader.next();
+    REQUIRE(third);
+    CHECK(reader.offset() == 6);
+    // "333" as if the whole input had been indexed
+    LineIndex lines{*third, reader.line(), reader.column()};
+    LineIndex whole{"1;\n22;\n\n  333; 4;"};
+    CHECK(lines.describe(4, 3) == whole.describe(10, 3));
+
+    auto fourth = reader.next();
+    REQUIRE(fourth);
+    LineIndex fourthLines{*fourth, reader.line(), reader.column()};
+    CHECK(fourthLines.describe(1, 1) == whole.describe(15, 1));
+
+    CHECK_FALSE(reader.next());
+}
+
+TEST_CASE("Streaming distinct literals", "[StatementReader:Stream]") {
+    // As `carl file` runs them, every statement with literals of its own
+    std::string source = "define r -> \"A\" + 1 = \"A\";";
+    for (int i = 0; i < 40000; i++) {
+        const std::string n = std::to_string(i);
+        source += n + " * 2 + 1;\napply r: \"s" + n + "\" + 1;\n";
+    }
+    std::istringstream input{source};
+    StatementReader reader{input};
+    ParseCache programs{0};
+    Interpreter interpreter;
+
+    std::streambuf *output = std::cout.rdbuf(nullptr);
+    size_t statements = 0;
+    size_t symbols = 0;
+    size_t terms = 0;
+    while (auto statement = reader.next()) {
+        interpreter.interpret(programs.parse(*statement));
+        // Past the definition only literals are new
+        if (statements++ == 0)
+            symbols = SymbolTable::global().size();
+        terms = std::max(terms, interpreter.getTerms().size());
+    }
+    std::cout.rdbuf(output);
+
+    CHECK(statements == 80001);
+    CHECK(interpreter.result == "s39999");
+    CHECK(SymbolTable::global().size() == symbols);
+    CHECK(programs.size() == 0);
+    // Cleared at least once, each apply adding a few terms
+    CHECK(interpreter.getTerms().size() < terms);
+    CHECK(terms < TERM_TABLE_LIMIT + 8);
+}
@@ -0,0 +1,106 @@
+#include "carl_stats.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/interpreter.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static uint64_t counted(StatCounter counter) {
+    return Stats::snapshot().counters[counter];
+}
+
+// Records statistics until the end of the scope
+struct EnabledStats {
+    EnabledStats() { Stats::setEnabled(true); }
+    ~EnabledStats() { Stats::setEnabled(false); }
+};
+
+TEST_CASE("Statistics", "[Stats]") {
+    if (!Stats::compiledIn()) {
+        WARN("Built without CARL_STATS");
+        return;
+    }
+
+    SECTION("Counters count the work done") {
+        EnabledStats enabled;
+        const uint64_t tokens = counted(STAT_TOKENS);
+        const uint64_t statements = counted(STAT_STATEMENTS);
+        const uint64_t binaries = counted(STAT_VISIT_BINARY);
+
+        Lexer lexer{"1 + 2 * 3; 4;"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.setExecutionMode(EXECUTE_TREE_WALK);
+        interpreter.interpret();
+
+        CHECK(counted(STAT_TOKENS) - tokens == 9);
+        CHECK(counted(STAT_STATEMENTS) - statements == 2);
+        CHECK(counted(STAT_VISIT_BINARY) - binaries == 2);
+    }
+
+    SECTION("Lexers intern each identifier once") {
+        EnabledStats enabled;
+        const uint64_t interns = counted(STAT_SYMBOL_INTERNS);
+        Lexer{"apply x : 1; apply x : 2; apply y : \"s\"; apply x : 3;"}.tokenize();
+        CHECK(counted(STAT_SYMBOL_INTERNS) - interns == 2);
+    }
+
+    SECTION("Nothing is counted while disabled") {
+        const uint64_t tokens = counted(STAT_TOKENS);
+        Lexer{"1 + 2;"}.tokenize();
+        CHECK(counted(STAT_TOKENS) == tokens);
+    }
+
+    SECTION("Rule tries count apply and apply*") {
+        EnabledStats enabled;
+        const uint64_t tries = counted(STAT_RULE_TRIES);
+        const uint64_t rewrites = counted(STAT_RULE_REWRITES);
+
+        Lexer lexer{"define zero -> \"A\" + 0 = \"A\";"
+                    "apply zero : (1 * 2) + 0;"
+                    "apply* zero : (3 + 0) + 0;"};
+        Parser parser{lexer.tokenize(), lexer.text()};
+        Interpreter interpreter{parser.parse()};
+        interpreter.interpret();
+
+        CHECK(counted(STAT_RULE_REWRITES) - rewrites == 3);
+        CHECK(counted(STAT_RULE_TRIES) - tries > counted(STAT_RULE_REWRITES) - rewrites);
+    }
+
+    SECTION("Timers only run while enabled") {
+        const uint64_t lexed = Stats::snapshot().calls[STAT_LEX];
+        Lexer{"1;"}.tokenize();
+        CHECK(Stats::snapshot().calls[STAT_LEX] == lexed);
+
+        Stats::setEnabled(true);
+        Lexer{"1;"}.tokenize();
+        Stats::setEnabled(false);
+        CHECK(Stats::snapshot().calls[STAT_LEX] == lexed + 1);
+    }
+
+    SECTION("Counts of exited threads are kept") {
+        EnabledStats enabled;
+        const uint64_t tokens = counted(STAT_TOKENS);
+        std::thread{[] { Lexer{"1 + 1;"}.tokenize(); }}.join();
+        CHECK(counted(STAT_TOKENS) - tokens == 5); // With the end of file
+    }
+
+    SECTION("Reports name every statistic") {
+        Stats::Snapshot snapshot = Stats::snapshot();
+        std::ostringstream table;
+        Stats::printTable(table, snapshot);
+        std::ostringstream json;
+        Stats::printJson(json, snapshot);
+
+        for (std::string_view name : StatTimerNames) {
+            CHECK(table.str().find(name) != std::string::npos);
+            CHECK(json.str().find("\"" + std::string{name} + "\"") != std::string::npos);
+        }
+        for (std::string_view name : StatCounterNames) {
+            CHECK(table.str().find(name) != std::string::npos);
+            CHECK(json.str().find("\"" + std::string{name} + "\"") != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "runtime/carl_object.h"
+#include "runtime/string_pool.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <string>
+
+TEST_CASE("String values", "[String:Value]") {
+    SECTION("Short strings are inline") {
+        const size_t liveBefore = StringPool::local().liveBlocks();
+        Value value = Value::string("12345678");
+        CHECK(value.type == ValueType::VALUE_SHORT_STRING);
+        CHECK(IS_STRING(value));
+        CHECK(value.asString() == "12345678");
+        CHECK(value.toString() == "12345678");
+        CHECK(StringPool::local().liveBlocks() == liveBefore);
+        value.dispose();
+    }
+
+    SECTION("Long strings are pooled objects") {
+        const size_t liveBefore = StringPool::local().liveBlocks();
+        Value value = Value::string("123456789");
+        REQUIRE(value.type == ValueType::VALUE_OBJ);
+        CHECK(IS_STRING(value));
+        CHECK(value.asString() == "123456789");
+        CHECK(strcmp(reinterpret_cast<ObjString *>(value.obj)->chars(),
+                     "123456789") == 0);
+        CHECK(StringPool::local().liveBlocks() == liveBefore + 1);
+        value.dispose();
+        CHECK(StringPool::local().liveBlocks() == liveBefore);
+    }
+
+    SECTION("Concatenation") {
+        Value shortResult = Value::string("abc", "def");
+        CHECK(shortResult.type == ValueType::VALUE_SHORT_STRING);
+        CHECK(shortResult.asString() == "abcdef");
+
+        Value longResult = Value::string("Hello ", "World!");
+        CHECK(longResult.type == ValueType::VALUE_OBJ);
+        CHECK(longResult.asString() == "Hello World!");
+        longResult.dispose();
+
+        Value empty = Value::string("");
+        CHECK(empty.asString().empty());
+    }
+
+    SECTION("Copies are independent") {
+        Value original = Value::string("a longer string");
+        Value copy = original.copy();
+        CHECK(copy.obj != original.obj);
+        original.dispose();
+        CHECK(copy.asString() == "a longer string");
+        copy.dispose();
+    }
+}
+
+TEST_CASE("String pool", "[String:Pool]") {
+    StringPool &pool = StringPool::local();
+
+    SECTION("Freed blocks are reused") {
+        void *first = pool.allocate(40);
+        pool.deallocate(first, 40);
+        // Same size class
+        void *second = pool.allocate(60);
+        CHECK(second == first);
+        pool.deallocate(second, 60);
+    }
+
+    SECTION("Memory does not grow with churn") {
+        Value warmup = Value::string(std::string(100, 'x'));
+        warmup.dispose();
+        const size_t reserved = pool.bytesReserved();
+
+        for (int i = 0; i < 100000; i++) {
+            Value value = Value::string(std::string(100, 'x'), std::to_string(i));
+            value.dispose();
+        }
+        CHECK(pool.bytesReserved() == reserved);
+    }
+
+    SECTION("Large strings bypass the pool") {
+        const size_t reserved = pool.bytesReserved();
+        Value value = Value::string(std::string(StringPool::MAX_CLASS_SIZE * 2, 'x'));
+        CHECK(value.asString().size() == StringPool::MAX_CLASS_SIZE * 2);
+        CHECK(pool.bytesReserved() == reserved);
+        value.dispose();
+    }
+}
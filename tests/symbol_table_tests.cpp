@@ -0,0 +1,84 @@
+#include "lexer/lexer.h"
+#include "lexer/symbol_table.h"
+#include "lexer/token.h"
+#include "parser/expression.h"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Symbol interning", "[SymbolTable:Intern]") {
+    SECTION("Same text, same id") {
+        SymbolId a = internSymbol("symbol-table-test");
+        SymbolId b = internSymbol(std::string{"symbol-table-"} + "test");
+        CHECK(a == b);
+        CHECK(a != internSymbol("symbol-table-other"));
+        CHECK(symbolName(a) == "symbol-table-test");
+    }
+
+    SECTION("Empty string is id 0") {
+        CHECK(internSymbol("") == SymbolId{});
+        CHECK(symbolName(SymbolId{}).empty());
+    }
+
+    SECTION("Identifiers share ids, literals aren't interned") {
+        Lexer lexer{"define x -> \"A\" + 1 = \"A\"; apply x: \"A\" + 1;"};
+        auto tokens = lexer.tokenize();
+        // Both identifiers
+        CHECK(tokens[1].symbol() == tokens[10].symbol());
+        CHECK(tokens[1].literal() == "x");
+        CHECK(tokens[3].symbol() == SymbolId{});
+        CHECK(tokens[3].text(lexer.text()) == "A");
+    }
+
+    SECTION("Lexing literals doesn't grow the table") {
+        std::string source;
+        for (int i = 0; i < 1000; i++)
+            source += std::to_string(i) + " + \"s" + std::to_string(i) + "\";";
+        const size_t before = SymbolTable::global().size();
+        Lexer lexer{source};
+        lexer.tokenize();
+        CHECK(SymbolTable::global().size() == before);
+    }
+
+    SECTION("Repeated text is stored once") {
+        const size_t before = SymbolTable::global().size();
+        for (int i = 0; i < 1000; i++)
+            Token(TokenType::STRING, 0, 1, "repeated-variable");
+        CHECK(SymbolTable::global().size() == before + 1);
+    }
+
+    SECTION("Concurrent interning agrees") {
+        std::vector<std::vector<SymbolId>> ids(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < ids.size(); t++) {
+            threads.emplace_back([&ids, t] {
+                for (int i = 0; i < 500; i++)
+                    ids[t].push_back(internSymbol("concurrent-" + std::to_string(i)));
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        for (size_t t = 1; t < ids.size(); t++)
+            CHECK(ids[t] == ids[0]);
+        CHECK(symbolName(ids[0][42]) == "concurrent-42");
+    }
+
+    SECTION("Names stay readable while others are interned") {
+        // Thousands of symbols fill several chunks of the table
+        std::vector<SymbolId> ids;
+        for (int i = 0; i < 5000; i++)
+            ids.push_back(internSymbol("lookup-" + std::to_string(i)));
+
+        std::thread writer{[] {
+            for (int i = 0; i < 5000; i++)
+                internSymbol("lookup-writer-" + std::to_string(i));
+        }};
+        for (int round = 0; round < 4; round++)
+            for (size_t i = 0; i < ids.size(); i++)
+                REQUIRE(symbolName(ids[i]) == "lookup-" + std::to_string(i));
+        writer.join();
+        CHECK(symbolName(internSymbol("lookup-writer-4999")) == "lookup-writer-4999");
+    }
+}
@@ -0,0 +1,150 @@
+#include "lexer/lexer.h"
+#include "lexer/symbol_table.h"
+#include "parser/ast_printer.h"
+#include "parser/parser.h"
+#include "runtime/expressionrewriter.h"
+#include "runtime/rule.h"
+#include "runtime/runtime_errors.h"
+#include "runtime/term.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+TEST_CASE("Term interning", "[Term:Interning]") {
+    TermTable table;
+
+    SECTION("Identical subtrees are shared") {
+        auto expression = parseExpression("(1 + 2) * (1 + 2)");
+        const Term *term = table.intern(*expression);
+
+        CHECK(term->left() == term->right());
+        // 1, 2, (1 + 2) and the product
+        CHECK(table.size() == 4);
+    }
+
+    SECTION("Equality is identity") {
+        auto a = parseExpression("-1 * (2 + 3)");
+        auto b = parseExpression("-1 * (2 + 3)");
+        auto c = parseExpression("-1 * (2 + 4)");
+        CHECK(table.intern(*a) == table.intern(*b));
+        CHECK(table.intern(*a) != table.intern(*c));
+    }
+
+    SECTION("Hashes are structural") {
+        TermTable other;
+        auto expression = parseExpression("1 + 2 * 3");
+        const Term *term = table.intern(*expression);
+        const Term *otherTerm = other.intern(*expression);
+        CHECK(term != otherTerm);
+        CHECK(term->hash() == otherTerm->hash());
+        CHECK(table.import(otherTerm) == term);
+    }
+
+    SECTION("Round trips through expressions") {
+        auto expression = parseExpression("-(1 + 2) * 3 - 4");
+        const Term *term = table.intern(*expression);
+
+        AstPrinter printer;
+        auto copy = TermTable::toExpression(term);
+        CHECK(printer.print(*copy) == printer.print(*expression));
+        CHECK(TermTable::toString(term) == expression->toString());
+    }
+
+    SECTION("Literals are kept by the table, not the symbol table") {
+        const size_t symbols = SymbolTable::global().size();
+        for (int i = 0; i < 1000; i++)
+            table.make(TokenType::NUMBER, "1" + std::to_string(i));
+        CHECK(table.make(TokenType::NUMBER, "1999")->number() == 1999);
+        CHECK(SymbolTable::global().size() == symbols);
+
+        table.clear();
+        CHECK(table.make(TokenType::STRING, "A")->literal() == "A");
+        CHECK(table.size() == 1);
+    }
+}
+
+TEST_CASE("Term rewriting", "[Term:Rewriting]") {
+    TermTable table;
+    ExpressionRewriter rewriter;
+
+    SECTION("Replaces the first match and shares the rest") {
+        auto rule = parseRule("\"A\" + 0", "\"A\"");
+        auto source = parseExpression("(5 + 0) * (7 * 8)");
+        const Term *term = table.intern(*source);
+
+        const Term *result = rewriter.substitute(table, term, *rule);
+        CHECK(TermTable::toString(result) == "(5*(7*8))");
+        // Untouched subtrees are the same nodes
+        CHECK(result->right() == term->right());
+    }
+
+    SECTION("Returns the source when nothing matches") {
+        auto rule = parseRule("\"A\" + 0", "\"A\"");
+        auto source = parseExpression("5 * 1");
+        const Term *term = table.intern(*source);
+        CHECK(rewriter.substitute(table, term, *rule) == term);
+    }
+
+    SECTION("Variables bind whole subtrees") {
+        auto rule = parseRule("\"A\" + (\"B\" * \"C\")", "\"A\" * \"B\" * \"C\"");
+        auto source = parseExpression("1 + ((2 * 3) * 4)");
+        const Term *result =
+            rewriter.substitute(table, table.intern(*source), *rule);
+        CHECK(TermTable::toString(result) == "((1*(2*3))*4)");
+    }
+
+    SECTION("Repeated variables must bind equal subtrees") {
+        auto rule = parseRule("\"A\" - \"A\"", "0");
+
+        auto same = parseExpression("(9 * 2) - (9 * 2)");
+        CHECK(TermTable::toString(
+                  rewriter.substitute(table, table.intern(*same), *rule)) ==
+              "0");
+
+        auto different = parseExpression("(9 * 2) - (9 * 3)");
+        const Term *term = table.intern(*different);
+        CHECK(rewriter.substitute(table, term, *rule) == term);
+    }
+}
+
+TEST_CASE("Term normalization", "[Term:Normalization]") {
+    TermTable table;
+    ExpressionRewriter rewriter;
+    auto zero = parseRule("\"A\" + 0", "\"A\"");
+    auto one = parseRule("\"A\" * 1", "\"A\"");
+    auto annihilate = parseRule("\"A\" * 0", "0");
+    const std::vector<const Rule *> rules{zero.get(), one.get(), annihilate.get()};
+
+    SECTION("Rewrites until no rule applies") {
+        auto source = parseExpression("((5 + 0) * 1) + (3 * 0)");
+        NormalizeResult result =
+            rewriter.normalize(table, table.intern(*source), rules, 100);
+        CHECK(TermTable::toString(result.term) == "5");
+        CHECK(result.rewrites == 4);
+    }
+
+    SECTION("Shared subterms are normalized once") {
+        auto source = parseExpression("(2 + 0) * (2 + 0)");
+        NormalizeResult result =
+            rewriter.normalize(table, table.intern(*source), rules, 100);
+        CHECK(TermTable::toString(result.term) == "(2*2)");
+        CHECK(result.rewrites == 1);
+    }
+
+    SECTION("Normal forms are returned unchanged") {
+        auto source = parseExpression("1 + 2");
+        const Term *term = table.intern(*source);
+        NormalizeResult result = rewriter.normalize(table, term, rules, 100);
+        CHECK(result.term == term);
+        CHECK(result.rewrites == 0);
+    }
+
+    SECTION("Stops at the budget") {
+        auto commute = parseRule("\"A\" + \"B\"", "\"B\" + \"A\"");
+        auto source = parseExpression("1 + 2");
+        CHECK_THROWS_AS(rewriter.normalize(table, table.intern(*source),
+                                           {commute.get()}, 10),
+                        RewriteLimitExceeded);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "lexer/lexer.h"
+#include "parser/expression.h"
+#include "parser/parser.h"
+#include "parser/statement.h"
+#include "runtime/rule.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+inline std::vector<std::unique_ptr<Statement>> parseStatements(const std::string &source) {
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    return parser.parse();
+}
+
+// The expression of source parsed as a single expression statement
+inline std::unique_ptr<Expression> parseExpression(const std::string &source) {
+    auto statements = parseStatements(source + ";");
+    auto *statement = dynamic_cast<ExpressionStatement *>(statements[0].get());
+    return statement->borrowExpression();
+}
+
+inline std::unique_ptr<Rule> parseRule(const std::string &pattern,
+                                       const std::string &replacement) {
+    return std::make_unique<Rule>(parseExpression(pattern), parseExpression(replacement));
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/chunk.h"
+#include "runtime/compiler.h"
+#include "runtime/interpreter.h"
+#include "runtime/runtime_errors.h"
+#include "runtime/vm.h"
+#include "test_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <memory>
+#include <string>
+
+TEST_CASE("Compiler", "[VM:Compiler]") {
+    Compiler compiler;
+
+    SECTION("Emits postfix instruction stream") {
+        auto expression = parseExpression("1 + 2 * 3");
+        Chunk chunk = compiler.compile(*expression);
+
+        const std::vector<uint8_t> expected = {
+            OP_CONSTANT, 0, OP_CONSTANT, 1, OP_CONSTANT, 2,
+            OP_MULTIPLY, OP_ADD, OP_RETURN,
+        };
+        CHECK(chunk.code() == expected);
+        CHECK(chunk.constants().size() == 3);
+        CHECK(chunk.maxStackDepth() == 3);
+    }
+
+    SECTION("Deduplicates number constants") {
+        auto expression = parseExpression("2 + 2 + 2 + 2");
+        Chunk chunk = compiler.compile(*expression);
+        CHECK(chunk.constants().size() == 1);
+        CHECK(chunk.maxStackDepth() == 2);
+    }
+
+    SECTION("Uses long constants past 256 entries") {
+        std::string source{"0"};
+        for (int i = 1; i < 300; i++)
+            source += " + " + std::to_string(i);
+
+        auto expression = parseExpression(source);
+        Chunk chunk = compiler.compile(*expression);
+        CHECK(chunk.constants().size() == 300);
+
+        VM vm;
+        Value result = vm.run(chunk);
+        REQUIRE(result.type == ValueType::VALUE_NUMBER);
+        CHECK(result.number == 299.0 * 300.0 / 2.0);
+    }
+
+    SECTION("Rejects chunks with too many constants") {
+        Compiler small{3};
+        CHECK(small.compile(*parseExpression("1 + 2 + 3 + 1")).constants().size() == 3);
+        auto expression = parseExpression("1 + 2 + 3 + 4");
+        try {
+            small.compile(*expression);
+            FAIL("Expected too many constants");
+        } catch (const TooManyConstants &e) {
+            CHECK(e.error_code() == RuntimeError::TOO_MANY_CONSTANTS);
+        }
+        // The compiler is usable again afterwards
+        CHECK(small.compile(*parseExpression("\"a\" + \"b\"")).constants().size() == 2);
+    }
+}
+
+TEST_CASE("VM matches the tree walker", "[VM:Parity]") {
+    const char *programs[] = {
+        "1 + 2 * 3 - 4 / 8;",
+        "-(5 - 10) * -2;",
+        "!!!true;",
+        "((((1 + 2) + 3) + 4) + 5) * (5 - (4 - (3 - (2 - 1))));",
+    };
+
+    for (const char *program : programs) {
+        Lexer treeLexer{program};
+        Parser treeParser{treeLexer.tokenize(), treeLexer.text()};
+        Interpreter treeWalker{treeParser.parse()};
+        treeWalker.setExecutionMode(EXECUTE_TREE_WALK);
+
+        Lexer vmLexer{program};
+        Parser vmParser{vmLexer.tokenize(), vmLexer.text()};
+        Interpreter bytecode{vmParser.parse()};
+        bytecode.setExecutionMode(EXECUTE_BYTECODE);
+
+        auto expected = treeWalker.interpret();
+        auto actual = bytecode.interpret();
+        REQUIRE(expected.has_value());
+        REQUIRE(actual.has_value());
+        CHECK(actual->type == expected->type);
+        CHECK(actual->number == expected->number);
+
+        // Re-running reuses the compiled chunk
+        auto again = bytecode.interpret();
+        CHECK(again->number == expected->number);
+    }
+}
+
+TEST_CASE("VM strings", "[VM:Strings]") {
+    Lexer lexer{"\"Hello \" + \"World\" + \"!\";"};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+
+    for (int i = 0; i < 2; i++) {
+        auto res = interpreter.interpret();
+        REQUIRE(IS_STRING(res.value()));
+        CHECK(strcmp(reinterpret_cast<ObjString *>(res.value().obj)->chars(),
+                     "Hello World!") == 0);
+        res.value().dispose();
+    }
+}
+
+TEST_CASE("VM type mismatch keeps the operator location", "[VM:Errors]") {
+    std::string source{"1 + \"str\";"};
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+
+    try {
+        interpreter.interpret();
+        FAIL("Expected a type mismatch");
+    } catch (const TypeMismatch &e) {
+        CHECK(e.error_code() == RuntimeError::TYPE_MISMATCH);
+        CHECK(e.what(source).starts_with("0:2 - 0:3"));
+    }
+}
+
+TEST_CASE("Operators without an instruction are internal errors", "[VM:Errors]") {
+    std::string source{"1;\n1 == 2;"};
+    Lexer lexer{source};
+    Parser parser{lexer.tokenize(), lexer.text()};
+    Interpreter interpreter{parser.parse()};
+    interpreter.setExecutionMode(EXECUTE_BYTECODE);
+
+    try {
+        interpreter.interpret();
+        FAIL("Expected an internal error");
+    } catch (const InternalError &e) {
+        CHECK(e.error_code() == RuntimeError::INTERNAL_ERROR);
+        CHECK(e.what(source).starts_with("1:3 - 1:5"));
+    }
+}